@@ -0,0 +1,225 @@
+// Viewer scroll/zoom frame-timing benchmark.
+//
+// The benchmark opens each document in a PdfViewer, drives scripted scrolls (flings), zooms and page jumps
+// through PdfViewerController and records frame build/raster times along with the viewer's render-queue
+// depth and cache hit rates (PdfViewerController.renderStats).
+//
+// Run it on Linux desktop with the profile build to get meaningful frame timings:
+//
+// ```
+// flutter run --profile -d linux -t lib/benchmark.dart \
+//   --dart-define=PDFRX_BENCH_DOCS=/path/to/large.pdf,https://example.com/real.pdf \
+//   --dart-define=PDFRX_BENCH_OUTPUT=bench_output.json
+// ```
+//
+// - PDFRX_BENCH_DOCS: comma separated list of documents; file paths, http(s) URLs or `asset:NAME`
+//   (defaults to `asset:assets/hello.pdf`)
+// - PDFRX_BENCH_OUTPUT: file path to write the JSON report to; the report is always written to stdout
+//   in a single line prefixed with `PDFRX_BENCH_RESULT:`
+// - PDFRX_BENCH_SEED: random seed for page jumps (defaults to 1)
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:math';
+
+import 'package:flutter/material.dart';
+import 'package:flutter/scheduler.dart';
+import 'package:pdfrx/pdfrx.dart';
+
+const _docs = String.fromEnvironment('PDFRX_BENCH_DOCS',
+    defaultValue: 'asset:assets/hello.pdf');
+const _output = String.fromEnvironment('PDFRX_BENCH_OUTPUT');
+const _seed = int.fromEnvironment('PDFRX_BENCH_SEED', defaultValue: 1);
+
+void main() {
+  runApp(const BenchmarkApp());
+}
+
+class BenchmarkApp extends StatefulWidget {
+  const BenchmarkApp({super.key});
+
+  @override
+  State<BenchmarkApp> createState() => _BenchmarkAppState();
+}
+
+class _BenchmarkAppState extends State<BenchmarkApp> {
+  final _sources = _docs.split(',').where((s) => s.isNotEmpty).toList();
+  final _results = <Map<String, Object?>>[];
+  final _timings = <FrameTiming>[];
+  int _index = 0;
+  PdfViewerController? _controller;
+
+  @override
+  void initState() {
+    super.initState();
+    SchedulerBinding.instance.addTimingsCallback(_onTimings);
+    WidgetsBinding.instance.addPostFrameCallback((_) => _run());
+  }
+
+  @override
+  void dispose() {
+    SchedulerBinding.instance.removeTimingsCallback(_onTimings);
+    super.dispose();
+  }
+
+  void _onTimings(List<FrameTiming> timings) => _timings.addAll(timings);
+
+  Future<void> _run() async {
+    for (_index = 0; _index < _sources.length; _index++) {
+      final controller = PdfViewerController();
+      setState(() => _controller = controller);
+      final source = _sources[_index];
+      final openTime = Stopwatch()..start();
+      if (!await _waitUntil(() => controller.isReady,
+          timeout: const Duration(minutes: 2))) {
+        _results.add({'source': source, 'error': 'timeout on loading'});
+        continue;
+      }
+      openTime.stop();
+      await _settle();
+
+      final phases = <String, Object?>{};
+      phases['fling'] = await _measure(controller, () => _fling(controller));
+      phases['zoom'] = await _measure(controller, () => _zoom(controller));
+      phases['pageJump'] =
+          await _measure(controller, () => _pageJump(controller));
+      _results.add({
+        'source': source,
+        'pageCount': controller.pages.length,
+        'openTimeUs': openTime.elapsedMicroseconds,
+        'phases': phases,
+      });
+    }
+
+    final report = jsonEncode({
+      'timestamp': DateTime.now().toIso8601String(),
+      'platform': Platform.operatingSystem,
+      'seed': _seed,
+      'documents': _results,
+    });
+    stdout.writeln('PDFRX_BENCH_RESULT:$report');
+    if (_output.isNotEmpty) {
+      await File(_output).writeAsString(report);
+    }
+    exit(0);
+  }
+
+  /// Run [scenario] and collect the frame timings and render statistics during the run.
+  Future<Map<String, Object?>> _measure(
+      PdfViewerController controller, Future<void> Function() scenario) async {
+    await _settle();
+    _timings.clear();
+    controller.renderStats.reset();
+    final sw = Stopwatch()..start();
+    await scenario();
+    sw.stop();
+    // frame timings are reported in batches; wait for the last batch
+    await _settle();
+    return {
+      'durationUs': sw.elapsedMicroseconds,
+      'frames': _summarizeFrames(_timings),
+      'render': controller.renderStats.toJson(),
+    };
+  }
+
+  /// Scroll through the document in quick successive animated steps.
+  Future<void> _fling(PdfViewerController controller) async {
+    for (int dir = 1; dir >= -1; dir -= 2) {
+      for (int i = 0; i < 30; i++) {
+        final pos = controller.centerPosition;
+        final dy = controller.visibleRect.height * 0.8 * dir;
+        await controller.goTo(
+          controller.calcMatrixFor(pos.translate(0, dy)),
+          duration: const Duration(milliseconds: 80),
+        );
+      }
+    }
+  }
+
+  /// Zoom up to the maximum and back down again repeatedly.
+  Future<void> _zoom(PdfViewerController controller) async {
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 4; j++) {
+        await controller.zoomUp();
+        await _delay(const Duration(milliseconds: 250));
+      }
+      for (int j = 0; j < 4; j++) {
+        await controller.zoomDown();
+        await _delay(const Duration(milliseconds: 250));
+      }
+    }
+  }
+
+  /// Jump to pseudo-random pages (deterministic by [_seed]).
+  Future<void> _pageJump(PdfViewerController controller) async {
+    final random = Random(_seed);
+    final pageCount = controller.pages.length;
+    for (int i = 0; i < 20; i++) {
+      await controller.goToPage(pageNumber: random.nextInt(pageCount) + 1);
+      await _delay(const Duration(milliseconds: 300));
+    }
+  }
+
+  static Map<String, Object?> _summarizeFrames(List<FrameTiming> timings) {
+    const budget = Duration(microseconds: 16667);
+    List<int> us(Duration Function(FrameTiming t) f) =>
+        timings.map((t) => f(t).inMicroseconds).toList()..sort();
+    Map<String, Object?> stats(List<int> values) => {
+          'p50': _percentile(values, 0.5),
+          'p90': _percentile(values, 0.9),
+          'p99': _percentile(values, 0.99),
+          'max': values.isEmpty ? 0 : values.last,
+        };
+    return {
+      'count': timings.length,
+      'overBudget': timings.where((t) => t.totalSpan > budget).length,
+      'buildUs': stats(us((t) => t.buildDuration)),
+      'rasterUs': stats(us((t) => t.rasterDuration)),
+      'totalUs': stats(us((t) => t.totalSpan)),
+    };
+  }
+
+  static int _percentile(List<int> sorted, double p) {
+    if (sorted.isEmpty) return 0;
+    return sorted[min(sorted.length - 1, (sorted.length * p).floor())];
+  }
+
+  static Future<void> _delay(Duration duration) => Future.delayed(duration);
+
+  Future<void> _settle() => _delay(const Duration(milliseconds: 500));
+
+  static Future<bool> _waitUntil(bool Function() condition,
+      {required Duration timeout}) async {
+    final sw = Stopwatch()..start();
+    while (!condition()) {
+      if (sw.elapsed > timeout) return false;
+      await _delay(const Duration(milliseconds: 50));
+    }
+    return true;
+  }
+
+  Widget _buildViewer(String source, PdfViewerController controller) {
+    final key = ValueKey(_index);
+    if (source.startsWith('asset:')) {
+      return PdfViewer.asset(source.substring(6),
+          key: key, controller: controller);
+    }
+    if (source.startsWith('http://') || source.startsWith('https://')) {
+      return PdfViewer.uri(Uri.parse(source), key: key, controller: controller);
+    }
+    return PdfViewer.file(source, key: key, controller: controller);
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final controller = _controller;
+    return MaterialApp(
+      home: Scaffold(
+        appBar: AppBar(title: const Text('Pdfrx benchmark')),
+        body: controller == null || _index >= _sources.length
+            ? const Center(child: CircularProgressIndicator())
+            : _buildViewer(_sources[_index], controller),
+      ),
+    );
+  }
+}
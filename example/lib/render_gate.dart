@@ -0,0 +1,276 @@
+// Render correctness + performance regression gate over a PDF corpus.
+//
+// The gate renders every page of every PDF in a corpus directory through [PdfDocument]/[PdfPage.render] (and thus
+// through the native interop layer), compares the results against golden images with a perceptual tolerance and
+// checks per-page render time and per-document peak memory growth against a stored baseline.
+//
+// Corpus directory layout (see render_corpus/ for the checked-in corpus):
+//
+// ```
+// render_corpus/
+//   vector.pdf, images.pdf, cjk.pdf, forms.pdf, encrypted.pdf, ...
+//   corpus.json        (optional) per-document options: {"encrypted.pdf": {"password": "secret"}}
+//   goldens/           golden PNGs; goldens/<document>/<page>.png
+//   baseline.json      per-page render time and per-document peak memory baseline (not checked in)
+// ```
+//
+// The timings and memory depend on the machine, so the baseline is not checked in; it is recorded by `--baseline` on
+// the same machine before the change to be checked (CI records it on the base commit of the push or pull request).
+// The documents without a baseline are reported but not checked for performance.
+//
+// tool/render_gate.sh builds and runs the gate over render_corpus/:
+//
+// ```
+// tool/render_gate.sh             # check
+// tool/render_gate.sh --baseline  # record baseline.json only (before the change)
+// tool/render_gate.sh --update    # refresh goldens and baseline.json
+// ```
+//
+// or run it directly:
+//
+// ```
+// flutter run --release -d linux -t lib/render_gate.dart --dart-define=PDFRX_GATE_CORPUS=render_corpus \
+//   [--dart-define=PDFRX_GATE_UPDATE=true|baseline]
+// ```
+//
+// The process exits with 1 if any page regressed; every regression is reported on a line prefixed with
+// `PDFRX_GATE_FAIL:` telling the document, the page and by how much it regressed.
+import 'dart:convert';
+import 'dart:io';
+import 'dart:math';
+import 'dart:ui' as ui;
+
+import 'package:flutter/material.dart';
+import 'package:pdfrx/pdfrx.dart';
+
+const _corpus =
+    String.fromEnvironment('PDFRX_GATE_CORPUS', defaultValue: 'render_corpus');
+
+/// `true` to refresh goldens and baseline; `baseline` to refresh the baseline only.
+const _update = String.fromEnvironment('PDFRX_GATE_UPDATE');
+
+/// Rendering scale (relative to 72-dpi).
+const _scale = 2.0;
+
+/// Per-channel difference (0-255, luminance weighted) that is regarded as "visibly different".
+const _pixelThreshold = 24;
+
+/// Ratio of visibly different pixels allowed on a page.
+const _maxDiffRatio = 0.001;
+
+/// Number of the renders of each page; the median time is compared with the baseline.
+const _timingRuns = 5;
+
+/// Allowed render time growth relative to the baseline (0.5 = +50%).
+const _timeTolerance = 0.5;
+
+/// Render time growth smaller than this is never reported; the timer noise of the pages rendered in a few hundred
+/// microseconds (the baseline is recorded on the same machine).
+const _timeSlackUs = 2000;
+
+/// Allowed peak RSS growth of a document relative to the baseline.
+const _memoryTolerance = 0.5;
+
+/// Peak RSS growth smaller than this is never reported; RSS is dominated by GC and allocator noise below it.
+const _memorySlackBytes = 4 * 1024 * 1024;
+
+Future<void> main() async {
+  WidgetsFlutterBinding.ensureInitialized();
+  final failures = await RenderGate(Directory(_corpus)).run(
+    updateGoldens: _update == 'true',
+    updateBaseline: _update == 'true' || _update == 'baseline',
+  );
+  exit(failures == 0 ? 0 : 1);
+}
+
+class RenderGate {
+  RenderGate(this.corpus);
+  final Directory corpus;
+
+  File get _baselineFile => File('${corpus.path}/baseline.json');
+  File get _manifestFile => File('${corpus.path}/corpus.json');
+  File _goldenFile(String doc, int pageNumber) =>
+      File('${corpus.path}/goldens/$doc/$pageNumber.png');
+
+  /// Run the gate and returns the number of regressions.
+  ///
+  /// [updateGoldens] and [updateBaseline] write the results instead of checking them.
+  Future<int> run(
+      {required bool updateGoldens, required bool updateBaseline}) async {
+    final manifest = _manifestFile.existsSync()
+        ? jsonDecode(await _manifestFile.readAsString()) as Map<String, dynamic>
+        : <String, dynamic>{};
+    if (!updateBaseline && !_baselineFile.existsSync()) {
+      stdout.writeln('PDFRX_GATE_FAIL: no ${_baselineFile.path}; '
+          'record it with --baseline before the change');
+      return 1;
+    }
+    final baseline = _baselineFile.existsSync()
+        ? jsonDecode(await _baselineFile.readAsString()) as Map<String, dynamic>
+        : <String, dynamic>{};
+    final newBaseline = <String, dynamic>{};
+
+    final docs = corpus
+        .listSync()
+        .whereType<File>()
+        .where((f) => f.path.toLowerCase().endsWith('.pdf'))
+        .toList()
+      ..sort((a, b) => a.path.compareTo(b.path));
+
+    int failures = 0;
+    void fail(String message) {
+      failures++;
+      stdout.writeln('PDFRX_GATE_FAIL: $message');
+    }
+
+    // e.g. a document added by the change; it has no baseline to compare with
+    void skip(String message) => stdout.writeln('PDFRX_GATE_SKIP: $message');
+
+    for (final file in docs) {
+      final name = file.uri.pathSegments.last;
+      final options = manifest[name] as Map<String, dynamic>?;
+      final PdfDocument doc;
+      try {
+        doc = await PdfDocument.openFile(file.path,
+            password: options?['password'] as String?);
+      } catch (e) {
+        fail('$name: could not be opened: $e');
+        continue;
+      }
+
+      final docBaseline = baseline[name] as Map<String, dynamic>?;
+      final pageBaselines = docBaseline?['pages'] as Map<String, dynamic>?;
+      final pageResults = <String, dynamic>{};
+      final rssBefore = ProcessInfo.currentRss;
+      var peakRss = rssBefore;
+      for (final page in doc.pages) {
+        final result = await _renderPage(page);
+        // sampled while the rendered image is alive
+        peakRss = max(peakRss, ProcessInfo.currentRss);
+        pageResults['${page.pageNumber}'] = {'timeUs': result.timeUs};
+
+        final goldenFile = _goldenFile(name, page.pageNumber);
+        if (updateGoldens) {
+          await goldenFile.parent.create(recursive: true);
+          await goldenFile.writeAsBytes(await _encodePng(result.image));
+        }
+        final where = '$name page ${page.pageNumber}';
+        if (updateGoldens) {
+          // nothing to compare
+        } else if (!goldenFile.existsSync()) {
+          fail('$where: no golden image');
+        } else {
+          final diff = await _compare(result.image, goldenFile);
+          if (diff == null) {
+            fail('$where: size differs from golden');
+          } else if (diff.ratio > _maxDiffRatio) {
+            fail('$where: ${(diff.ratio * 100).toStringAsFixed(3)}% pixels '
+                'differ from golden (allowed ${_maxDiffRatio * 100}%; '
+                'max delta ${diff.maxDelta})');
+          }
+        }
+        result.image.dispose();
+        if (updateBaseline) continue;
+
+        final pageBaseline =
+            pageBaselines?['${page.pageNumber}'] as Map<String, dynamic>?;
+        if (pageBaseline == null) {
+          skip('$where: no baseline');
+          continue;
+        }
+        final baseTime = pageBaseline['timeUs'] as int;
+        if (result.timeUs > baseTime * (1 + _timeTolerance) &&
+            result.timeUs - baseTime > _timeSlackUs) {
+          fail('$where: render time ${result.timeUs ~/ 1000}ms > baseline '
+              '${baseTime ~/ 1000}ms (${_percent(result.timeUs, baseTime)})');
+        }
+      }
+      await doc.dispose();
+
+      final peakRssBytes = peakRss - rssBefore;
+      newBaseline[name] = {'peakRssBytes': peakRssBytes, 'pages': pageResults};
+      final baseRss = docBaseline?['peakRssBytes'] as int?;
+      if (updateBaseline) {
+        // nothing to compare
+      } else if (baseRss == null) {
+        skip('$name: no memory baseline');
+      } else if (peakRssBytes > baseRss * (1 + _memoryTolerance) &&
+          peakRssBytes - baseRss > _memorySlackBytes) {
+        fail('$name: peak memory growth ${peakRssBytes >> 10}KB > baseline '
+            '${baseRss >> 10}KB (${_percent(peakRssBytes, baseRss)})');
+      }
+    }
+
+    if (updateBaseline) {
+      await _baselineFile.writeAsString(
+          const JsonEncoder.withIndent('  ').convert(newBaseline));
+      stdout.writeln('PDFRX_GATE: updated ${updateGoldens ? 'goldens/' : ''}'
+          'baseline for ${docs.length} documents; $failures regressions');
+    } else {
+      stdout.writeln('PDFRX_GATE: ${docs.length} documents, '
+          '$failures regressions');
+    }
+    return failures;
+  }
+
+  static String _percent(int value, int base) =>
+      base == 0 ? 'new' : '+${((value / base - 1) * 100).toStringAsFixed(1)}%';
+
+  /// Render the page [_timingRuns] times; returns the first image and the median time.
+  static Future<({ui.Image image, int timeUs})> _renderPage(
+      PdfPage page) async {
+    final times = <int>[];
+    ui.Image? image;
+    for (int i = 0; i < _timingRuns; i++) {
+      final sw = Stopwatch()..start();
+      final img = await page.render(
+        fullWidth: page.width * _scale,
+        fullHeight: page.height * _scale,
+        backgroundColor: Colors.white,
+      );
+      sw.stop();
+      times.add(sw.elapsedMicroseconds);
+      image ??= await img.createImage();
+      img.dispose();
+    }
+    times.sort();
+    return (image: image!, timeUs: times[times.length ~/ 2]);
+  }
+
+  static Future<Uint8List> _encodePng(ui.Image image) async {
+    final data = await image.toByteData(format: ui.ImageByteFormat.png);
+    return data!.buffer.asUint8List();
+  }
+
+  static Future<ByteData> _rgba(ui.Image image) async =>
+      (await image.toByteData(format: ui.ImageByteFormat.rawRgba))!;
+
+  /// Compare [image] with the golden image; returns null if the sizes differ.
+  static Future<({double ratio, int maxDelta})?> _compare(
+      ui.Image image, File goldenFile) async {
+    final codec =
+        await ui.instantiateImageCodec(await goldenFile.readAsBytes());
+    final golden = (await codec.getNextFrame()).image;
+    codec.dispose();
+    try {
+      if (golden.width != image.width || golden.height != image.height) {
+        return null;
+      }
+      final a = await _rgba(image);
+      final b = await _rgba(golden);
+      int diffCount = 0, maxDelta = 0;
+      for (int i = 0; i < a.lengthInBytes; i += 4) {
+        // luminance weighted difference (ITU-R BT.601) to approximate what we perceive
+        final delta = ((a.getUint8(i) - b.getUint8(i)).abs() * 299 +
+                (a.getUint8(i + 1) - b.getUint8(i + 1)).abs() * 587 +
+                (a.getUint8(i + 2) - b.getUint8(i + 2)).abs() * 114) ~/
+            1000;
+        if (delta > maxDelta) maxDelta = delta;
+        if (delta > _pixelThreshold) diffCount++;
+      }
+      return (ratio: diffCount / (a.lengthInBytes ~/ 4), maxDelta: maxDelta);
+    } finally {
+      golden.dispose();
+    }
+  }
+}
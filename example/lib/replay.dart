@@ -0,0 +1,124 @@
+// Interaction replay harness.
+//
+// The harness replays an interaction log recorded on a device (PdfViewerController.startRecording, saved by
+// PdfViewerInteractionLog.toJson) against the same document and reports the rendering sequence and timings of the
+// replay along with the ones of the original session, so that schedulers and cache settings can be compared on
+// real user sessions.
+//
+// Run it on Linux desktop with the profile build:
+//
+// ```
+// flutter run --profile -d linux -t lib/replay.dart \
+//   --dart-define=PDFRX_REPLAY_DOC=/path/to/document.pdf \
+//   --dart-define=PDFRX_REPLAY_LOG=/path/to/interaction_log.json \
+//   --dart-define=PDFRX_REPLAY_OUTPUT=replay_output.json
+// ```
+//
+// - PDFRX_REPLAY_DOC: the document; a file path, http(s) URL or `asset:NAME`
+// - PDFRX_REPLAY_LOG: the interaction log (JSON)
+// - PDFRX_REPLAY_OUTPUT: file path to write the JSON report to; the report is always written to stdout
+//   in a single line prefixed with `PDFRX_REPLAY_RESULT:`
+// - PDFRX_REPLAY_SPEED: replay speed (defaults to 1.0)
+//
+// The viewer is laid out at the view size of the log; the window should be large enough to contain it.
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:flutter/material.dart';
+import 'package:pdfrx/pdfrx.dart';
+
+const _doc = String.fromEnvironment('PDFRX_REPLAY_DOC');
+const _log = String.fromEnvironment('PDFRX_REPLAY_LOG');
+const _output = String.fromEnvironment('PDFRX_REPLAY_OUTPUT');
+const _speed = String.fromEnvironment('PDFRX_REPLAY_SPEED');
+
+void main() {
+  if (_doc.isEmpty || _log.isEmpty) {
+    stderr.writeln('PDFRX_REPLAY_DOC and PDFRX_REPLAY_LOG are required.');
+    exit(2);
+  }
+  final log = PdfViewerInteractionLog.fromJson(
+      jsonDecode(File(_log).readAsStringSync()) as Map<String, dynamic>);
+  runApp(ReplayApp(log: log));
+}
+
+class ReplayApp extends StatefulWidget {
+  const ReplayApp({required this.log, super.key});
+
+  final PdfViewerInteractionLog log;
+
+  @override
+  State<ReplayApp> createState() => _ReplayAppState();
+}
+
+class _ReplayAppState extends State<ReplayApp> {
+  final _controller = PdfViewerController();
+
+  @override
+  void initState() {
+    super.initState();
+    WidgetsBinding.instance.addPostFrameCallback((_) => _run());
+  }
+
+  Future<void> _run() async {
+    final sw = Stopwatch()..start();
+    while (!_controller.isReady) {
+      if (sw.elapsed > const Duration(minutes: 2)) {
+        stderr.writeln('Timeout on loading $_doc');
+        exit(1);
+      }
+      await Future.delayed(const Duration(milliseconds: 50));
+    }
+    // let the initial renderings settle as on the recorded session
+    await Future.delayed(const Duration(milliseconds: 500));
+
+    final original = widget.log;
+    final replayed = await _controller.replay(original,
+        speed: double.tryParse(_speed) ?? 1.0);
+    final mismatch = original.firstRenderRequestMismatch(replayed);
+    final report = jsonEncode({
+      'timestamp': DateTime.now().toIso8601String(),
+      'platform': Platform.operatingSystem,
+      'document': _doc,
+      'sourceName': original.sourceName,
+      'viewSize': [_controller.viewSize.width, _controller.viewSize.height],
+      'renderRequestsMatch': mismatch == null,
+      'firstRenderRequestMismatch': mismatch,
+      'original': original.report().toJson(),
+      'replay': replayed.report().toJson(),
+    });
+    stdout.writeln('PDFRX_REPLAY_RESULT:$report');
+    if (_output.isNotEmpty) {
+      await File(_output).writeAsString(report);
+    }
+    exit(0);
+  }
+
+  Widget _buildViewer() {
+    if (_doc.startsWith('asset:')) {
+      return PdfViewer.asset(_doc.substring(6), controller: _controller);
+    }
+    if (_doc.startsWith('http://') || _doc.startsWith('https://')) {
+      return PdfViewer.uri(Uri.parse(_doc), controller: _controller);
+    }
+    return PdfViewer.file(_doc, controller: _controller);
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final viewSize = widget.log.viewSize;
+    return MaterialApp(
+      home: Scaffold(
+        body: Align(
+          alignment: Alignment.topLeft,
+          child: SizedBox(
+            width: viewSize?.width,
+            height: viewSize?.height,
+            child: _buildViewer(),
+          ),
+        ),
+      ),
+    );
+  }
+}
@@ -0,0 +1,311 @@
+// Harness of the block synchronization of [PdfDocument.openUriSynced].
+//
+// The harness serves a generated PDF and its block manifest (`<file>.blocks.json`) from a local [HttpServer], edits
+// the served file between the synchronizations and checks the results against the requests the server actually
+// received:
+//
+// - the first synchronization downloads the whole file and a second one downloads nothing
+// - editing one block fetches exactly that block by one range request
+// - adjacent dirty blocks are merged into one range request
+// - the whole file is taken when the server answers the range request by 200 instead of 206
+// - the previous local copy survives a failed synchronization
+//
+// [PdfDocument.openUri] is checked on the same server through the default cache ([PdfFileCacheTiered]) for the cases
+// where the last cache block is shorter than the others: a file smaller than a cache block and a server answering the
+// range request by 200 with the whole file.
+//
+// tool/sync_harness.sh builds and runs the harness on Linux desktop, or run it directly:
+//
+// ```
+// flutter run --release -d linux -t lib/sync_harness.dart
+// ```
+//
+// The process exits with 1 if any check failed; every failure is reported on a line prefixed with
+// `PDFRX_SYNC_FAIL:`.
+import 'dart:io';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/widgets.dart';
+import 'package:pdfrx/pdfrx.dart';
+
+const _blockSize = PdfBlockManifest.defaultBlockSize;
+
+/// Number of the blocks of the served file; the last one is partial.
+const _blockCount = 5;
+
+Future<void> main() async {
+  WidgetsFlutterBinding.ensureInitialized();
+  final temp = await Directory.systemTemp.createTemp('pdfrx_sync');
+  final server = await _SyncServer.start(temp);
+  final int failures;
+  try {
+    failures = await SyncHarness(server, File('${temp.path}/local.pdf')).run();
+  } finally {
+    await server.close();
+    await temp.delete(recursive: true);
+  }
+  exit(failures == 0 ? 0 : 1);
+}
+
+class SyncHarness {
+  SyncHarness(this.server, this.local);
+  final _SyncServer server;
+
+  /// The local copy synchronized with the served file.
+  final File local;
+
+  int _failures = 0;
+
+  void _fail(String message) {
+    _failures++;
+    stdout.writeln('PDFRX_SYNC_FAIL: $message');
+  }
+
+  void _expect(String what, Object? actual, Object? expected) {
+    final equals = actual is List && expected is List
+        ? listEquals(actual, expected)
+        : actual == expected;
+    if (!equals) _fail('$what: $actual (expected $expected)');
+  }
+
+  /// Run the checks and returns the number of failures.
+  Future<int> run() async {
+    await server.publish(_generatePdf());
+
+    var result = await _sync('initial');
+    _expect('initial: fullDownload', result?.fullDownload, true);
+    _expect('initial: fetchedBlockCount', result?.fetchedBlockCount,
+        _blockCount);
+    _expect('initial: range requests', server.rangeRequests.length, 0);
+    await _expectInSync('initial');
+
+    result = await _sync('unchanged');
+    _expect('unchanged: fetchedBlockCount', result?.fetchedBlockCount, 0);
+    _expect('unchanged: range requests', server.rangeRequests.length, 0);
+
+    await server.publish(_edit(server.bytes, [2]));
+    result = await _sync('one block');
+    _expect('one block: fullDownload', result?.fullDownload, false);
+    _expect('one block: fetchedBlockCount', result?.fetchedBlockCount, 1);
+    _expect('one block: fetchedBytes', result?.fetchedBytes, _blockSize);
+    _expect('one block: range requests', server.rangeRequests,
+        ['bytes=${2 * _blockSize}-${3 * _blockSize - 1}']);
+    await _expectInSync('one block');
+
+    await server.publish(_edit(server.bytes, [1, 2, 4]));
+    result = await _sync('adjacent blocks');
+    _expect(
+        'adjacent blocks: fetchedBlockCount', result?.fetchedBlockCount, 3);
+    _expect('adjacent blocks: range requests', server.rangeRequests, [
+      'bytes=$_blockSize-${3 * _blockSize - 1}',
+      'bytes=${4 * _blockSize}-${server.bytes.length - 1}',
+    ]);
+    await _expectInSync('adjacent blocks');
+
+    server.acceptRanges = false;
+    await server.publish(_edit(server.bytes, [0]));
+    result = await _sync('no range support');
+    _expect('no range support: fullDownload', result?.fullDownload, true);
+    _expect('no range support: fetchedBlockCount', result?.fetchedBlockCount,
+        _blockCount);
+    _expect('no range support: range requests', server.rangeRequests.length, 1);
+    await _expectInSync('no range support');
+    server.acceptRanges = true;
+
+    final previous = await local.readAsBytes();
+    server.failRanges = true;
+    await server.publish(_edit(server.bytes, [3]));
+    try {
+      await PdfDocument.openUriSynced(server.uri, filePath: local.path);
+      _fail('failed sync: no exception');
+    } on HttpException {
+      // expected
+    } catch (e) {
+      _fail('failed sync: unexpected exception: $e');
+    }
+    server.failRanges = false;
+    _expect('failed sync: local copy kept',
+        listEquals(await local.readAsBytes(), previous), true);
+    _expect('failed sync: temporary file removed',
+        await File('${local.path}.sync').exists(), false);
+
+    // the next synchronization recovers
+    result = await _sync('recovery');
+    _expect('recovery: fetchedBlockCount', result?.fetchedBlockCount, 1);
+    await _expectInSync('recovery');
+
+    await server.publish(_generatePdf(padding: 1024));
+    await _open('small file', expectRangeRequests: 1);
+    server.acceptRanges = false;
+    await server.publish(_generatePdf());
+    await _open('no range support', expectRangeRequests: 1);
+    server.acceptRanges = true;
+
+    stdout.writeln('PDFRX_SYNC: $_failures failures');
+    return _failures;
+  }
+
+  /// Synchronize the local copy and open it; returns null if it failed.
+  Future<PdfSyncResult?> _sync(String what) async {
+    server.rangeRequests.clear();
+    PdfSyncResult? result;
+    try {
+      final doc = await PdfDocument.openUriSynced(
+        server.uri,
+        filePath: local.path,
+        onSynced: (r) => result = r,
+      );
+      _expect('$what: page count', doc.pages.length, 1);
+      await doc.dispose();
+    } catch (e) {
+      _fail('$what: sync failed: $e');
+      return null;
+    }
+    _expect('$what: blockCount', result?.blockCount, _blockCount);
+    return result;
+  }
+
+  /// Open the served file by [PdfDocument.openUri] and render its page, which reads the blocks at both ends.
+  Future<void> _open(String what, {required int expectRangeRequests}) async {
+    server.rangeRequests.clear();
+    try {
+      final doc = await PdfDocument.openUri(server.uri);
+      try {
+        _expect('openUri $what: page count', doc.pages.length, 1);
+        final image = await doc.pages[0].render();
+        _expect('openUri $what: rendered', image != null, true);
+        image?.dispose();
+      } finally {
+        await doc.dispose();
+      }
+    } catch (e) {
+      _fail('openUri $what: failed: $e');
+    }
+    _expect('openUri $what: range requests', server.rangeRequests.length,
+        expectRangeRequests);
+  }
+
+  Future<void> _expectInSync(String what) async {
+    _expect('$what: local copy equals the served file',
+        listEquals(await local.readAsBytes(), server.bytes), true);
+  }
+
+  /// Copy of [bytes] with one byte changed in each of [blocks].
+  static Uint8List _edit(Uint8List bytes, List<int> blocks) {
+    final edited = Uint8List.fromList(bytes);
+    for (final block in blocks) {
+      // within the padding stream of [_generatePdf]
+      final offset = block * _blockSize + 1024;
+      edited[offset] = (edited[offset] + 1) & 0xff;
+    }
+    return edited;
+  }
+
+  /// One-page PDF of [_blockCount] blocks by default; an unreferenced stream object of [padding] bytes pads the file so
+  /// that every block can be edited without breaking the cross-reference table.
+  static Uint8List _generatePdf(
+      {int padding = (_blockCount - 1) * _blockSize + _blockSize ~/ 2}) {
+    final out = BytesBuilder(copy: false);
+    final offsets = <int>[];
+    void add(String s) => out.add(s.codeUnits);
+    void obj(String body) {
+      offsets.add(out.length);
+      add('${offsets.length} 0 obj\n$body\nendobj\n');
+    }
+
+    add('%PDF-1.4\n');
+    obj('<< /Type /Catalog /Pages 2 0 R >>');
+    obj('<< /Type /Pages /Kids [3 0 R] /Count 1 >>');
+    obj('<< /Type /Page /Parent 2 0 R /MediaBox [0 0 200 200] '
+        '/Contents 4 0 R >>');
+    const content = '0 0 1 rg 50 50 100 100 re f';
+    obj('<< /Length ${content.length} >>\nstream\n$content\nendstream');
+
+    final random = Random(0);
+    offsets.add(out.length);
+    add('${offsets.length} 0 obj\n<< /Length $padding >>\nstream\n');
+    final data = Uint8List(padding);
+    for (int i = 0; i < padding; i++) {
+      data[i] = random.nextInt(256);
+    }
+    out.add(data);
+    add('\nendstream\nendobj\n');
+
+    final xref = out.length;
+    add('xref\n0 ${offsets.length + 1}\n0000000000 65535 f \n');
+    for (final offset in offsets) {
+      add('${offset.toString().padLeft(10, '0')} 00000 n \n');
+    }
+    add('trailer\n<< /Size ${offsets.length + 1} /Root 1 0 R >>\n'
+        'startxref\n$xref\n%%EOF\n');
+    return out.takeBytes();
+  }
+}
+
+/// Serves `doc.pdf` and `doc.pdf.blocks.json` on the loopback interface.
+class _SyncServer {
+  _SyncServer._(this._server, this._file) {
+    _server.listen(_handle);
+  }
+
+  static Future<_SyncServer> start(Directory dir) async => _SyncServer._(
+      await HttpServer.bind(InternetAddress.loopbackIPv4, 0),
+      File('${dir.path}/doc.pdf'));
+
+  final HttpServer _server;
+  final File _file;
+  Uint8List bytes = Uint8List(0);
+  String _manifest = '';
+
+  /// `false` to answer the range requests by 200 with the whole file.
+  bool acceptRanges = true;
+
+  /// `true` to answer the range requests by 500.
+  bool failRanges = false;
+
+  /// `Range` headers of the requests received since it was last cleared.
+  final rangeRequests = <String>[];
+
+  Uri get uri => Uri.parse('http://127.0.0.1:${_server.port}/doc.pdf');
+
+  /// Replace the served file and its manifest.
+  Future<void> publish(Uint8List bytes) async {
+    this.bytes = bytes;
+    await _file.writeAsBytes(bytes, flush: true);
+    _manifest = (await PdfBlockManifest.fromFile(_file.path)).toJson();
+  }
+
+  Future<void> close() => _server.close(force: true);
+
+  Future<void> _handle(HttpRequest request) async {
+    final response = request.response;
+    final range = request.headers.value(HttpHeaders.rangeHeader);
+    if (request.uri.path == '/doc.pdf.blocks.json') {
+      response.headers.contentType = ContentType.json;
+      response.write(_manifest);
+    } else if (request.uri.path != '/doc.pdf') {
+      response.statusCode = HttpStatus.notFound;
+    } else if (range == null || !acceptRanges) {
+      if (range != null) rangeRequests.add(range);
+      response.contentLength = bytes.length;
+      response.add(bytes);
+    } else {
+      rangeRequests.add(range);
+      final m = RegExp(r'^bytes=(\d+)-(\d+)$').firstMatch(range);
+      if (failRanges || m == null) {
+        response.statusCode = HttpStatus.internalServerError;
+      } else {
+        final start = int.parse(m.group(1)!);
+        final end = min(int.parse(m.group(2)!), bytes.length - 1);
+        response.statusCode = HttpStatus.partialContent;
+        response.headers.set(HttpHeaders.contentRangeHeader,
+            'bytes $start-$end/${bytes.length}');
+        response.contentLength = end - start + 1;
+        response.add(Uint8List.sublistView(bytes, start, end + 1));
+      }
+    }
+    await response.close();
+  }
+}
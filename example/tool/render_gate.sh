@@ -0,0 +1,39 @@
+#!/bin/bash -e
+#
+# Build and run the render regression gate (lib/render_gate.dart) over render_corpus/ on Linux desktop.
+#
+#   tool/render_gate.sh             check the corpus against the goldens and baseline.json
+#   tool/render_gate.sh --baseline  record baseline.json only (before the change to be checked)
+#   tool/render_gate.sh --update    refresh goldens and baseline.json
+#
+# The exit code is the one of the gate: 1 if any page regressed. Without a display, the gate runs under xvfb-run.
+
+SCRIPT_DIR=$(cd "$(dirname "$0")" && pwd)
+EXAMPLE_DIR=$(dirname "$SCRIPT_DIR")
+CORPUS_DIR=$EXAMPLE_DIR/render_corpus
+
+case "$1" in
+  "") UPDATE= ;;
+  --baseline) UPDATE=baseline ;;
+  --update) UPDATE=true ;;
+  *)
+    echo "Usage: $0 [--baseline|--update]"
+    exit 2
+    ;;
+esac
+
+cd "$EXAMPLE_DIR"
+flutter build linux --release -t lib/render_gate.dart \
+  --dart-define=PDFRX_GATE_CORPUS="$CORPUS_DIR" \
+  --dart-define=PDFRX_GATE_UPDATE="$UPDATE"
+
+BUNDLE=$(find build/linux -path '*/release/bundle/pdfrx_example' -type f | head -n 1)
+if [ -z "$BUNDLE" ]; then
+  echo "Could not find the built gate executable."
+  exit 2
+fi
+
+if [ -z "$DISPLAY" ] && [ -z "$WAYLAND_DISPLAY" ] && command -v xvfb-run > /dev/null; then
+  exec xvfb-run -a "$BUNDLE"
+fi
+exec "$BUNDLE"
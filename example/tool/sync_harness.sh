@@ -0,0 +1,22 @@
+#!/bin/bash -e
+#
+# Build and run the block synchronization harness (lib/sync_harness.dart) on Linux desktop.
+#
+# The exit code is the one of the harness: 1 if any check failed. Without a display, the harness runs under xvfb-run.
+
+SCRIPT_DIR=$(cd "$(dirname "$0")" && pwd)
+EXAMPLE_DIR=$(dirname "$SCRIPT_DIR")
+
+cd "$EXAMPLE_DIR"
+flutter build linux --release -t lib/sync_harness.dart
+
+BUNDLE=$(find build/linux -path '*/release/bundle/pdfrx_example' -type f | head -n 1)
+if [ -z "$BUNDLE" ]; then
+  echo "Could not find the built harness executable."
+  exit 2
+fi
+
+if [ -z "$DISPLAY" ] && [ -z "$WAYLAND_DISPLAY" ] && command -v xvfb-run > /dev/null; then
+  exec xvfb-run -a "$BUNDLE"
+fi
+exec "$BUNDLE"
@@ -1,6 +1,7 @@
 export 'src/pdf_api.dart';
 export 'src/pdf_document_store.dart';
 export 'src/pdf_file_cache.dart';
+export 'src/pdf_reflow_viewer.dart';
 export 'src/pdf_viewer_params.dart';
 export 'src/pdf_viewer_scroll_thumb.dart';
 export 'src/pdf_widgets.dart';
@@ -1,5 +1,6 @@
 // ignore_for_file: public_member_api_docs, sort_constructors_first
 import 'dart:async';
+import 'dart:convert';
 import 'dart:ui' as ui;
 
 import 'package:flutter/foundation.dart';
@@ -32,14 +33,32 @@ abstract class PdfDocumentFactory {
     String? password,
     int? maxSizeToCacheOnMemory,
     void Function()? onDispose,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
   });
 
   /// See [PdfDocument.openUri].
   Future<PdfDocument> openUri(
     Uri uri, {
     String? password,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
   });
 
+  /// See [PdfDocument.openUriSynced].
+  Future<PdfDocument> openUriSynced(
+    Uri uri, {
+    required String filePath,
+    Uri? manifestUri,
+    String? password,
+    void Function(PdfSyncResult result)? onSynced,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
+  });
+
+  /// See [PdfBlockManifest.fromFile].
+  Future<PdfBlockManifest> createBlockManifest(String filePath);
+
   /// Singleton [PdfDocumentFactory] instance.
   ///
   /// It is used to switch pdfium/web implementation based on the running platform and of course, you can
@@ -89,6 +108,11 @@ abstract class PdfDocument {
   /// [maxSizeToCacheOnMemory] is the maximum size of the PDF to cache on memory in bytes; the custom loading process
   /// may be heavy because of FFI overhead and it may be better to cache the PDF on memory if it's not too large.
   /// The default size is 1MB.
+  ///
+  /// [cancellationToken] can be used to cancel the loading; once it is cancelled, pending and future [read]
+  /// calls fail immediately and the function throws [PdfOperationCanceledException]. Cancelling it after the
+  /// document is opened has no effect.
+  /// [timeout] specifies the deadline of the loading; it does not affect the reads after the document is opened.
   static Future<PdfDocument> openCustom({
     required FutureOr<int> Function(Uint8List buffer, int position, int size)
         read,
@@ -97,6 +121,8 @@ abstract class PdfDocument {
     String? password,
     int? maxSizeToCacheOnMemory,
     void Function()? onDispose,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
   }) =>
       PdfDocumentFactory.instance.openCustom(
         read: read,
@@ -105,6 +131,8 @@ abstract class PdfDocument {
         password: password,
         maxSizeToCacheOnMemory: maxSizeToCacheOnMemory,
         onDispose: onDispose,
+        cancellationToken: cancellationToken,
+        timeout: timeout,
       );
 
   /// Opening the PDF from URI.
@@ -112,13 +140,51 @@ abstract class PdfDocument {
   /// For Flutter Web, the implementation uses browser's function and restricted by CORS.
   // ignore: comment_references
   /// For other platforms, it uses [pdfDocumentFromUri] that uses HTTP's range request to download the file .
+  ///
+  /// [cancellationToken] and [timeout] work in the same way as [openCustom]; on cancellation, outstanding
+  /// HTTP requests are aborted.
   static Future<PdfDocument> openUri(
     Uri uri, {
     String? password,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
   }) =>
       PdfDocumentFactory.instance.openUri(
         uri,
         password: password,
+        cancellationToken: cancellationToken,
+        timeout: timeout,
+      );
+
+  /// Opening the PDF from URI through a local copy at [filePath] that is kept in sync with the remote file.
+  ///
+  /// The server provides a block hash manifest ([PdfBlockManifest]; `[uri].blocks.json` by default, or
+  /// [manifestUri]) along with the file; the blocks of the local copy are hashed and only the changed or missing
+  /// blocks are downloaded by HTTP's range requests, so that a large document updated on a few pages does not have to
+  /// be downloaded again. The whole file is downloaded if the local copy does not exist, the manifest is not
+  /// available or the server does not support range requests. The local copy is replaced atomically once all the
+  /// blocks are verified against the manifest and then opened by [openFile]; [onSynced] is called with the statistics
+  /// before that.
+  ///
+  /// [cancellationToken] and [timeout] work in the same way as [openUri]; on cancellation, the local copy is kept
+  /// intact. Not supported on Flutter Web.
+  static Future<PdfDocument> openUriSynced(
+    Uri uri, {
+    required String filePath,
+    Uri? manifestUri,
+    String? password,
+    void Function(PdfSyncResult result)? onSynced,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
+  }) =>
+      PdfDocumentFactory.instance.openUriSynced(
+        uri,
+        filePath: filePath,
+        manifestUri: manifestUri,
+        password: password,
+        onSynced: onSynced,
+        cancellationToken: cancellationToken,
+        timeout: timeout,
       );
 
   /// Pages.
@@ -129,6 +195,297 @@ abstract class PdfDocument {
   ///
   /// It does not mean the document contents (or the document files) are identical.
   bool isIdenticalDocumentHandle(Object? other);
+
+  /// Compute the highlight rectangles of [selection] merged into line runs.
+  ///
+  /// The rectangles are computed for the pages in the selection between [firstPageNumber] and [lastPageNumber]
+  /// (typically, the visible pages) in a batch and returned as a map of page number to the rectangles in PDF page
+  /// coordinates.
+  Future<Map<int, List<PdfRect>>> getTextSelectionRects(
+    PdfTextSelection selection, {
+    int? firstPageNumber,
+    int? lastPageNumber,
+  });
+
+  /// Extract the text of [selection] lazily; the text is streamed page by page (pages are separated by
+  /// CR+LF) so that extracting a long selection does not block the UI.
+  Stream<String> streamTextSelection(PdfTextSelection selection);
+
+  /// Compare the pages of the document (the old revision) with [other] (the new revision) visually.
+  ///
+  /// Pages are matched between the documents by their contents; the matched pages are rendered at [scale] and
+  /// compared tile by tile ([tileSize] in pixels) and a tile is regarded as changed if any color channel of a pixel
+  /// differs more than [threshold] (0-255). The results are streamed in the page order of [other] (deleted pages
+  /// are reported at the position they were).
+  /// If [createOverlay] is true, [PdfPageDiff.overlay] contains an image that highlights the changes.
+  Stream<PdfPageDiff> diffPages(
+    PdfDocument other, {
+    double scale = 1.0,
+    int tileSize = 16,
+    int threshold = 24,
+    bool createOverlay = false,
+  });
+
+  /// Load the annotations of all the pages at once; the map is keyed by page number.
+  ///
+  /// It is much faster than calling [PdfPage.loadAnnotations] for each page on documents with many pages.
+  Future<Map<int, List<PdfAnnotation>>> loadAllAnnotations();
+
+  /// Load all the form fields (widgets) of the document at once.
+  ///
+  /// A field that has multiple widgets (e.g. radio buttons) appears once for each widget with the same
+  /// [PdfFormField.name].
+  Future<List<PdfFormField>> loadFormFields();
+
+  /// Apply [updates] to the form fields at once and returns the number of the widgets updated.
+  ///
+  /// The pages should be re-rendered to reflect the changes.
+  Future<int> updateFormFields(List<PdfFormFieldUpdate> updates);
+
+  /// Load the list of the embedded files (attachments) of the document.
+  Future<List<PdfAttachment>> loadAttachments();
+
+  /// Write the content of [attachment] to the file at [path] and returns its size in bytes.
+  ///
+  /// The content is written by the native side in chunks of [chunkSize] bytes and never copied into Dart memory,
+  /// so it works with attachments of hundreds of megabytes.
+  Future<int> saveAttachment(
+    PdfAttachment attachment,
+    String path, {
+    int chunkSize = 1024 * 1024,
+  });
+
+  /// Prepare the pages of [pageNumbers] (in the order of priority) ahead of their use, typically while the viewer
+  /// is at rest; the invalid page numbers are ignored.
+  ///
+  /// The page contents are parsed when the document is opened. If [loadText] is true, the text pages (the character
+  /// analysis used by text extraction and selection) are also built and cached up to [maxTextCacheBytes] (shared by
+  /// the pages of the document, least recently used first out), so that only rasterization remains on the critical
+  /// path when the pages are shown. Returns the number of the pages newly prepared.
+  Future<int> preparePages(
+    List<int> pageNumbers, {
+    bool loadText = true,
+    int maxTextCacheBytes = 32 * 1024 * 1024,
+  });
+
+  /// Compute a stable fingerprint of the document content, which can be used as the document identity by caches
+  /// ([sourceName] is not; e.g. `memory-${data.hashCode}`).
+  ///
+  /// If [sampled] is true, only the file size, the head, the tail and the cross reference section of the file are
+  /// hashed; it is the default for the documents opened by [openCustom]/[openUri] because hashing the whole
+  /// content requires reading it all. Otherwise, the whole content is hashed in parallel by [threadCount] threads
+  /// (0 for the number of the CPU cores); the files opened by [openFile] are memory-mapped.
+  ///
+  /// The fingerprints of the different modes are never equal.
+  Future<PdfDocumentFingerprint> computeFingerprint({
+    bool? sampled,
+    int threadCount = 0,
+  });
+}
+
+/// Result of [PdfDocument.diffPages] for a page.
+class PdfPageDiff {
+  PdfPageDiff({
+    required this.pageNumberA,
+    required this.pageNumberB,
+    this.changedRects = const [],
+    this.overlay,
+  });
+
+  /// Page number on the old document; null if the page is inserted.
+  final int? pageNumberA;
+
+  /// Page number on the new document; null if the page is deleted.
+  final int? pageNumberB;
+
+  /// Changed regions in the page coordinates of the new page.
+  final List<PdfRect> changedRects;
+
+  /// Image of the new page with the changes highlighted if requested; it should be disposed after use.
+  final PdfImage? overlay;
+
+  bool get isInserted => pageNumberA == null;
+  bool get isDeleted => pageNumberB == null;
+  bool get isChanged => isInserted || isDeleted || changedRects.isNotEmpty;
+}
+
+/// Position of a character in a document used by [PdfTextSelection].
+@immutable
+class PdfTextPosition implements Comparable<PdfTextPosition> {
+  const PdfTextPosition(this.pageNumber, this.charIndex);
+
+  /// Page number (1-based).
+  final int pageNumber;
+
+  /// Index of the character on the page.
+  ///
+  /// The index is the one of the underlying PDF engine and it does not correspond to the index on
+  /// [PdfPageText.fullText]; use [PdfPage.getCharIndexAt] to obtain it.
+  final int charIndex;
+
+  @override
+  int compareTo(PdfTextPosition other) => pageNumber != other.pageNumber
+      ? pageNumber - other.pageNumber
+      : charIndex - other.charIndex;
+
+  @override
+  bool operator ==(Object other) =>
+      other is PdfTextPosition &&
+      other.pageNumber == pageNumber &&
+      other.charIndex == charIndex;
+
+  @override
+  int get hashCode => pageNumber.hashCode ^ charIndex.hashCode;
+
+  @override
+  String toString() => 'PdfTextPosition($pageNumber, $charIndex)';
+}
+
+/// Text selection that may span multiple pages.
+///
+/// The selection is held only as two positions; highlight rectangles and text are computed on demand by
+/// [PdfDocument.getTextSelectionRects] and [PdfDocument.streamTextSelection].
+@immutable
+class PdfTextSelection {
+  const PdfTextSelection({required this.anchor, required this.focus});
+
+  /// Position where the selection started.
+  final PdfTextPosition anchor;
+
+  /// Position where the selection is extended to (inclusive); it may be before [anchor].
+  final PdfTextPosition focus;
+
+  /// The first selected character.
+  PdfTextPosition get start => anchor.compareTo(focus) <= 0 ? anchor : focus;
+
+  /// The last selected character (inclusive).
+  PdfTextPosition get end => anchor.compareTo(focus) <= 0 ? focus : anchor;
+
+  int get firstPageNumber => start.pageNumber;
+  int get lastPageNumber => end.pageNumber;
+
+  bool containsPage(int pageNumber) =>
+      pageNumber >= firstPageNumber && pageNumber <= lastPageNumber;
+
+  /// Selected character range on the page; [count] is -1 if the range continues to the end of the page.
+  ({int start, int count})? rangeOnPage(int pageNumber) {
+    if (!containsPage(pageNumber)) return null;
+    final s = pageNumber == firstPageNumber ? start.charIndex : 0;
+    if (pageNumber != lastPageNumber) return (start: s, count: -1);
+    return (start: s, count: end.charIndex - s + 1);
+  }
+
+  /// Create a new selection that has the same [anchor] and the new [focus].
+  PdfTextSelection extendTo(PdfTextPosition focus) =>
+      PdfTextSelection(anchor: anchor, focus: focus);
+
+  @override
+  bool operator ==(Object other) =>
+      other is PdfTextSelection &&
+      other.anchor == anchor &&
+      other.focus == focus;
+
+  @override
+  int get hashCode => anchor.hashCode ^ focus.hashCode;
+}
+
+/// Token to cancel long running operations such as [PdfDocument.openUri] and [PdfDocument.openCustom].
+class PdfCancellationToken {
+  PdfCancellationToken();
+
+  /// Create a token that is cancelled when [parent] is cancelled or when [timeout] expires.
+  ///
+  /// If [timeout] is null, the function just returns [parent].
+  /// Call [complete] on the returned token when the operation is done so that [parent] does not keep it.
+  static PdfCancellationToken? withTimeout(
+      PdfCancellationToken? parent, Duration? timeout) {
+    if (timeout == null) return parent;
+    final token = PdfCancellationToken().._isDerived = true;
+    token._parent = parent;
+    parent?.addListener(token.cancel);
+    token._timer = Timer(timeout, () => token._cancel(isTimeout: true));
+    return token;
+  }
+
+  final _listeners = <void Function()>[];
+  Timer? _timer;
+  PdfCancellationToken? _parent;
+  bool _isDerived = false;
+  bool _isCanceled = false;
+  bool _isTimedOut = false;
+
+  /// Whether the operation is cancelled (or timed out) or not.
+  bool get isCanceled => _isCanceled;
+
+  /// Whether the cancellation is caused by the timeout or not.
+  bool get isTimedOut => _isTimedOut;
+
+  /// Cancel the operation.
+  void cancel() => _cancel(isTimeout: false);
+
+  void _cancel({required bool isTimeout}) {
+    if (_isCanceled) return;
+    _isCanceled = true;
+    _isTimedOut = isTimeout;
+    _timer?.cancel();
+    _detachFromParent();
+    final listeners = List.of(_listeners);
+    _listeners.clear();
+    for (final listener in listeners) {
+      listener();
+    }
+  }
+
+  /// Stop the timeout set by [withTimeout]; the token is still cancelled when the parent token is cancelled.
+  void clearTimeout() {
+    _timer?.cancel();
+    _timer = null;
+  }
+
+  /// Notify the completion of the operation to the token created by [withTimeout]; the timeout is stopped and
+  /// the token no longer follows the parent token. It does nothing on the other tokens.
+  void complete() {
+    if (!_isDerived) return;
+    clearTimeout();
+    _detachFromParent();
+  }
+
+  void _detachFromParent() {
+    _parent?.removeListener(cancel);
+    _parent = null;
+  }
+
+  /// Add a listener called on cancellation; if the token is already cancelled, [listener] is called immediately.
+  void addListener(void Function() listener) {
+    if (_isCanceled) {
+      listener();
+      return;
+    }
+    _listeners.add(listener);
+  }
+
+  /// Remove the listener added by [addListener].
+  void removeListener(void Function() listener) => _listeners.remove(listener);
+
+  /// Throw [PdfOperationCanceledException] if the token is cancelled.
+  void throwIfCanceled() {
+    if (_isCanceled) {
+      throw PdfOperationCanceledException(isTimeout: _isTimedOut);
+    }
+  }
+}
+
+/// Exception thrown when an operation is cancelled by [PdfCancellationToken].
+class PdfOperationCanceledException implements Exception {
+  const PdfOperationCanceledException({this.isTimeout = false});
+
+  /// Whether the operation is cancelled due to the timeout or not.
+  final bool isTimeout;
+
+  @override
+  String toString() => isTimeout
+      ? 'PdfOperationCanceledException: timed out'
+      : 'PdfOperationCanceledException: cancelled';
 }
 
 /// Handles a PDF page in [PdfDocument].
@@ -153,6 +510,7 @@ abstract class PdfPage {
   /// - If [width], [height] is not specified, [fullWidth], [fullHeight] is used.
   /// - If [fullWidth], [fullHeight] are not specified, [PdfPage.width] and [PdfPage.height] are used (it means rendered at 72-dpi).
   /// [backgroundColor] is used to fill the background of the page. If no color is specified, [Colors.white] is used.
+  /// [limits] bounds the time and memory used by the rendering; see [PdfRenderLimits].
   ///
   /// The following code extract the area of (20,30)-(120,130) from the page image rendered at 1000x1500 pixels:
   /// ```dart
@@ -174,11 +532,149 @@ abstract class PdfPage {
     double? fullHeight,
     Color? backgroundColor,
     bool enableAnnotations = true,
+    PdfRenderLimits? limits,
+  });
+
+  /// Render a sub-area or full image of the page directly into a caller-owned native buffer (e.g. a shared-memory
+  /// frame or a memory-mapped file) without any intermediate copy.
+  ///
+  /// [bufferAddress] is the address of the buffer of [bufferSize] bytes; [stride] is the number of bytes per row
+  /// (the default is [width] multiplied by [PdfBitmapFormat.bytesPerPixel] of [format]). The buffer must stay valid
+  /// until the returned future completes. The other parameters are same to [render] except that [width] and
+  /// [height] are required. Throws [ArgumentError] if the buffer is too small for the image.
+  ///
+  /// Not supported on Flutter Web.
+  Future<void> renderToBuffer({
+    required int bufferAddress,
+    required int bufferSize,
+    required int width,
+    required int height,
+    int? stride,
+    PdfBitmapFormat format = PdfBitmapFormat.bgra,
+    int x = 0,
+    int y = 0,
+    double? fullWidth,
+    double? fullHeight,
+    Color? backgroundColor,
+    bool enableAnnotations = true,
+  });
+
+  /// Render the page progressively so that complex pages can be shown before the rendering completes.
+  ///
+  /// The stream emits the partially rendered images about every [interval] while the page is being rendered and
+  /// then the completed image, after which the stream is closed; pages rendered within [interval] emit only the
+  /// completed image. The other parameters are same to [render]. Every emitted image should be disposed after use.
+  /// Canceling the subscription stops the rendering.
+  ///
+  /// On Flutter Web, only the completed image is emitted.
+  Stream<PdfImage> renderProgressive({
+    int x = 0,
+    int y = 0,
+    int? width,
+    int? height,
+    double? fullWidth,
+    double? fullHeight,
+    Color? backgroundColor,
+    bool enableAnnotations = true,
+    PdfRenderLimits? limits,
+    Duration interval = const Duration(milliseconds: 100),
   });
 
   /// Create Text object to extract text from the page.
   /// The returned object should be disposed after use.
   Future<PdfPageText?> loadText();
+
+  /// Load the characters and their boxes within [rect] (in PDF page coordinates) only.
+  ///
+  /// Unlike [loadText], the cost is proportional to the characters around [rect] rather than the whole page; the
+  /// character boxes of the page are indexed on the first call and kept while the text page is cached (see
+  /// [PdfDocument.preparePages]). It is useful to load the text of the visible area (or tiles) of huge pages at
+  /// high zoom.
+  Future<PdfPageTextRegion> loadTextInRect(PdfRect rect);
+
+  /// Convert the page contents into a resolution independent [PdfPageDisplayList] that can be drawn at any scale
+  /// without rendering the page again.
+  ///
+  /// Paths, the filled text (as glyph outlines), images (decoded in their own resolution) and clip paths are
+  /// converted; null is returned if the page has anything that cannot be represented faithfully (shadings, dashed
+  /// lines, stroked text, fonts without glyph outlines, visible annotations if [enableAnnotations], ...) or the list
+  /// exceeds [maxBytes], and the page should be rendered by [render] instead.
+  ///
+  /// Not supported on Flutter Web; it always returns null.
+  Future<PdfPageDisplayList?> loadDisplayList({
+    bool enableAnnotations = true,
+    int maxBytes = 16 * 1024 * 1024,
+  });
+
+  /// Extract the page contents for the reflow mode (see `PdfReflowViewer`): the text in the reading order as
+  /// paragraphs of styled runs and the figures (images and vector drawings) to be rendered as cropped regions.
+  ///
+  /// The font size, weight and style of the runs are taken from the text of the page; the lines of a paragraph are
+  /// joined (dropping the hyphens at the line ends), so the paragraphs can be laid out as native text at any width.
+  ///
+  /// Not supported on Flutter Web.
+  Future<List<PdfReflowBlock>> loadReflowBlocks();
+
+  /// Get the index of the character at (or nearest to) ([x], [y]) in PDF page coordinates for [PdfTextPosition];
+  /// null if there is no character around the position.
+  Future<int?> getCharIndexAt(double x, double y, {double tolerance = 4});
+
+  /// Load the annotations on the page.
+  Future<List<PdfAnnotation>> loadAnnotations();
+
+  /// The limits exceeded by the renderings of the page so far (see [PdfRenderLimits]); the page is degraded if not
+  /// empty and the renderings of it are drafts.
+  Set<PdfRenderDegradation> get degradations => const {};
+}
+
+/// Budgets of a single rendering job to protect the app from pathological (malformed or adversarial) pages.
+///
+/// A rendering that exceeds any of the limits is not failed but returns a draft image; [PdfImage.degradations]
+/// tells which limits are applied and the page is also marked as degraded ([PdfPage.degradations]).
+///
+/// Not supported on Flutter Web; the limits are ignored.
+@immutable
+class PdfRenderLimits {
+  const PdfRenderLimits({
+    this.timeLimit,
+    this.maxBitmapBytes,
+    this.maxPageObjects,
+  });
+
+  /// The maximum time to render the page; the rendering is aborted at the limit and the image is what is rendered
+  /// so far. The time is checked between the page objects, so a single heavy object may exceed it.
+  final Duration? timeLimit;
+
+  /// The maximum size of the image in bytes (4 bytes per pixel); larger images are rendered at the lower resolution
+  /// that fits the limit, so the image is smaller than requested.
+  final int? maxBitmapBytes;
+
+  /// The maximum number of the page objects; pages with more objects are not rendered and the image is only filled
+  /// with the background color.
+  final int? maxPageObjects;
+
+  @override
+  bool operator ==(Object other) =>
+      other is PdfRenderLimits &&
+      other.timeLimit == timeLimit &&
+      other.maxBitmapBytes == maxBitmapBytes &&
+      other.maxPageObjects == maxPageObjects;
+
+  @override
+  int get hashCode =>
+      timeLimit.hashCode ^ maxBitmapBytes.hashCode ^ maxPageObjects.hashCode;
+}
+
+/// Limits of [PdfRenderLimits] applied to a rendering.
+enum PdfRenderDegradation {
+  /// Rendered at a lower resolution by [PdfRenderLimits.maxBitmapBytes].
+  bitmapSize,
+
+  /// Not rendered by [PdfRenderLimits.maxPageObjects].
+  pageObjects,
+
+  /// Aborted by [PdfRenderLimits.timeLimit].
+  timeLimit,
 }
 
 /// PDF permissions defined on PDF 32000-1:2008, Table 22.
@@ -204,6 +700,27 @@ class PdfPermissions {
   bool get allowsModifyAnnotations => (permissions & 32) != 0;
 }
 
+/// Pixel formats of [PdfPage.renderToBuffer] (PDFium's `FPDFBitmap_*` formats).
+enum PdfBitmapFormat {
+  /// 8-bit gray.
+  gray(1, 1),
+
+  /// 24-bit BGR.
+  bgr(2, 3),
+
+  /// 32-bit BGR; the 4th byte is unused.
+  bgrx(3, 4),
+
+  /// 32-bit BGRA.
+  bgra(4, 4);
+
+  const PdfBitmapFormat(this.pdfiumFormat, this.bytesPerPixel);
+
+  /// `FPDFBitmap_*` value.
+  final int pdfiumFormat;
+  final int bytesPerPixel;
+}
+
 /// Image rendered from PDF page.
 abstract class PdfImage {
   /// Number of pixels in horizontal direction.
@@ -218,7 +735,13 @@ abstract class PdfImage {
   /// Raw pixel data. The actual format is platform dependent.
   Uint8List get pixels;
 
+  /// The limits of [PdfRenderLimits] applied to the rendering; empty if the image is rendered as requested.
+  Set<PdfRenderDegradation> get degradations => const {};
+
   /// Dispose the image.
+  ///
+  /// On native platforms, the pixel buffer is also released when the image and [pixels] are garbage collected;
+  /// disposing the image just returns it earlier.
   void dispose();
 
   /// Create [ui.Image] from the rendered image.
@@ -230,6 +753,133 @@ abstract class PdfImage {
   }
 }
 
+/// Resolution independent drawing of a page; see [PdfPage.loadDisplayList].
+class PdfPageDisplayList {
+  PdfPageDisplayList({
+    required this.picture,
+    required this.width,
+    required this.height,
+    required this.byteSize,
+  });
+
+  /// The drawing of the page in [width] x [height] points (top-left origin); scale the canvas to draw it at any
+  /// size.
+  final ui.Picture picture;
+
+  /// Page width in points.
+  final double width;
+
+  /// Page height in points.
+  final double height;
+
+  /// Size of the serialized list in bytes, which roughly indicates the memory used by [picture].
+  final int byteSize;
+
+  /// Draw the page into [rect] of [canvas].
+  void paint(ui.Canvas canvas, Rect rect) {
+    canvas.save();
+    canvas.translate(rect.left, rect.top);
+    canvas.scale(rect.width / width, rect.height / height);
+    canvas.drawPicture(picture);
+    canvas.restore();
+  }
+
+  void dispose() => picture.dispose();
+}
+
+/// Block of the page contents in the reflow mode; see [PdfPage.loadReflowBlocks].
+abstract class PdfReflowBlock {
+  const PdfReflowBlock(this.rect);
+
+  /// Bounds of the block in PDF page coordinates.
+  final PdfRect rect;
+}
+
+/// Paragraph of the page text in the reflow mode.
+class PdfReflowParagraph extends PdfReflowBlock {
+  const PdfReflowParagraph(super.rect, this.runs);
+
+  /// Runs of the text in the same style.
+  final List<PdfReflowRun> runs;
+
+  /// The text of the paragraph.
+  String get text => runs.map((r) => r.text).join();
+}
+
+/// Figure (image or vector drawing) of the page in the reflow mode; it should be rendered as the cropped region
+/// [rect] of the page.
+class PdfReflowFigure extends PdfReflowBlock {
+  const PdfReflowFigure(super.rect);
+}
+
+/// Run of the text in the same style in [PdfReflowParagraph].
+@immutable
+class PdfReflowRun {
+  const PdfReflowRun({
+    required this.text,
+    required this.fontSize,
+    required this.fontWeight,
+    this.isItalic = false,
+    this.isMonospace = false,
+    this.isSerif = false,
+  });
+
+  final String text;
+
+  /// Font size in points.
+  final double fontSize;
+
+  /// Font weight in 100-900 (400 is normal and 700 is bold); -1 if unknown.
+  final int fontWeight;
+
+  final bool isItalic;
+  final bool isMonospace;
+  final bool isSerif;
+
+  @override
+  bool operator ==(Object other) {
+    if (identical(this, other)) return true;
+    return other is PdfReflowRun &&
+        other.text == text &&
+        other.fontSize == fontSize &&
+        other.fontWeight == fontWeight &&
+        other.isItalic == isItalic &&
+        other.isMonospace == isMonospace &&
+        other.isSerif == isSerif;
+  }
+
+  @override
+  int get hashCode =>
+      text.hashCode ^
+      fontSize.hashCode ^
+      fontWeight.hashCode ^
+      isItalic.hashCode ^
+      isMonospace.hashCode ^
+      isSerif.hashCode;
+}
+
+/// Characters within a rectangle of the page; see [PdfPage.loadTextInRect].
+class PdfPageTextRegion {
+  const PdfPageTextRegion({
+    required this.rect,
+    required this.text,
+    required this.charIndices,
+    required this.charRects,
+  });
+
+  /// The rectangle in PDF page coordinates.
+  final PdfRect rect;
+
+  /// The characters whose boxes intersect [rect] in the order on the page; no line breaks are inserted.
+  final String text;
+
+  /// Indices of the characters of [text] for [PdfTextPosition.charIndex].
+  final List<int> charIndices;
+
+  /// Boxes of the characters of [text] in PDF page coordinates.
+  final List<PdfRect> charRects;
+}
+
 /// Handles text extraction from PDF page.
 abstract class PdfPageText {
   /// Full text of the page.
@@ -352,6 +1002,348 @@ extension PdfRectsExt on Iterable<PdfRect> {
   PdfRect boundingRect() => reduce((a, b) => a.merge(b));
 }
 
+/// Annotation subtypes defined on PDF 32000-1:2008, 12.5.6 (in the order of PDFium's `FPDF_ANNOT_*`).
+enum PdfAnnotationSubtype {
+  unknown,
+  text,
+  link,
+  freeText,
+  line,
+  square,
+  circle,
+  polygon,
+  polyline,
+  highlight,
+  underline,
+  squiggly,
+  strikeOut,
+  stamp,
+  caret,
+  ink,
+  popup,
+  fileAttachment,
+  sound,
+  movie,
+  widget,
+  screen,
+  printerMark,
+  trapNet,
+  watermark,
+  threeD,
+  richMedia,
+  xfaWidget,
+  redact,
+}
+
+/// Annotation on a PDF page.
+///
+/// All the coordinates are in PDF page coordinates; [Offset.dx]/[Offset.dy] are x/y in the page coordinates.
+@immutable
+class PdfAnnotation {
+  const PdfAnnotation({
+    required this.subtype,
+    required this.flags,
+    required this.rect,
+    this.color,
+    this.interiorColor,
+    this.borderWidth = 0,
+    this.contents,
+    this.author,
+    this.subject,
+    this.modificationDate,
+    this.name,
+    this.attachmentPoints = const [],
+    this.inkPaths = const [],
+    this.vertices = const [],
+    this.line,
+  });
+
+  final PdfAnnotationSubtype subtype;
+
+  /// Annotation flags (PDF 32000-1:2008, 12.5.3).
+  final int flags;
+  final PdfRect rect;
+  final Color? color;
+  final Color? interiorColor;
+  final double borderWidth;
+
+  /// Text of the annotation (`Contents`).
+  final String? contents;
+
+  /// Author of the annotation (`T`).
+  final String? author;
+  final String? subject;
+
+  /// Modification date in PDF date format (`M`; e.g. `D:20240101120000+09'00'`).
+  final String? modificationDate;
+
+  /// Unique name of the annotation in the page (`NM`).
+  final String? name;
+
+  /// Quadrilaterals of text markup annotations (highlight, underline, etc.); each has 4 points.
+  final List<List<Offset>> attachmentPoints;
+
+  /// Paths of ink annotations.
+  final List<List<Offset>> inkPaths;
+
+  /// Vertices of polygon/polyline annotations.
+  final List<Offset> vertices;
+
+  /// Start/end points of line annotations.
+  final (Offset, Offset)? line;
+}
+
+/// Form field types (in the order of PDFium's `FPDF_FORMFIELD_*`).
+enum PdfFormFieldType {
+  unknown,
+  pushButton,
+  checkBox,
+  radioButton,
+  comboBox,
+  listBox,
+  textField,
+  signature,
+}
+
+/// Form field (widget) in a document; see [PdfDocument.loadFormFields].
+@immutable
+class PdfFormField {
+  const PdfFormField({
+    required this.pageNumber,
+    required this.annotationIndex,
+    required this.type,
+    required this.flags,
+    required this.rect,
+    required this.name,
+    required this.value,
+    this.isChecked,
+    this.options = const [],
+  });
+
+  final int pageNumber;
+
+  /// Index of the widget annotation on the page.
+  final int annotationIndex;
+  final PdfFormFieldType type;
+
+  /// Field flags (PDF 32000-1:2008, 12.7.3.1).
+  final int flags;
+  final PdfRect rect;
+
+  /// Fully qualified field name.
+  final String name;
+
+  /// Field value; empty if not set.
+  final String value;
+
+  /// Whether the check box/radio button is checked; null for other types.
+  final bool? isChecked;
+
+  /// Options of combo boxes/list boxes.
+  final List<PdfFormFieldOption> options;
+}
+
+/// Option of combo boxes/list boxes.
+@immutable
+class PdfFormFieldOption {
+  const PdfFormFieldOption(this.label, this.isSelected);
+  final String label;
+  final bool isSelected;
+}
+
+/// Update for a form field used by [PdfDocument.updateFormFields].
+///
+/// The update is applied to all the widgets of the field named [name] unless [widgetIndex] (the index in the
+/// widgets of the field in document order) is specified.
+@immutable
+class PdfFormFieldUpdate {
+  /// Set the text of a text field (or an editable combo box).
+  const PdfFormFieldUpdate.text(this.name, String this.text, {this.widgetIndex})
+      : kind = 0,
+        intValue = 0;
+
+  /// Check/uncheck a check box; for radio buttons, check the widget specified by [widgetIndex].
+  const PdfFormFieldUpdate.checked(this.name, bool checked, {this.widgetIndex})
+      : kind = 1,
+        intValue = checked ? 1 : 0,
+        text = null;
+
+  /// Select the option at [optionIndex] of a combo box/list box.
+  const PdfFormFieldUpdate.select(this.name, int optionIndex,
+      {this.widgetIndex})
+      : kind = 2,
+        intValue = optionIndex,
+        text = null;
+
+  final String name;
+  final int? widgetIndex;
+
+  /// Update kind; 0: text, 1: checked, 2: select.
+  final int kind;
+  final int intValue;
+  final String? text;
+}
+
+/// Fingerprint of a document content; see [PdfDocument.computeFingerprint].
+@immutable
+class PdfDocumentFingerprint {
+  const PdfDocumentFingerprint({
+    required this.hash,
+    required this.fileSize,
+    required this.sampled,
+    this.fileIdentifier,
+  });
+
+  /// 64-bit hash (XXH64 based) of the content combined with [fileIdentifier].
+  final int hash;
+
+  /// Size of the file in bytes.
+  final int fileSize;
+
+  /// Whether the fingerprint is computed from the sampled blocks of the file.
+  final bool sampled;
+
+  /// Permanent file identifier (the first element of the trailer ID) in hex if the document has one.
+  final String? fileIdentifier;
+
+  /// String representation suitable for cache keys.
+  String get value =>
+      '${sampled ? 's' : 'f'}${hash.toUnsigned(64).toRadixString(16).padLeft(16, '0')}-$fileSize';
+
+  @override
+  bool operator ==(Object other) =>
+      other is PdfDocumentFingerprint &&
+      other.hash == hash &&
+      other.fileSize == fileSize &&
+      other.sampled == sampled;
+
+  @override
+  int get hashCode => hash ^ fileSize;
+
+  @override
+  String toString() => value;
+}
+
+/// Block hash manifest of a file used by [PdfDocument.openUriSynced] to find the changed blocks.
+///
+/// The JSON form is `{"version":1,"size":<file size>,"blockSize":4194304,"hash":"xxh64","blocks":[...]}` where
+/// `blocks[i]` is the 16 digit hex XXH64 of the i-th [blockSize] byte block (the last one may be shorter) seeded by
+/// `i`; it is the same chunk hash as [PdfDocument.computeFingerprint], so any XXH64 implementation can generate it.
+@immutable
+class PdfBlockManifest {
+  const PdfBlockManifest({
+    required this.size,
+    required this.blocks,
+    this.blockSize = defaultBlockSize,
+  });
+
+  /// The only block size supported; the native chunk size of the fingerprint.
+  static const defaultBlockSize = 4 * 1024 * 1024;
+
+  /// Size of the file in bytes.
+  final int size;
+
+  /// Size of the blocks in bytes.
+  final int blockSize;
+
+  /// 64-bit hashes of the blocks.
+  final List<int> blocks;
+
+  /// Create the manifest of the file at [filePath] (e.g. to be published along with the file by the server).
+  static Future<PdfBlockManifest> fromFile(String filePath) =>
+      PdfDocumentFactory.instance.createBlockManifest(filePath);
+
+  /// Parse the JSON form; returns null if it is malformed or of an unsupported format.
+  static PdfBlockManifest? tryParse(String json) {
+    try {
+      final m = jsonDecode(json);
+      if (m is! Map ||
+          m['version'] != 1 ||
+          m['hash'] != 'xxh64' ||
+          m['blockSize'] != defaultBlockSize) {
+        return null;
+      }
+      final size = m['size'] as int;
+      final blocks = (m['blocks'] as List).cast<String>();
+      if (size < 0 ||
+          blocks.length != (size + defaultBlockSize - 1) ~/ defaultBlockSize) {
+        return null;
+      }
+      return PdfBlockManifest(
+        size: size,
+        // 16 hex digits may not fit in int.parse
+        blocks: blocks
+            .map((h) =>
+                int.parse(h.substring(0, 8), radix: 16) << 32 |
+                int.parse(h.substring(8, 16), radix: 16))
+            .toList(growable: false),
+      );
+    } catch (e) {
+      return null;
+    }
+  }
+
+  /// The JSON form.
+  String toJson() => jsonEncode({
+        'version': 1,
+        'size': size,
+        'blockSize': blockSize,
+        'hash': 'xxh64',
+        'blocks': blocks
+            .map((h) =>
+                (h >>> 32).toRadixString(16).padLeft(8, '0') +
+                (h & 0xffffffff).toRadixString(16).padLeft(8, '0'))
+            .toList(),
+      });
+}
+
+/// Statistics of the synchronization by [PdfDocument.openUriSynced].
+@immutable
+class PdfSyncResult {
+  const PdfSyncResult({
+    required this.fileSize,
+    required this.blockCount,
+    required this.fetchedBlockCount,
+    required this.fetchedBytes,
+    required this.fullDownload,
+  });
+
+  /// Size of the synchronized file in bytes.
+  final int fileSize;
+
+  /// Number of the blocks of the file; 0 if the manifest is not available.
+  final int blockCount;
+
+  /// Number of the blocks downloaded.
+  final int fetchedBlockCount;
+
+  /// Number of the bytes downloaded (excluding the manifest).
+  final int fetchedBytes;
+
+  /// Whether the whole file is downloaded.
+  final bool fullDownload;
+
+  @override
+  String toString() =>
+      'PdfSyncResult(fileSize: $fileSize, blocks: $fetchedBlockCount/$blockCount, fetchedBytes: $fetchedBytes'
+      '${fullDownload ? ', full download' : ''})';
+}
+
+/// Embedded file (attachment) in a document; see [PdfDocument.loadAttachments].
+@immutable
+class PdfAttachment {
+  const PdfAttachment(this.index, this.name);
+
+  /// Index of the attachment in the document.
+  final int index;
+
+  /// File name of the attachment.
+  final String name;
+
+  @override
+  String toString() => 'PdfAttachment($index, $name)';
+}
+
 /// Link in PDF page.
 @immutable
 class PdfLink {
@@ -0,0 +1,170 @@
+import 'dart:collection';
+import 'dart:math';
+
+/// Greedy-Dual-Size-Frequency (GDSF) eviction policy for the per-page caches of `PdfViewer`.
+///
+/// Each page in the cache has the priority
+///
+/// ```
+/// H = L + frequency * cost / (bytes * (1 + distance))
+/// ```
+///
+/// - `cost` is the measured time to re-create the cached data (render time)
+/// - `bytes` is the memory consumed by the cached data
+/// - `distance` is the distance of the page to the viewport in viewport sizes, which is updated when the page is
+///   touched on paints and, for all the pages, on eviction (the pages out of the viewport are not touched)
+/// - `frequency` is the number of times the page came back into view
+/// - `L` is the inflation value; it is raised to the priority of each evicted page so that the pages not touched for
+///   a while age out without updating them
+///
+/// The pages are kept ordered by the priority in a [SplayTreeSet] and a page is re-positioned only when it is put or
+/// touched, or when the distances are refreshed on eviction; paints within the budgets never sort the whole cache.
+class PdfCacheEvictionPolicy {
+  /// Upper bound of the frequency; a page that has been viewed many times should not outlive the others forever.
+  static const maxFrequency = 8;
+
+  final _entries = <int, _PdfCacheEntry>{};
+  final _queue = SplayTreeSet<_PdfCacheEntry>(_PdfCacheEntry.compare);
+
+  double _inflation = 0;
+  int _bytes = 0;
+  int _paintCount = 0;
+
+  /// Average cost (microseconds) per byte of the measured entries, used for the entries of unknown cost.
+  double _costPerByte = 0;
+
+  /// Total bytes of the cached pages.
+  int get bytes => _bytes;
+
+  /// Number of the cached pages.
+  int get length => _entries.length;
+
+  bool contains(int pageNumber) => _entries.containsKey(pageNumber);
+
+  /// Notify the start of a paint; a page touched on a paint but not on the previous one is counted as a new use.
+  void beginPaint() => _paintCount++;
+
+  /// Add the page or update its size.
+  ///
+  /// [cost] is the time taken to create the data; if null, the previously measured cost (or the average cost per
+  /// byte of the other pages) is used.
+  void put(int pageNumber, int bytes, {Duration? cost, double distance = 0}) {
+    var entry = _entries[pageNumber];
+    if (entry == null) {
+      entry = _entries[pageNumber] = _PdfCacheEntry(pageNumber);
+    } else {
+      _queue.remove(entry);
+      _bytes -= entry.bytes;
+    }
+    entry.bytes = max(bytes, 1);
+    _bytes += entry.bytes;
+    if (cost != null) {
+      entry.cost = max(cost.inMicroseconds, 1).toDouble();
+      final costPerByte = entry.cost / entry.bytes;
+      _costPerByte = _costPerByte == 0
+          ? costPerByte
+          : _costPerByte * 0.8 + costPerByte * 0.2;
+    }
+    entry.lastPaint = _paintCount;
+    entry.inflation = _inflation;
+    entry.priority = _priority(entry, distance);
+    _queue.add(entry);
+  }
+
+  /// Update the priority of the page painted at [distance] from the viewport.
+  void touch(int pageNumber, double distance) {
+    final entry = _entries[pageNumber];
+    if (entry == null) return;
+    if (entry.lastPaint < _paintCount - 1) {
+      entry.frequency = min(entry.frequency + 1, maxFrequency);
+    }
+    entry.lastPaint = _paintCount;
+    entry.inflation = _inflation;
+    final priority = _priority(entry, distance);
+    if (priority == entry.priority) return;
+    _queue.remove(entry);
+    entry.priority = priority;
+    _queue.add(entry);
+  }
+
+  void remove(int pageNumber) {
+    final entry = _entries.remove(pageNumber);
+    if (entry == null) return;
+    _queue.remove(entry);
+    _bytes -= entry.bytes;
+  }
+
+  void clear() {
+    _entries.clear();
+    _queue.clear();
+    _bytes = 0;
+    _inflation = 0;
+  }
+
+  /// Evict the pages of the lowest priority until the cache fits in [maxBytes] (if not null) and [maxCount].
+  ///
+  /// [distanceOf] returns the current distance of the page to the viewport; the priorities of all the pages are
+  /// updated with it before choosing the pages to evict because the pages out of the viewport are not touched.
+  /// The pages for which [isPinned] returns true are never evicted, even if the cache does not fit in the budget
+  /// without them. [onEvict] is called for each evicted page to release the data.
+  void evict({
+    required int? maxBytes,
+    required int maxCount,
+    required double Function(int pageNumber) distanceOf,
+    required bool Function(int pageNumber) isPinned,
+    required void Function(int pageNumber) onEvict,
+  }) {
+    bool fits(int bytes, int count) =>
+        (maxBytes == null || bytes <= maxBytes) && count <= maxCount;
+    if (fits(_bytes, _entries.length)) return;
+    _queue.clear();
+    for (final entry in _entries.values) {
+      entry.priority = _priority(entry, distanceOf(entry.pageNumber));
+      _queue.add(entry);
+    }
+    final victims = <_PdfCacheEntry>[];
+    var bytes = _bytes;
+    var count = _entries.length;
+    for (final entry in _queue) {
+      if (fits(bytes, count)) break;
+      if (isPinned(entry.pageNumber)) continue;
+      victims.add(entry);
+      bytes -= entry.bytes;
+      count--;
+    }
+    for (final entry in victims) {
+      remove(entry.pageNumber);
+      _inflation = max(_inflation, entry.priority);
+      onEvict(entry.pageNumber);
+    }
+  }
+
+  double _priority(_PdfCacheEntry entry, double distance) {
+    final cost = entry.cost > 0
+        ? entry.cost
+        : max(entry.bytes * _costPerByte, 1.0);
+    return entry.inflation +
+        entry.frequency * cost / (entry.bytes * (1 + max(distance, 0.0)));
+  }
+}
+
+class _PdfCacheEntry {
+  _PdfCacheEntry(this.pageNumber);
+
+  final int pageNumber;
+  int bytes = 1;
+
+  /// Measured cost in microseconds; 0 if unknown.
+  double cost = 0;
+  int frequency = 1;
+  int lastPaint = 0;
+
+  /// The inflation value when the page was last put or touched; it keeps the page aging on re-prioritization.
+  double inflation = 0;
+  double priority = 0;
+
+  static int compare(_PdfCacheEntry a, _PdfCacheEntry b) {
+    final c = a.priority.compareTo(b.priority);
+    return c != 0 ? c : a.pageNumber.compareTo(b.pageNumber);
+  }
+}
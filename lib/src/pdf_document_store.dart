@@ -1,3 +1,6 @@
+import 'dart:collection';
+import 'dart:ui' as ui;
+
 import 'package:flutter/material.dart';
 import 'package:synchronized/extension.dart';
 
@@ -14,6 +17,14 @@ class PdfDocumentRef extends Listenable {
   final _listeners = <VoidCallback>{};
   PdfDocument? _document;
   Object? _error;
+  PdfCancellationToken? _loadingToken;
+  bool _disposed = false;
+
+  /// Rendered images and texts retained while the document is in the warm pool of the [store].
+  ///
+  /// [PdfViewer] puts its caches here when it releases the document and takes them back when it
+  /// uses the document again.
+  final warmCache = PdfDocumentWarmCache();
 
   /// The [PdfDocument] instance if available.
   PdfDocument? get document => _document;
@@ -21,16 +32,23 @@ class PdfDocumentRef extends Listenable {
   /// The error object if some error was occurred on the previous attempt to load the document.
   Object? get error => _error;
 
+  /// Whether the document is kept in the warm pool of the [store] (no one is listening to it).
+  bool get isWarm => store._warmPool.contains(this);
+
   @override
   void addListener(VoidCallback listener) {
     _listeners.add(listener);
+    store._warmPool.remove(this);
   }
 
   @override
   void removeListener(VoidCallback listener) {
     _listeners.remove(listener);
     if (_listeners.isEmpty) {
-      dispose();
+      store._release(this);
+    } else {
+      // the caches put by the removed listener count against the budget as well
+      store._trimWarmPool();
     }
   }
 
@@ -41,19 +59,149 @@ class PdfDocumentRef extends Listenable {
   }
 
   void dispose() {
+    _disposed = true;
+    store._warmPool.remove(this);
+    warmCache.clear();
     store._docRefs.remove(sourceName);
     _listeners.clear();
+    // abort the loading if the document is not loaded yet
+    _loadingToken?.cancel();
+    _loadingToken = null;
     _document?.dispose();
     _document = null;
   }
 }
 
+/// Rendered images and texts of a document retained with [PdfDocumentRef.warmCache].
+class PdfDocumentWarmCache {
+  /// Thumbnail images by page number.
+  final thumbs = <int, ui.Image>{};
+
+  /// Real-size images (and the scale used to render them) by page number.
+  final realSized = <int, ({ui.Image image, double scale})>{};
+
+  /// Loaded texts by page number.
+  final pageTexts = <int, PdfPageText>{};
+
+  bool get isEmpty => thumbs.isEmpty && realSized.isEmpty && pageTexts.isEmpty;
+
+  /// Estimated memory consumption of the cached images and texts in bytes.
+  int get estimatedBytes {
+    int bytes = 0;
+    for (final image in thumbs.values) {
+      bytes += image.width * image.height * 4;
+    }
+    for (final entry in realSized.values) {
+      bytes += entry.image.width * entry.image.height * 4;
+    }
+    for (final text in pageTexts.values) {
+      // UTF-16 text + bounding boxes (4 doubles) for each character (roughly)
+      bytes += text.fullText.length * (2 + 32) + text.fragments.length * 64;
+    }
+    return bytes;
+  }
+
+  /// Drop the real-size images (they are much larger than the others and can be re-rendered from thumbnails).
+  void clearRealSized() => realSized.clear();
+
+  void clear() {
+    thumbs.clear();
+    realSized.clear();
+    pageTexts.clear();
+  }
+}
+
 /// A store to maintain [PdfDocumentRef] instances.
 ///
 /// [PdfViewer] instances using the same [PdfDocumentStore] share the same [PdfDocumentRef] instances.
+///
+/// By default, a document is closed when the last [PdfViewer] releases it. With a positive
+/// [warmPoolByteBudget], the document is instead kept open in the warm pool with its
+/// [PdfDocumentRef.warmCache] so that switching back to the document (e.g. on a tabbed UI) does not pay
+/// the cold open and re-rendering again; note that the pooled documents keep their native resources
+/// (and the file handles) until they are evicted from the pool or [clearWarmPool] is called.
+/// The pool is limited by [warmPoolByteBudget] and [warmPoolMaxDocuments]; the least recently released
+/// documents are closed first.
 class PdfDocumentStore {
+  PdfDocumentStore({
+    this.warmPoolByteBudget = 0,
+    this.warmPoolMaxDocuments = 4,
+  });
+
+  /// Estimated bytes that the warm pool may consume; 0 (the default) to disable the warm pool.
+  ///
+  /// The budget covers the documents in the pool and the [PdfDocumentRef.warmCache] of all the documents
+  /// including the ones still used by other listeners. Native memory consumption of the documents is unknown
+  /// and estimated by [estimatedBytesPerPage].
+  final int warmPoolByteBudget;
+
+  /// Maximum number of the documents in the warm pool; 0 to disable the warm pool.
+  final int warmPoolMaxDocuments;
+
+  /// Estimated native memory consumption (parsed page objects) of a page.
+  static const estimatedBytesPerPage = 16 * 1024;
+
   final _docRefs = <String, PdfDocumentRef>{};
 
+  /// Documents nobody is listening to; ordered from the least recently released.
+  final _warmPool = LinkedHashSet<PdfDocumentRef>();
+
+  /// Estimated bytes consumed by the documents in the warm pool and the warm caches of all the documents.
+  int get warmPoolBytes => _docRefs.values.fold(0,
+      (sum, docRef) => sum + _estimateBytes(docRef, isWarm: docRef.isWarm));
+
+  static int _estimateBytes(PdfDocumentRef docRef, {required bool isWarm}) =>
+      (isWarm
+          ? (docRef.document?.pages.length ?? 0) * estimatedBytesPerPage
+          : 0) +
+      docRef.warmCache.estimatedBytes;
+
+  void _release(PdfDocumentRef docRef) {
+    if (docRef.document == null ||
+        warmPoolByteBudget <= 0 ||
+        warmPoolMaxDocuments <= 0) {
+      docRef.dispose();
+      return;
+    }
+    _warmPool.remove(docRef);
+    _warmPool.add(docRef);
+    _trimWarmPool();
+  }
+
+  void _trimWarmPool() {
+    while (_warmPool.length > warmPoolMaxDocuments) {
+      _warmPool.first.dispose();
+    }
+    var bytes = warmPoolBytes;
+    if (bytes <= warmPoolByteBudget) return;
+    // the documents in use come first; their viewers can re-render the images anyway
+    final inUse = _docRefs.values.where((docRef) => !docRef.isWarm).toList();
+    // first, drop real-size images from the documents in use and then the older documents in the pool
+    for (final docRef in [...inUse, ..._warmPool]) {
+      final before = docRef.warmCache.estimatedBytes;
+      docRef.warmCache.clearRealSized();
+      bytes -= before - docRef.warmCache.estimatedBytes;
+      if (bytes <= warmPoolByteBudget) return;
+    }
+    for (final docRef in inUse) {
+      bytes -= docRef.warmCache.estimatedBytes;
+      docRef.warmCache.clear();
+      if (bytes <= warmPoolByteBudget) return;
+    }
+    while (_warmPool.isNotEmpty && bytes > warmPoolByteBudget) {
+      final docRef = _warmPool.first;
+      bytes -= _estimateBytes(docRef, isWarm: true);
+      docRef.dispose();
+    }
+  }
+
+  /// Close all the documents in the warm pool (e.g. on memory pressure).
+  void clearWarmPool() {
+    for (final docRef in _warmPool.toList()) {
+      docRef.dispose();
+    }
+  }
+
   /// Load a [PdfDocumentRef] from the store.
   ///
   /// The returned [PdfDocumentRef] may or may not hold a [PdfDocument] instance depending on
@@ -69,6 +217,23 @@ class PdfDocumentStore {
     String sourceName, {
     required Future<PdfDocument> Function() documentLoader,
     bool retryIfError = false,
+  }) =>
+      loadCancellable(
+        sourceName,
+        documentLoader: (_) => documentLoader(),
+        retryIfError: retryIfError,
+      );
+
+  /// Load a [PdfDocumentRef] from the store with a cancellable [documentLoader].
+  ///
+  /// The function works just like [load] but [documentLoader] receives a [PdfCancellationToken] that is
+  /// canceled when the [PdfDocumentRef] is disposed (e.g. the last [PdfViewer] using it is removed) before
+  /// the loading completes; pass it to [PdfDocument.openUri]/[PdfDocument.openCustom] to abort the loading.
+  PdfDocumentRef loadCancellable(
+    String sourceName, {
+    required Future<PdfDocument> Function(PdfCancellationToken token)
+        documentLoader,
+    bool retryIfError = false,
   }) {
     final docRef = _docRefs.putIfAbsent(
         sourceName, () => PdfDocumentRef._(this, sourceName, null, null));
@@ -84,12 +249,27 @@ class PdfDocumentStore {
       if (docRef.document != null) {
         return docRef;
       }
+      if (docRef._disposed) {
+        return docRef;
+      }
+      final token = docRef._loadingToken = PdfCancellationToken();
       try {
-        docRef._document = await documentLoader();
+        final document = await documentLoader(token);
+        if (docRef._disposed) {
+          // the loader did not respect the cancellation
+          await document.dispose();
+          return docRef;
+        }
+        docRef._document = document;
         docRef._error = null;
       } catch (e) {
         docRef._document = null;
         docRef._error = e;
+      } finally {
+        if (docRef._loadingToken == token) docRef._loadingToken = null;
+      }
+      if (docRef._disposed) {
+        return docRef;
       }
       docRef.notifyListeners();
     });
@@ -99,10 +279,11 @@ class PdfDocumentStore {
 
   /// Dispose the store.
   void dispose() {
-    for (final document in _docRefs.values) {
+    for (final document in _docRefs.values.toList()) {
       document.dispose();
     }
     _docRefs.clear();
+    _warmPool.clear();
   }
 
   /// Returns the default store.
@@ -2,13 +2,15 @@ import 'dart:io';
 import 'dart:math';
 import 'dart:typed_data';
 
+import 'package:flutter/foundation.dart' show listEquals;
 import 'package:http/http.dart' as http;
+import 'package:synchronized/extension.dart';
 
 import '../pdfrx.dart';
 
 /// PDF file cache for downloading (Non-web).
 ///
-/// See [PdfFileCacheNative] and [PdfFileCacheMemory] for actual implementation.
+/// See [PdfFileCacheTiered], [PdfFileCacheNative] and [PdfFileCacheMemory] for actual implementation.
 abstract class PdfFileCache {
   PdfFileCache({this.cacheBlockSize = 1024 * 256});
 
@@ -48,10 +50,14 @@ abstract class PdfFileCache {
   Future<void> read(
       List<int> buffer, int bufferPosition, int position, int size);
 
+  /// Release the resources (e.g. temporary files) of the cache; the caches created by [createDefault] are closed
+  /// when the document is disposed.
+  Future<void> close() async {}
+
   /// Function to create [PdfFileCache] for the specified URI.
   /// You can override this to use your own cache.
   static PdfFileCache Function(Uri uri) createDefault =
-      (uri) => PdfFileCacheMemory();
+      (uri) => PdfFileCacheTiered();
 }
 
 /// PDF file cache backed by a file.
@@ -119,38 +125,284 @@ class PdfFileCacheMemory extends PdfFileCache {
   }
 }
 
+/// PDF file cache that keeps the frequently read blocks on memory and spills the others to a temporary file.
+///
+/// The blocks on memory are limited to [memoryBudget] bytes. When the budget is exceeded, the least frequently read
+/// block is moved to the temporary file, which is a sparse file of the size of the PDF file where each block is
+/// stored at its own position. A block on the file is moved back to memory when it is read more frequently than the
+/// coldest block on memory. The read counts are halved periodically so that the recent reads weigh more.
+///
+/// Because the code internally uses `dart:io`'s [File], it is not available on the web.
+class PdfFileCacheTiered extends PdfFileCache {
+  PdfFileCacheTiered({
+    this.memoryBudget = 32 * 1024 * 1024,
+    Directory? tempDirectory,
+    super.cacheBlockSize,
+  }) : _tempDirectory = tempDirectory;
+
+  /// The maximum bytes of the blocks kept on memory; at least one block is kept regardless.
+  final int memoryBudget;
+
+  final Directory? _tempDirectory;
+
+  /// Blocks on memory.
+  final _memoryBlocks = <int, Uint8List>{};
+  int _memoryBytes = 0;
+
+  /// Blocks written to the temporary file (with their sizes); a block can be on both memory and the file.
+  final _fileBlocks = <int, int>{};
+
+  /// Read counts of the blocks.
+  final _readCounts = <int, int>{};
+  int _readsSinceAging = 0;
+  static const _agingInterval = 1024;
+
+  Directory? _spillDirectory;
+  RandomAccessFile? _spillFile;
+  int? _fileSize;
+
+  @override
+  set fileSize(int value) {
+    super.fileSize = value;
+    _fileSize = value;
+  }
+
+  @override
+  String? get filePath => null;
+
+  @override
+  Uint8List? get buffer => null;
+
+  /// Number of bytes of the blocks on memory.
+  int get memoryBytes => _memoryBytes;
+
+  /// Write [bytes] at [position].
+  ///
+  /// A block is stored only if [bytes] covers all of it (up to the end of the file for the last block); the blocks
+  /// partially covered are updated if they are already cached and contiguous with [bytes], and ignored otherwise
+  /// because the rest of them is unknown.
+  @override
+  Future<void> write(int position, List<int> bytes) => synchronized(() async {
+        final end = position + bytes.length;
+        for (int p = position; p < end;) {
+          final blockId = p ~/ cacheBlockSize;
+          final blockStart = blockId * cacheBlockSize;
+          final blockEnd = min(blockStart + cacheBlockSize,
+              _fileSize ?? blockStart + cacheBlockSize);
+          final writeEnd = min(end, blockStart + cacheBlockSize);
+          Uint8List? block;
+          if (p == blockStart && writeEnd >= blockEnd) {
+            block = Uint8List(writeEnd - p)
+              ..setRange(0, writeEnd - p, bytes, p - position);
+          } else {
+            final cached =
+                _memoryBlocks[blockId] ?? await _readFileBlock(blockId);
+            if (cached != null && p - blockStart <= cached.length) {
+              block = Uint8List(max(cached.length, writeEnd - blockStart))
+                ..setAll(0, cached)
+                ..setRange(
+                    p - blockStart, writeEnd - blockStart, bytes, p - position);
+            }
+          }
+          if (block != null) {
+            _memoryBytes -= _memoryBlocks[blockId]?.length ?? 0;
+            _memoryBlocks[blockId] = block;
+            _memoryBytes += block.length;
+            _fileBlocks.remove(blockId);
+            await _evict(keep: blockId);
+          }
+          p = writeEnd;
+        }
+      });
+
+  @override
+  Future<void> read(
+          List<int> buffer, int bufferPosition, int position, int size) =>
+      synchronized(() async {
+        final end = position + size;
+        for (int p = position; p < end;) {
+          final blockId = p ~/ cacheBlockSize;
+          final blockStart = blockId * cacheBlockSize;
+          final readEnd = min(end, blockStart + cacheBlockSize);
+          final block = await _readBlock(blockId);
+          buffer.setRange(bufferPosition, bufferPosition + readEnd - p, block,
+              p - blockStart);
+          bufferPosition += readEnd - p;
+          p = readEnd;
+        }
+      });
+
+  Future<Uint8List> _readBlock(int blockId) async {
+    final count = (_readCounts[blockId] ?? 0) + 1;
+    _readCounts[blockId] = count;
+    if (++_readsSinceAging >= _agingInterval) {
+      _readsSinceAging = 0;
+      _readCounts.updateAll((_, count) => count >> 1);
+    }
+
+    final block = _memoryBlocks[blockId];
+    if (block != null) return block;
+    final data = await _readFileBlock(blockId);
+    if (data == null) {
+      throw StateError('Block $blockId is not cached.');
+    }
+
+    // promote the block if it is read more frequently than the coldest block on memory
+    final coldest = _coldestMemoryBlock();
+    if (_memoryBytes + data.length <= memoryBudget ||
+        (coldest != null && (_readCounts[coldest] ?? 0) < count)) {
+      _memoryBlocks[blockId] = data;
+      _memoryBytes += data.length;
+      await _evict(keep: blockId);
+    }
+    return data;
+  }
+
+  /// Read the block from the temporary file; null if it is not on the file.
+  Future<Uint8List?> _readFileBlock(int blockId) async {
+    final size = _fileBlocks[blockId];
+    if (size == null) return null;
+    final file = _spillFile!;
+    await file.setPosition(blockId * cacheBlockSize);
+    return await file.read(size);
+  }
+
+  int? _coldestMemoryBlock({int? except}) {
+    int? coldest;
+    var coldestCount = 0;
+    for (final blockId in _memoryBlocks.keys) {
+      if (blockId == except) continue;
+      final count = _readCounts[blockId] ?? 0;
+      if (coldest == null || count < coldestCount) {
+        coldest = blockId;
+        coldestCount = count;
+      }
+    }
+    return coldest;
+  }
+
+  /// Move the coldest blocks (but [keep]) to the temporary file until the blocks on memory fit in the budget.
+  Future<void> _evict({required int keep}) async {
+    while (_memoryBytes > memoryBudget) {
+      final blockId = _coldestMemoryBlock(except: keep);
+      if (blockId == null) return;
+      final block = _memoryBlocks.remove(blockId)!;
+      _memoryBytes -= block.length;
+      if (_fileBlocks.containsKey(blockId)) continue; // already on the file
+      final file = await _openSpillFile();
+      await file.setPosition(blockId * cacheBlockSize);
+      await file.writeFrom(block);
+      _fileBlocks[blockId] = block.length;
+    }
+  }
+
+  Future<RandomAccessFile> _openSpillFile() async {
+    if (_spillFile != null) return _spillFile!;
+    final dir = await (_tempDirectory ?? Directory.systemTemp)
+        .createTemp('pdfrx-cache');
+    _spillDirectory = dir;
+    final file = await File('${dir.path}/blocks').open(mode: FileMode.write);
+    // sparse; the blocks are stored at their own positions
+    if (_fileSize != null) await file.truncate(_fileSize!);
+    return _spillFile = file;
+  }
+
+  @override
+  Future<void> close() => synchronized(() async {
+        _memoryBlocks.clear();
+        _memoryBytes = 0;
+        _fileBlocks.clear();
+        _readCounts.clear();
+        await _spillFile?.close();
+        _spillFile = null;
+        try {
+          await _spillDirectory?.delete(recursive: true);
+        } catch (e) {
+          // the temporary directory is cleaned up by the OS anyway
+        }
+        _spillDirectory = null;
+      });
+}
+
 /// Open PDF file from [uri].
 ///
 /// On web, unlike [PdfDocument.openUri], this function uses HTTP's range request to download the file and uses [PdfFileCache].
+///
+/// [cancellationToken] and [timeout] abort the in-flight HTTP requests and the document loading; see
+/// [PdfDocument.openUri] for more info.
 Future<PdfDocument> pdfDocumentFromUri(
   Uri uri, {
   String? password,
   PdfFileCache? cache,
+  PdfCancellationToken? cancellationToken,
+  Duration? timeout,
 }) async {
+  final ownsCache = cache == null;
   cache ??= PdfFileCache.createDefault(uri);
 
+  final token = PdfCancellationToken.withTimeout(cancellationToken, timeout);
+  token?.throwIfCanceled();
+  // closing the client aborts the requests in flight
+  final client = http.Client();
+  void abort() => client.close();
+  token?.addListener(abort);
+  void detach() => token?.removeListener(abort);
+  void release() {
+    detach();
+    client.close();
+    if (ownsCache) cache!.close();
+  }
+
+  var fileSizeSet = false;
   Future<({int fileSize, bool fullDownload})> cacheBlock(int blockId,
       {int blockCountToCache = 1}) async {
-    int? fileSize;
+    final int fileSize;
     final blockOffset = blockId * cache!.cacheBlockSize;
     final end = blockOffset + cache.cacheBlockSize * blockCountToCache;
-    final response = await http
-        .get(uri, headers: {'Range': 'bytes=$blockOffset-${end - 1}'});
+    final http.Response response;
+    try {
+      response = await client
+          .get(uri, headers: {'Range': 'bytes=$blockOffset-${end - 1}'});
+    } catch (e) {
+      token?.throwIfCanceled();
+      rethrow;
+    }
+    token?.throwIfCanceled();
     final contentRange = response.headers['content-range'];
     bool fullDownload = false;
     if (response.statusCode == 206 && contentRange != null) {
       final m = RegExp(r'bytes (\d+)-(\d+)/(\d+)').firstMatch(contentRange);
       fileSize = int.parse(m!.group(3)!);
     } else {
-      fileSize = response.contentLength;
+      // the body is the whole file; Content-Length may be missing on chunked responses
+      fileSize = response.bodyBytes.length;
       fullDownload = true;
     }
+    // the size should be known to the cache before the first write; the last block, which is shorter than the
+    // others, is stored only if the cache knows where the file ends
+    if (!fileSizeSet) {
+      cache.fileSize = fileSize;
+      cache.cacheBlockCount =
+          (fileSize + cache.cacheBlockSize - 1) ~/ cache.cacheBlockSize;
+      fileSizeSet = true;
+    }
     await cache.write(blockOffset, response.bodyBytes);
-    return (fileSize: fileSize!, fullDownload: fullDownload);
+    return (fileSize: fileSize, fullDownload: fullDownload);
   }
 
-  final result = await cacheBlock(0);
+  final ({int fileSize, bool fullDownload}) result;
+  try {
+    result = await cacheBlock(0);
+  } catch (e) {
+    release();
+    token?.complete();
+    rethrow;
+  }
   if (result.fullDownload) {
+    if (cache.filePath != null || cache.buffer != null) {
+      release();
+      token?.complete();
+    }
     if (cache.filePath != null) {
       return PdfDocumentFactory.instance.openFile(
         cache.filePath!,
@@ -165,9 +417,6 @@ Future<PdfDocument> pdfDocumentFromUri(
       );
     }
   }
-  cache.fileSize = result.fileSize;
-  cache.cacheBlockCount =
-      (result.fileSize + cache.cacheBlockSize - 1) ~/ cache.cacheBlockSize;
 
   late List<bool> avails;
   if (result.fullDownload) {
@@ -178,30 +427,245 @@ Future<PdfDocument> pdfDocumentFromUri(
     cache.isBlockCached = (blockId) => avails[blockId];
   }
 
-  return PdfDocument.openCustom(
-    read: (buffer, position, size) async {
-      final totalSize = size;
-      final end = position + size;
-      int bufferPosition = 0;
-      for (int p = position; p < end;) {
-        final blockId = p ~/ cache!.cacheBlockSize;
-        final isAvailable = cache.isBlockCached(blockId);
-        if (!isAvailable) {
-          await cacheBlock(blockId);
-          if (!result.fullDownload) {
-            avails[blockId] = true;
+  try {
+    return await PdfDocument.openCustom(
+      read: (buffer, position, size) async {
+        final totalSize = size;
+        final end = position + size;
+        int bufferPosition = 0;
+        for (int p = position; p < end;) {
+          final blockId = p ~/ cache!.cacheBlockSize;
+          final isAvailable = cache.isBlockCached(blockId);
+          if (!isAvailable) {
+            await cacheBlock(blockId);
+            if (!result.fullDownload) {
+              avails[blockId] = true;
+            }
           }
+          final readEnd = min(p + size, (blockId + 1) * cache.cacheBlockSize);
+          final sizeToRead = readEnd - p;
+          await cache.read(buffer, bufferPosition, p, sizeToRead);
+          p += sizeToRead;
+          bufferPosition += sizeToRead;
+          size -= sizeToRead;
         }
-        final readEnd = min(p + size, (blockId + 1) * cache.cacheBlockSize);
-        final sizeToRead = readEnd - p;
-        await cache.read(buffer, bufferPosition, p, sizeToRead);
-        p += sizeToRead;
-        bufferPosition += sizeToRead;
-        size -= sizeToRead;
+        return totalSize;
+      },
+      fileSize: result.fileSize,
+      sourceName: uri.toString(),
+      onDispose: release,
+      cancellationToken: token,
+    );
+  } catch (e) {
+    release();
+    rethrow;
+  } finally {
+    // the token only covers the loading; later reads (on page loading) are not affected
+    token?.complete();
+    detach();
+  }
+}
+
+/// Open PDF file from [uri] through the local copy at [filePath] synchronized by the block hash manifest.
+///
+/// See [PdfDocument.openUriSynced] for more info.
+Future<PdfDocument> pdfDocumentSyncFromUri(
+  Uri uri, {
+  required String filePath,
+  Uri? manifestUri,
+  String? password,
+  void Function(PdfSyncResult result)? onSynced,
+  PdfCancellationToken? cancellationToken,
+  Duration? timeout,
+}) async {
+  final token = PdfCancellationToken.withTimeout(cancellationToken, timeout);
+  token?.throwIfCanceled();
+  // closing the client aborts the requests in flight
+  final client = http.Client();
+  void abort() => client.close();
+  token?.addListener(abort);
+  final temp = File('$filePath.sync');
+  final PdfSyncResult result;
+  try {
+    result = await _syncFile(
+      client,
+      uri,
+      manifestUri ?? uri.replace(path: '${uri.path}.blocks.json'),
+      File(filePath),
+      temp,
+      token,
+    );
+  } catch (e) {
+    if (await temp.exists()) await temp.delete();
+    token?.throwIfCanceled();
+    rethrow;
+  } finally {
+    token?.removeListener(abort);
+    token?.complete();
+    client.close();
+  }
+  onSynced?.call(result);
+  return PdfDocumentFactory.instance.openFile(filePath, password: password);
+}
+
+/// Maximum number of the blocks downloaded by a range request.
+const _maxBlocksPerRequest = 8;
+
+Future<PdfSyncResult> _syncFile(
+  http.Client client,
+  Uri uri,
+  Uri manifestUri,
+  File file,
+  File temp,
+  PdfCancellationToken? token,
+) async {
+  final manifestResponse = await client.get(manifestUri);
+  token?.throwIfCanceled();
+  final manifest = manifestResponse.statusCode == 200
+      ? PdfBlockManifest.tryParse(manifestResponse.body)
+      : null;
+  if (manifest == null || !await file.exists()) {
+    return _downloadFile(client, uri, file, temp, manifest);
+  }
+  final local = await PdfBlockManifest.fromFile(file.path);
+  token?.throwIfCanceled();
+
+  // runs of the changed or missing blocks: [start, end)
+  final runs = <(int, int)>[];
+  for (int i = 0; i < manifest.blocks.length; i++) {
+    if (i < local.blocks.length && local.blocks[i] == manifest.blocks[i]) {
+      continue;
+    }
+    if (runs.isNotEmpty &&
+        runs.last.$2 == i &&
+        i - runs.last.$1 < _maxBlocksPerRequest) {
+      runs[runs.length - 1] = (runs.last.$1, i + 1);
+    } else {
+      runs.add((i, i + 1));
+    }
+  }
+  if (runs.isEmpty && local.size == manifest.size) {
+    return PdfSyncResult(
+      fileSize: manifest.size,
+      blockCount: manifest.blocks.length,
+      fetchedBlockCount: 0,
+      fetchedBytes: 0,
+      fullDownload: false,
+    );
+  }
+
+  // patch a copy so that the local copy is intact on failure
+  await file.copy(temp.path);
+  final raf = await temp.open(mode: FileMode.append);
+  var fetchedBytes = 0;
+  var fetchedBlockCount = 0;
+  http.StreamedResponse? wholeFile;
+  try {
+    for (final (start, end) in runs) {
+      final offset = start * manifest.blockSize;
+      final length = min(end * manifest.blockSize, manifest.size) - offset;
+      final response = await client.send(http.Request('GET', uri)
+        ..headers['Range'] = 'bytes=$offset-${offset + length - 1}');
+      token?.throwIfCanceled();
+      if (response.statusCode == 200) {
+        // the server does not support range requests and the whole file is sent
+        wholeFile = response;
+        break;
+      }
+      final body = await response.stream.toBytes();
+      token?.throwIfCanceled();
+      final contentRange = response.headers['content-range'];
+      if (response.statusCode != 206 ||
+          contentRange == null ||
+          !contentRange.startsWith('bytes $offset-') ||
+          body.length != length) {
+        throw HttpException(
+            'Unexpected response to the range request: '
+            '${response.statusCode} $contentRange',
+            uri: uri);
       }
-      return totalSize;
-    },
-    fileSize: result.fileSize,
-    sourceName: uri.toString(),
+      await raf.setPosition(offset);
+      await raf.writeFrom(body);
+      fetchedBytes += length;
+      fetchedBlockCount += end - start;
+    }
+    await raf.truncate(manifest.size);
+    await raf.flush();
+  } finally {
+    await raf.close();
+  }
+  if (wholeFile != null) {
+    final result = await _saveDownload(wholeFile, uri, file, temp, manifest);
+    return PdfSyncResult(
+      fileSize: result.fileSize,
+      blockCount: result.blockCount,
+      fetchedBlockCount: result.fetchedBlockCount,
+      fetchedBytes: fetchedBytes + result.fetchedBytes,
+      fullDownload: true,
+    );
+  }
+
+  await _verifyFile(temp, manifest, uri);
+  await temp.rename(file.path);
+  return PdfSyncResult(
+    fileSize: manifest.size,
+    blockCount: manifest.blocks.length,
+    fetchedBlockCount: fetchedBlockCount,
+    fetchedBytes: fetchedBytes,
+    fullDownload: false,
   );
 }
+
+Future<PdfSyncResult> _downloadFile(
+  http.Client client,
+  Uri uri,
+  File file,
+  File temp,
+  PdfBlockManifest? manifest,
+) async {
+  final response = await client.send(http.Request('GET', uri));
+  if (response.statusCode != 200) {
+    throw HttpException('Failed to download: ${response.statusCode}', uri: uri);
+  }
+  return _saveDownload(response, uri, file, temp, manifest);
+}
+
+/// Stream the whole file of [response] to [temp] and replace [file] with it once it is verified against [manifest].
+Future<PdfSyncResult> _saveDownload(
+  http.StreamedResponse response,
+  Uri uri,
+  File file,
+  File temp,
+  PdfBlockManifest? manifest,
+) async {
+  // the body is streamed to the file; the whole file may not fit in memory
+  final sink = temp.openWrite();
+  try {
+    await sink.addStream(response.stream);
+  } finally {
+    await sink.close();
+  }
+  final size = await temp.length();
+  if (manifest != null) await _verifyFile(temp, manifest, uri);
+  await temp.rename(file.path);
+  return PdfSyncResult(
+    fileSize: size,
+    blockCount: manifest?.blocks.length ?? 0,
+    fetchedBlockCount: manifest?.blocks.length ?? 0,
+    fetchedBytes: size,
+    fullDownload: true,
+  );
+}
+
+/// Throw if the blocks of [temp] do not match [manifest].
+Future<void> _verifyFile(File temp, PdfBlockManifest manifest, Uri uri) async {
+  final synced = await PdfBlockManifest.fromFile(temp.path);
+  if (synced.size != manifest.size ||
+      !listEquals(synced.blocks, manifest.blocks)) {
+    // the file may be updated on the server during the synchronization
+    throw HttpException(
+        'The file does not match the block manifest; '
+        'it may be updated during the synchronization.',
+        uri: uri);
+  }
+}
@@ -0,0 +1,379 @@
+import 'dart:collection';
+import 'dart:math';
+import 'dart:ui' as ui;
+
+import 'package:flutter/material.dart';
+
+import 'pdf_api.dart';
+import 'pdf_document_store.dart';
+
+/// A widget to read PDF document in the reflow mode.
+///
+/// The text of the pages is laid out as native text fitting to the width of the widget (see
+/// [PdfPage.loadReflowBlocks]) in a lazily built list, and only the figures are rendered as the cropped regions of
+/// the pages. It needs no page-sized bitmaps and keeps the text readable on small screens and low-end devices,
+/// although the layout of the pages (columns, tables, ...) is not preserved.
+///
+/// Not supported on Flutter Web.
+class PdfReflowViewer extends StatefulWidget {
+  const PdfReflowViewer({
+    required this.documentRef,
+    super.key,
+    this.fontSize = 16,
+    this.textStyle,
+    this.padding = const EdgeInsets.all(16),
+    this.paragraphSpacing = 12,
+    this.maxCachedPages = 8,
+    this.controller,
+    this.pageSeparatorBuilder,
+  });
+
+  /// [PdfDocumentRef] to the document; it can be shared with `PdfViewer` to switch the view modes of the same
+  /// document.
+  final PdfDocumentRef documentRef;
+
+  /// The font size of the body text of each page; the other text is scaled relative to it.
+  final double fontSize;
+
+  /// The base style of the text; the font size, weight and style are overridden by the ones of the text runs.
+  final TextStyle? textStyle;
+
+  /// Padding of the list.
+  final EdgeInsets padding;
+
+  /// Spacing between the paragraphs and figures.
+  final double paragraphSpacing;
+
+  /// Maximum number of the pages no longer shown whose extracted contents are kept in memory; the pages shown (and
+  /// built ahead by the list) always keep theirs.
+  final int maxCachedPages;
+
+  /// Scroll controller of the list.
+  final ScrollController? controller;
+
+  /// Build the separator placed before the page of [pageNumber]; the default one shows the page number.
+  final Widget Function(BuildContext context, int pageNumber)?
+      pageSeparatorBuilder;
+
+  @override
+  State<PdfReflowViewer> createState() => _PdfReflowViewerState();
+}
+
+class _PdfReflowViewerState extends State<PdfReflowViewer> {
+  PdfDocument? _document;
+
+  /// The extracted contents of the pages no longer built keyed by page number in the least recently used order;
+  /// the built pages keep theirs in their states.
+  final _releasedBlocks = LinkedHashMap<int, Future<List<PdfReflowBlock>>>();
+
+  @override
+  void initState() {
+    super.initState();
+    widget.documentRef.addListener(_onDocumentChanged);
+    _onDocumentChanged();
+  }
+
+  @override
+  void didUpdateWidget(covariant PdfReflowViewer oldWidget) {
+    super.didUpdateWidget(oldWidget);
+    if (oldWidget.documentRef != widget.documentRef) {
+      oldWidget.documentRef.removeListener(_onDocumentChanged);
+      widget.documentRef.addListener(_onDocumentChanged);
+      _onDocumentChanged();
+    }
+  }
+
+  @override
+  void dispose() {
+    widget.documentRef.removeListener(_onDocumentChanged);
+    _releasedBlocks.clear();
+    super.dispose();
+  }
+
+  void _onDocumentChanged() {
+    final document = widget.documentRef.document;
+    if (identical(_document, document)) return;
+    _releasedBlocks.clear();
+    _document = document;
+    if (mounted) {
+      setState(() {});
+    }
+  }
+
+  /// Called when the page is built; the contents are taken from the cache of the released pages if available.
+  Future<List<PdfReflowBlock>> _acquireBlocks(PdfPage page) =>
+      _releasedBlocks.remove(page.pageNumber) ?? page.loadReflowBlocks();
+
+  /// Called when the page is no longer built; the least recently released pages are evicted.
+  void _releaseBlocks(PdfPage page, Future<List<PdfReflowBlock>> blocks) {
+    if (!mounted || !identical(page.document, _document)) return;
+    _releasedBlocks[page.pageNumber] = blocks;
+    while (_releasedBlocks.length > max(widget.maxCachedPages, 0)) {
+      _releasedBlocks.remove(_releasedBlocks.keys.first);
+    }
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final document = _document;
+    if (document == null) return Container();
+    return ListView.builder(
+      controller: widget.controller,
+      padding: widget.padding,
+      itemCount: document.pages.length,
+      itemBuilder: (context, index) {
+        final page = document.pages[index];
+        return Column(
+          crossAxisAlignment: CrossAxisAlignment.stretch,
+          children: [
+            widget.pageSeparatorBuilder?.call(context, page.pageNumber) ??
+                _defaultPageSeparator(context, page.pageNumber),
+            _PdfReflowPage(
+              key: ValueKey(page),
+              page: page,
+              acquireBlocks: _acquireBlocks,
+              releaseBlocks: _releaseBlocks,
+              fontSize: widget.fontSize,
+              textStyle: widget.textStyle ??
+                  DefaultTextStyle.of(context).style,
+              paragraphSpacing: widget.paragraphSpacing,
+            ),
+          ],
+        );
+      },
+    );
+  }
+
+  Widget _defaultPageSeparator(BuildContext context, int pageNumber) {
+    return Padding(
+      padding: EdgeInsets.symmetric(vertical: widget.paragraphSpacing),
+      child: Row(
+        children: [
+          const Expanded(child: Divider()),
+          Padding(
+            padding: const EdgeInsets.symmetric(horizontal: 8),
+            child: Text(
+              '$pageNumber',
+              style: Theme.of(context).textTheme.bodySmall,
+            ),
+          ),
+          const Expanded(child: Divider()),
+        ],
+      ),
+    );
+  }
+}
+
+class _PdfReflowPage extends StatefulWidget {
+  const _PdfReflowPage({
+    required this.page,
+    required this.acquireBlocks,
+    required this.releaseBlocks,
+    required this.fontSize,
+    required this.textStyle,
+    required this.paragraphSpacing,
+    super.key,
+  });
+
+  final PdfPage page;
+  final Future<List<PdfReflowBlock>> Function(PdfPage page) acquireBlocks;
+  final void Function(PdfPage page, Future<List<PdfReflowBlock>> blocks)
+      releaseBlocks;
+  final double fontSize;
+  final TextStyle textStyle;
+  final double paragraphSpacing;
+
+  @override
+  State<_PdfReflowPage> createState() => _PdfReflowPageState();
+}
+
+class _PdfReflowPageState extends State<_PdfReflowPage> {
+  /// The contents of the page, kept while the page is built and handed back to the viewer on dispose.
+  late Future<List<PdfReflowBlock>> _blocks;
+
+  @override
+  void initState() {
+    super.initState();
+    _blocks = widget.acquireBlocks(widget.page);
+  }
+
+  @override
+  void didUpdateWidget(covariant _PdfReflowPage oldWidget) {
+    super.didUpdateWidget(oldWidget);
+    if (!identical(oldWidget.page, widget.page)) {
+      oldWidget.releaseBlocks(oldWidget.page, _blocks);
+      _blocks = widget.acquireBlocks(widget.page);
+    }
+  }
+
+  @override
+  void dispose() {
+    widget.releaseBlocks(widget.page, _blocks);
+    super.dispose();
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    return FutureBuilder<List<PdfReflowBlock>>(
+      future: _blocks,
+      builder: (context, snapshot) {
+        if (snapshot.hasError) {
+          return Text(snapshot.error.toString());
+        }
+        final blocks = snapshot.data;
+        if (blocks == null) {
+          // keep the list from jumping too much while the page is loaded
+          return SizedBox(height: widget.fontSize * 20);
+        }
+        final scale = widget.fontSize / _bodyFontSize(blocks);
+        return Column(
+          crossAxisAlignment: CrossAxisAlignment.stretch,
+          children: [
+            for (final block in blocks)
+              Padding(
+                padding: EdgeInsets.only(bottom: widget.paragraphSpacing),
+                child: switch (block) {
+                  PdfReflowParagraph() => _buildParagraph(block, scale),
+                  _ => _PdfReflowFigureView(
+                      page: widget.page, rect: block.rect, scale: scale),
+                },
+              ),
+          ],
+        );
+      },
+    );
+  }
+
+  Widget _buildParagraph(PdfReflowParagraph paragraph, double scale) {
+    return Text.rich(
+      TextSpan(
+        children: [
+          for (final run in paragraph.runs)
+            TextSpan(
+              text: run.text,
+              style: widget.textStyle.copyWith(
+                fontSize: (run.fontSize * scale)
+                    .clamp(widget.fontSize * 0.75, widget.fontSize * 2.5),
+                fontWeight: _fontWeight(run.fontWeight),
+                fontStyle: run.isItalic ? FontStyle.italic : FontStyle.normal,
+                fontFamily: run.isMonospace ? 'monospace' : null,
+              ),
+            ),
+        ],
+      ),
+    );
+  }
+
+  /// The most used font size on the page, which is mapped to [fontSize].
+  static double _bodyFontSize(List<PdfReflowBlock> blocks) {
+    final lengths = <double, int>{};
+    for (final block in blocks) {
+      if (block is! PdfReflowParagraph) continue;
+      for (final run in block.runs) {
+        final size = run.fontSize.roundToDouble();
+        lengths[size] = (lengths[size] ?? 0) + run.text.length;
+      }
+    }
+    if (lengths.isEmpty) return 12;
+    final body =
+        lengths.entries.reduce((a, b) => a.value >= b.value ? a : b).key;
+    return max(body, 1);
+  }
+
+  static FontWeight? _fontWeight(int weight) {
+    if (weight <= 0) return null;
+    return FontWeight.values[((weight + 50) ~/ 100 - 1).clamp(0, 8)];
+  }
+}
+
+/// Cropped region of the page rendered at the displayed size.
+class _PdfReflowFigureView extends StatefulWidget {
+  const _PdfReflowFigureView({
+    required this.page,
+    required this.rect,
+    required this.scale,
+  });
+
+  final PdfPage page;
+  final PdfRect rect;
+
+  /// Scale of the figure relative to the page in points, which is same to the text of the page.
+  final double scale;
+
+  @override
+  State<_PdfReflowFigureView> createState() => _PdfReflowFigureViewState();
+}
+
+class _PdfReflowFigureViewState extends State<_PdfReflowFigureView> {
+  ui.Image? _image;
+  double? _renderedScale;
+
+  @override
+  void dispose() {
+    _image?.dispose();
+    super.dispose();
+  }
+
+  Future<void> _render(double scale) async {
+    if (!mounted || _renderedScale == scale) return;
+    _renderedScale = scale;
+    try {
+      final page = widget.page;
+      final r = widget.rect.toRect(height: page.height, scale: scale);
+      final img = await page.render(
+        x: r.left.floor(),
+        y: r.top.floor(),
+        width: max(r.width.ceil(), 1),
+        height: max(r.height.ceil(), 1),
+        fullWidth: page.width * scale,
+        fullHeight: page.height * scale,
+        backgroundColor: Colors.white,
+      );
+      final ui.Image image;
+      try {
+        image = await img.createImage();
+      } finally {
+        img.dispose();
+      }
+      if (!mounted || _renderedScale != scale) {
+        image.dispose();
+        return;
+      }
+      setState(() {
+        _image?.dispose();
+        _image = image;
+      });
+    } catch (e) {
+      // rendered again on the next layout
+      if (_renderedScale == scale) _renderedScale = null;
+    }
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final rect = widget.rect;
+    final width = rect.right - rect.left;
+    final height = rect.top - rect.bottom;
+    if (!(width > 0 && height > 0)) return const SizedBox.shrink();
+    return LayoutBuilder(builder: (context, constraints) {
+      final displayWidth = min(constraints.maxWidth, width * widget.scale);
+      final displayHeight = height * displayWidth / width;
+      final pixelScale =
+          displayWidth / width * MediaQuery.of(context).devicePixelRatio;
+      if (pixelScale > 0 &&
+          pixelScale.isFinite &&
+          pixelScale != _renderedScale) {
+        // after the layout; _render calls setState, which is not allowed during the layout
+        WidgetsBinding.instance
+            .addPostFrameCallback((_) => _render(pixelScale));
+      }
+      return Center(
+        child: SizedBox(
+          width: displayWidth,
+          height: displayHeight,
+          child: RawImage(image: _image, fit: BoxFit.fill),
+        ),
+      );
+    });
+  }
+}
@@ -29,7 +29,14 @@ class PdfViewerParams {
     this.scrollByMouseWheel = 0.1,
     this.maxThumbCacheCount = 30,
     this.maxRealSizeImageCount = 5,
+    this.maxThumbCacheBytes,
+    this.maxRealSizeImageBytes,
     this.enableRealSizeRendering = true,
+    this.enableProgressiveRendering = true,
+    this.enableDisplayLists = false,
+    this.renderLimits,
+    this.preparePagesAhead = 3,
+    this.maxPreparedTextBytes = 32 * 1024 * 1024,
     this.viewerOverlayBuilder,
     this.pageOverlayBuilder,
     this.forceReload = false,
@@ -93,9 +100,11 @@ class PdfViewerParams {
   /// the memory consumption and rendering performance.
   final bool enableRenderAnnotations;
 
-  /// Experimental: Enable text selection on pages.
+  /// Enable text selection on pages. The default is false.
   ///
-  /// Please note the feature is still in development and may not work properly and disabled by default so far.
+  /// Long-press on a page starts the selection and dragging extends it across pages; tap clears it.
+  /// The selection is available on [PdfViewerController.textSelection] and can be copied by
+  /// [PdfViewerController.copyTextSelection].
   final bool enableTextSelection;
 
   /// See [InteractiveViewer.panEnabled] for details.
@@ -152,17 +161,58 @@ class PdfViewerParams {
   final double? scrollByMouseWheel;
 
   /// The maximum number of thumbnails to be cached. The default is 30.
+  ///
+  /// If [maxThumbCacheBytes] is set, the thumbnails are also limited by it.
   final int maxThumbCacheCount;
 
   /// The maximum number of real size images to be cached. The default is 5.
+  ///
+  /// If [maxRealSizeImageBytes] is set, the real size images are also limited by it; to let the byte budget decide
+  /// how many pages to keep, raise this count as well (e.g. 32 pages within 160MB).
   final int maxRealSizeImageCount;
 
+  /// The memory budget of the thumbnails in bytes; null (the default) to limit them only by [maxThumbCacheCount].
+  final int? maxThumbCacheBytes;
+
+  /// The memory budget of the real size images (and display lists) in bytes; null (the default) to limit them only
+  /// by [maxRealSizeImageCount].
+  ///
+  /// The pages to evict are chosen by their size, the time taken to render them and their distance to the
+  /// viewport; the pages in and near the viewport are kept even if they exceed the budget.
+  final int? maxRealSizeImageBytes;
+
   /// Enable real size rendering. The default is true.
   ///
   /// If you want to render PDF pages in relatively small sizes only,
   /// disabling this option may improve the performance.
   final bool enableRealSizeRendering;
 
+  /// Show the real size images progressively while they are being rendered. The default is true.
+  ///
+  /// The partially rendered images of the complex pages replace the thumbnails about every 100ms
+  /// (see [PdfPage.renderProgressive]).
+  final bool enableProgressiveRendering;
+
+  /// Draw the pages by their display lists (see [PdfPage.loadDisplayList]) instead of the rendered images if
+  /// possible. The default is false.
+  ///
+  /// The display lists are drawn at any zoom without rendering the pages again, so vector-heavy pages zoom smoothly;
+  /// the pages that cannot be converted are rendered as usual. Blend modes and soft masks are not reproduced.
+  final bool enableDisplayLists;
+
+  /// Budgets of each page rendering to keep pathological pages from stalling the viewer; the pages exceeding them
+  /// are shown as drafts (see [PdfRenderLimits]). The default is null (no limits).
+  final PdfRenderLimits? renderLimits;
+
+  /// The number of the pages to prepare ahead in the reading direction while the viewer is at rest.
+  /// The default is 3; 0 to disable.
+  ///
+  /// The text pages are prepared only if [enableTextSelection] is true; see [PdfDocument.preparePages].
+  final int preparePagesAhead;
+
+  /// The maximum memory (in bytes) used by the prepared text pages. The default is 32MB.
+  final int maxPreparedTextBytes;
+
   /// Add overlays to the viewer.
   ///
   /// This function is to generate widgets on PDF viewer's overlay [Stack].
@@ -227,7 +277,10 @@ class PdfViewerParams {
         other.scrollByMouseWheel != scrollByMouseWheel ||
         other.maxThumbCacheCount != maxThumbCacheCount ||
         other.maxRealSizeImageCount != maxRealSizeImageCount ||
-        other.enableRealSizeRendering != enableRealSizeRendering;
+        other.maxThumbCacheBytes != maxThumbCacheBytes ||
+        other.maxRealSizeImageBytes != maxRealSizeImageBytes ||
+        other.enableRealSizeRendering != enableRealSizeRendering ||
+        other.enableDisplayLists != enableDisplayLists;
   }
 
   @override
@@ -251,7 +304,14 @@ class PdfViewerParams {
         other.scrollByMouseWheel == scrollByMouseWheel &&
         other.maxThumbCacheCount == maxThumbCacheCount &&
         other.maxRealSizeImageCount == maxRealSizeImageCount &&
+        other.maxThumbCacheBytes == maxThumbCacheBytes &&
+        other.maxRealSizeImageBytes == maxRealSizeImageBytes &&
         other.enableRealSizeRendering == enableRealSizeRendering &&
+        other.enableProgressiveRendering == enableProgressiveRendering &&
+        other.enableDisplayLists == enableDisplayLists &&
+        other.renderLimits == renderLimits &&
+        other.preparePagesAhead == preparePagesAhead &&
+        other.maxPreparedTextBytes == maxPreparedTextBytes &&
         other.viewerOverlayBuilder == viewerOverlayBuilder &&
         other.pageOverlayBuilder == pageOverlayBuilder &&
         other.forceReload == forceReload;
@@ -276,7 +336,14 @@ class PdfViewerParams {
         scrollByMouseWheel.hashCode ^
         maxThumbCacheCount.hashCode ^
         maxRealSizeImageCount.hashCode ^
+        maxThumbCacheBytes.hashCode ^
+        maxRealSizeImageBytes.hashCode ^
         enableRealSizeRendering.hashCode ^
+        enableProgressiveRendering.hashCode ^
+        enableDisplayLists.hashCode ^
+        renderLimits.hashCode ^
+        preparePagesAhead.hashCode ^
+        maxPreparedTextBytes.hashCode ^
         viewerOverlayBuilder.hashCode ^
         pageOverlayBuilder.hashCode ^
         forceReload.hashCode;
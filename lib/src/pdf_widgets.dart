@@ -6,12 +6,14 @@ import 'dart:ui' as ui;
 
 import 'package:flutter/foundation.dart';
 import 'package:flutter/material.dart';
+import 'package:flutter/services.dart';
 import 'package:rxdart/rxdart.dart';
 import 'package:synchronized/extension.dart';
 import 'package:vector_math/vector_math_64.dart' as vec;
 
 import 'interactive_viewer.dart' as iv;
 import 'pdf_api.dart';
+import 'pdf_cache_policy.dart';
 import 'pdf_document_store.dart';
 import 'pdf_viewer_params.dart';
 
@@ -85,9 +87,11 @@ class PdfViewer extends StatefulWidget {
     PdfDocumentStore? store,
   }) : this(
           key: key,
-          documentRef: (store ?? PdfDocumentStore.defaultStore).load(
+          documentRef:
+              (store ?? PdfDocumentStore.defaultStore).loadCancellable(
             '##PdfViewer:uri:$uri',
-            documentLoader: () => PdfDocument.openUri(uri, password: password),
+            documentLoader: (token) => PdfDocument.openUri(uri,
+                password: password, cancellationToken: token),
           ),
           controller: controller,
           params: displayParams,
@@ -132,13 +136,15 @@ class PdfViewer extends StatefulWidget {
     PdfDocumentStore? store,
   }) : this(
           key: key,
-          documentRef: (store ?? PdfDocumentStore.defaultStore).load(
+          documentRef:
+              (store ?? PdfDocumentStore.defaultStore).loadCancellable(
             '##PdfViewer:custom:$sourceName',
-            documentLoader: () => PdfDocument.openCustom(
+            documentLoader: (token) => PdfDocument.openCustom(
                 read: read,
                 fileSize: fileSize,
                 sourceName: sourceName,
-                password: password),
+                password: password,
+                cancellationToken: token),
           ),
           controller: controller,
           params: displayParams,
@@ -177,13 +183,39 @@ class _PdfViewerState extends State<PdfViewer>
   double? _coverScale;
   double? _alternativeFitScale;
   int? _pageNumber;
+
+  /// 1 if the user is reading forward, -1 if backward; see [_preparePages].
+  int _readingDirection = 1;
+  Timer? _prepareTimer;
   bool _initialized = false;
   final _taskTimers = <int, Timer>{};
   final List<double> _zoomStops = [1.0];
 
   final _thumbs = <int, ui.Image>{};
   final _realSized = <int, ({ui.Image image, double scale})>{};
+
+  /// Partially rendered real size images drawn instead of the thumbnails while the rendering is in progress.
+  final _partialRealSized = <int, ui.Image>{};
+
+  /// Display lists by page number drawn instead of the images; null if the page cannot be converted.
+  final _displayLists = <int, PdfPageDisplayList?>{};
   final _pageTextLoader = <int, PdfPageText>{};
+  int _rendersInFlight = 0;
+
+  /// Eviction policy of [_thumbs].
+  final _thumbCachePolicy = PdfCacheEvictionPolicy();
+
+  /// Eviction policy of [_realSized] and [_displayLists]; the texts of the pages are released with them.
+  final _pageCachePolicy = PdfCacheEvictionPolicy();
+
+  /// Highlight rectangles (merged into line runs) of [_selectionRectsFor] by page number.
+  final _selectionRects = <int, List<PdfRect>>{};
+  PdfTextSelection? _selectionRectsFor;
+  bool _selectionRectsLoading = false;
+  ({Offset position, bool extend})? _pendingTextHitTest;
+  bool _textHitTesting = false;
+
+  static const _selectionColor = Color(0x4d0078ff);
 
   final _stream = BehaviorSubject<Matrix4>();
 
@@ -211,7 +243,11 @@ class _PdfViewerState extends State<PdfViewer>
         if (widget.params.enableRenderAnnotations !=
             oldWidget?.params.enableRenderAnnotations) {
           _realSized.clear();
+          _clearPartialImages();
           _thumbs.clear();
+          _clearDisplayLists();
+          _thumbCachePolicy.clear();
+          _pageCachePolicy.clear();
         }
         _relayoutPages();
 
@@ -222,30 +258,95 @@ class _PdfViewerState extends State<PdfViewer>
       return;
     }
 
-    oldWidget?.documentRef.removeListener(_onDocumentChanged);
+    if (oldWidget != null) {
+      _putCachesToWarmCache(oldWidget.documentRef);
+      oldWidget.documentRef.removeListener(_onDocumentChanged);
+    }
     widget.documentRef.addListener(_onDocumentChanged);
     _onDocumentChanged();
   }
 
+  /// Hand the rendered images and texts over to [docRef] so that they survive while the document is
+  /// in the warm pool of the store.
+  void _putCachesToWarmCache(PdfDocumentRef docRef) {
+    if (_document == null || !identical(_document, docRef.document)) return;
+    final warmCache = docRef.warmCache;
+    warmCache.thumbs.addAll(_thumbs);
+    warmCache.realSized.addAll(_realSized);
+    warmCache.pageTexts.addAll(_pageTextLoader);
+  }
+
+  /// Take the rendered images and texts retained by [docRef] if any.
+  void _takeCachesFromWarmCache(PdfDocumentRef docRef) {
+    final warmCache = docRef.warmCache;
+    if (warmCache.isEmpty) return;
+    _thumbs.addAll(warmCache.thumbs);
+    _realSized.addAll(warmCache.realSized);
+    _pageTextLoader.addAll(warmCache.pageTexts);
+    warmCache.clear();
+    _resetCachePolicies();
+  }
+
+  /// Register the cached images to the eviction policies from scratch; their render costs are unknown.
+  void _resetCachePolicies() {
+    _thumbCachePolicy.clear();
+    for (final entry in _thumbs.entries) {
+      _thumbCachePolicy.put(entry.key, _imageBytes(entry.value));
+    }
+    _pageCachePolicy.clear();
+    for (final pageNumber in {..._realSized.keys, ..._displayLists.keys}) {
+      _updatePageCachePolicy(pageNumber);
+    }
+  }
+
+  /// Update the size (and [cost] if measured) of the page in [_pageCachePolicy].
+  void _updatePageCachePolicy(int pageNumber, {Duration? cost}) {
+    final realSize = _realSized[pageNumber];
+    final bytes = (realSize != null ? _imageBytes(realSize.image) : 0) +
+        (_displayLists[pageNumber]?.byteSize ?? 0);
+    if (bytes == 0) {
+      _pageCachePolicy.remove(pageNumber);
+    } else {
+      _pageCachePolicy.put(pageNumber, bytes, cost: cost);
+    }
+  }
+
+  static int _imageBytes(ui.Image image) => image.width * image.height * 4;
+
   void _relayout() {
     _relayoutPages();
     _realSized.clear();
+    _clearPartialImages();
+    _resetCachePolicies();
     if (mounted) {
       setState(() {});
     }
   }
 
   void _onDocumentChanged() async {
+    _prepareTimer?.cancel();
+    _readingDirection = 1;
     _layout = null;
     _thumbs.clear();
     _realSized.clear();
+    _clearPartialImages();
+    _clearDisplayLists();
     _pageTextLoader.clear();
+    _thumbCachePolicy.clear();
+    _pageCachePolicy.clear();
+    _selectionRects.clear();
+    _selectionRectsFor = null;
     _pageNumber = null;
     _initialized = false;
     _controller?.removeListener(_onMatrixChanged);
+    _controller?.textSelection.removeListener(_invalidate);
     _controller?._attach(null);
 
     final document = widget.documentRef.document;
+    if (_document != null && !identical(_document, document)) {
+      // character positions are meaningless on another document
+      _controller?.textSelection.value = null;
+    }
     if (document == null) {
       _document = null;
       if (mounted) {
@@ -255,12 +356,14 @@ class _PdfViewerState extends State<PdfViewer>
     }
 
     _document = document;
+    _takeCachesFromWarmCache(widget.documentRef);
 
     _relayoutPages();
 
     _controller ??= widget.controller ?? PdfViewerController();
     _controller!._attach(this);
     _controller!.addListener(_onMatrixChanged);
+    _controller!.textSelection.addListener(_invalidate);
 
     if (mounted) {
       setState(() {});
@@ -270,18 +373,51 @@ class _PdfViewerState extends State<PdfViewer>
   @override
   void dispose() {
     _cancelAllTasks();
+    _prepareTimer?.cancel();
     animController.dispose();
+    _putCachesToWarmCache(widget.documentRef);
     widget.documentRef.removeListener(_onDocumentChanged);
     _thumbs.clear();
     _realSized.clear();
+    _clearPartialImages();
+    _clearDisplayLists();
     _pageTextLoader.clear();
+    _thumbCachePolicy.clear();
+    _pageCachePolicy.clear();
     _controller!.removeListener(_onMatrixChanged);
+    _controller!.textSelection.removeListener(_invalidate);
     _controller!._attach(null);
     super.dispose();
   }
 
   void _onMatrixChanged() {
+    _controller!._recording?._addTransform(_controller!.value, _viewSize);
     _stream.add(_controller!.value);
+    _schedulePreparePages();
+  }
+
+  /// Prepare the pages ahead in the reading direction once the viewer comes to rest.
+  void _schedulePreparePages() {
+    _prepareTimer?.cancel();
+    // the page contents are parsed on open; only the text pages are worth preparing
+    if (widget.params.preparePagesAhead <= 0 ||
+        !widget.params.enableTextSelection) {
+      return;
+    }
+    _prepareTimer = Timer(const Duration(milliseconds: 300), _preparePages);
+  }
+
+  void _preparePages() {
+    final document = _document;
+    final pageNumber = _pageNumber;
+    if (!mounted || document == null || pageNumber == null) return;
+    document.preparePages(
+      [
+        for (int i = 0; i <= widget.params.preparePagesAhead; i++)
+          pageNumber + i * _readingDirection,
+      ],
+      maxTextCacheBytes: widget.params.maxPreparedTextBytes,
+    );
   }
 
   @override
@@ -336,10 +472,12 @@ class _PdfViewerState extends State<PdfViewer>
                         ? _onWheelDelta
                         : null,
                     // PDF pages
-                    child: CustomPaint(
-                      foregroundPainter:
-                          _CustomPainter.fromFunction(_customPaint),
-                      size: _layout!.documentSize,
+                    child: _wrapWithTextSelectionGestures(
+                      CustomPaint(
+                        foregroundPainter:
+                            _CustomPainter.fromFunction(_customPaint),
+                        size: _layout!.documentSize,
+                      ),
                     ),
                   ),
                   ..._buildPageOverlayWidgets(),
@@ -379,6 +517,9 @@ class _PdfViewerState extends State<PdfViewer>
       }
     }
     if (_pageNumber != pageNumberMaxInt) {
+      if (_pageNumber != null && pageNumberMaxInt != null) {
+        _readingDirection = pageNumberMaxInt > _pageNumber! ? 1 : -1;
+      }
       _pageNumber = pageNumberMaxInt;
       if (widget.onPageChanged != null) {
         Future.microtask(() => widget.onPageChanged?.call(_pageNumber));
@@ -508,8 +649,17 @@ class _PdfViewerState extends State<PdfViewer>
       300.0 / 72.0,
     );
 
-    final unusedPageList = <int>[];
+    final usedPageNumbers = <int>{};
     final needRelayout = <int>[];
+    final textSelection = _controller!.textSelection.value;
+    int? selectionRectsFirst, selectionRectsLast;
+    final stats = _controller!.renderStats;
+    final realSizeCacheHits = stats.realSizeCacheHits;
+    final realSizeCacheMisses = stats.realSizeCacheMisses;
+    final thumbCacheHits = stats.thumbCacheHits;
+    final thumbCacheMisses = stats.thumbCacheMisses;
+    _thumbCachePolicy.beginPaint();
+    _pageCachePolicy.beginPaint();
 
     for (int i = 0; i < _document!.pages.length; i++) {
       final rect = _layout!.pageLayouts[i];
@@ -517,17 +667,37 @@ class _PdfViewerState extends State<PdfViewer>
       if (intersection.isEmpty) {
         final page = _document!.pages[i];
         _cancelTask(page.pageNumber + 10000);
+        _cancelTask(page.pageNumber + 20000);
         _cancelTask(page.pageNumber);
-        unusedPageList.add(i + 1);
         continue;
       }
 
       final page = _document!.pages[i];
+      usedPageNumbers.add(page.pageNumber);
+      final distance = _distanceToViewport(rect, visibleRect);
+      _thumbCachePolicy.touch(page.pageNumber, distance);
+      _pageCachePolicy.touch(page.pageNumber, distance);
+      if (widget.params.enableDisplayLists &&
+          !_displayLists.containsKey(page.pageNumber)) {
+        _scheduleTask(
+            page.pageNumber + 20000, const Duration(milliseconds: 100), () {
+          _ensureDisplayListLoaded(page);
+        });
+      }
+      final displayList = _displayLists[page.pageNumber];
       var realSize = _realSized[page.pageNumber];
       final scale = widget.params.getPageRenderingScale
               ?.call(context, page, _controller!, globalScale) ??
           globalScale;
-      if (realSize == null || realSize.scale != scale) {
+      if (displayList != null) {
+        // not rendered
+      } else if (realSize != null && realSize.scale == scale) {
+        stats.realSizeCacheHits++;
+      } else {
+        stats.realSizeCacheMisses++;
+      }
+      if (displayList == null &&
+          (realSize == null || realSize.scale != scale)) {
         if (widget.params.enableRealSizeRendering) {
           _ensureThumbCached(page);
         } else {
@@ -543,7 +713,11 @@ class _PdfViewerState extends State<PdfViewer>
         }
       }
 
-      if (realSize != null) {
+      if (displayList != null) {
+        // drawn at any scale without rendering
+        canvas.drawRect(rect, Paint()..color = Colors.white);
+        displayList.paint(canvas, rect);
+      } else if (realSize != null) {
         canvas.drawImageRect(
           realSize.image,
           Rect.fromLTWH(
@@ -556,8 +730,18 @@ class _PdfViewerState extends State<PdfViewer>
           Paint()..filterQuality = FilterQuality.high,
         );
       } else {
+        final partial = _partialRealSized[page.pageNumber];
         final thumb = _thumbs[page.pageNumber];
-        if (thumb != null) {
+        if (partial != null) {
+          canvas.drawImageRect(
+            partial,
+            Rect.fromLTWH(
+                0, 0, partial.width.toDouble(), partial.height.toDouble()),
+            rect,
+            Paint()..filterQuality = FilterQuality.high,
+          );
+        } else if (thumb != null) {
+          stats.thumbCacheHits++;
           canvas.drawImageRect(
             thumb,
             Rect.fromLTWH(
@@ -566,6 +750,7 @@ class _PdfViewerState extends State<PdfViewer>
             Paint()..filterQuality = FilterQuality.high,
           );
         } else {
+          stats.thumbCacheMisses++;
           canvas.drawRect(
               rect,
               Paint()
@@ -573,6 +758,26 @@ class _PdfViewerState extends State<PdfViewer>
                 ..style = PaintingStyle.fill);
         }
       }
+
+      if (textSelection?.containsPage(page.pageNumber) == true) {
+        final selectionRects = _selectionRects[page.pageNumber];
+        if (selectionRects != null) {
+          final paint = Paint()..color = _selectionColor;
+          final pageScale = rect.width / page.width;
+          for (final r in selectionRects) {
+            canvas.drawRect(
+                r
+                    .toRect(height: page.height, scale: pageScale)
+                    .translate(rect.left, rect.top),
+                paint);
+          }
+        }
+        if (selectionRects == null || _selectionRectsFor != textSelection) {
+          selectionRectsFirst ??= page.pageNumber;
+          selectionRectsLast = page.pageNumber;
+        }
+      }
+
       canvas.drawRect(
           rect,
           Paint()
@@ -588,26 +793,158 @@ class _PdfViewerState extends State<PdfViewer>
           },
         );
       }
+    }
 
-      if (unusedPageList.isNotEmpty) {
-        final currentPageNumber = _pageNumber;
-        if (currentPageNumber != null && currentPageNumber > 0) {
-          final currentPage = _document!.pages[currentPageNumber - 1];
-          _removeSomeImagesIfImageCountExceeds(
-            'realSize',
-            unusedPageList,
-            widget.params.maxRealSizeImageCount,
-            currentPage,
-            (pageNumber) {
-              _realSized.remove(pageNumber);
-              _pageTextLoader.remove(pageNumber);
-            },
-          );
+    // the pages around the viewport are kept even if they exceed the budgets; they are requested again soon
+    final pageLayouts = _layout!.pageLayouts;
+    double distanceOf(int pageNumber) => pageNumber <= pageLayouts.length
+        ? _distanceToViewport(pageLayouts[pageNumber - 1], visibleRect)
+        : double.infinity;
+    _pageCachePolicy.evict(
+      maxBytes: widget.params.maxRealSizeImageBytes,
+      maxCount: widget.params.maxRealSizeImageCount,
+      distanceOf: distanceOf,
+      isPinned: usedPageNumbers.contains,
+      onEvict: (pageNumber) {
+        _realSized.remove(pageNumber);
+        _pageTextLoader.remove(pageNumber);
+        // the pages that cannot be converted are remembered
+        if (_displayLists[pageNumber] != null) {
+          _displayLists.remove(pageNumber)!.dispose();
         }
+      },
+    );
+    _thumbCachePolicy.evict(
+      maxBytes: widget.params.maxThumbCacheBytes,
+      maxCount: widget.params.maxThumbCacheCount,
+      distanceOf: distanceOf,
+      isPinned: usedPageNumbers.contains,
+      onEvict: (pageNumber) => _thumbs.remove(pageNumber),
+    );
+    if (textSelection == null) {
+      _selectionRects.clear();
+      _selectionRectsFor = null;
+    } else if (selectionRectsFirst != null && !_selectionRectsLoading) {
+      Future.microtask(() => _loadSelectionRects(
+          textSelection, selectionRectsFirst!, selectionRectsLast!));
+    }
+
+    stats._sampleQueueDepth(
+        _taskTimers.values.where((t) => t.isActive).length, _rendersInFlight);
+    _controller!._recording?._addPaint(
+      stats.realSizeCacheHits - realSizeCacheHits,
+      stats.realSizeCacheMisses - realSizeCacheMisses,
+      stats.thumbCacheHits - thumbCacheHits,
+      stats.thumbCacheMisses - thumbCacheMisses,
+    );
+  }
+
+  /// Compute the highlight rectangles of the pages in a batch; only one request runs at a time and the
+  /// next paint requests the rectangles for the latest selection if it has been changed meanwhile.
+  Future<void> _loadSelectionRects(PdfTextSelection selection,
+      int firstPageNumber, int lastPageNumber) async {
+    if (_selectionRectsLoading) return;
+    _selectionRectsLoading = true;
+    try {
+      final rects = await _document!.getTextSelectionRects(
+        selection,
+        firstPageNumber: firstPageNumber,
+        lastPageNumber: lastPageNumber,
+      );
+      if (_selectionRectsFor != selection) {
+        // keep showing the previous rectangles until the new ones are ready (avoids flickering on dragging)
+        _selectionRects.clear();
+        _selectionRectsFor = selection;
+      }
+      _selectionRects.addAll(rects);
+    } catch (e) {
+      // the text could not be loaded (e.g. the document is closed meanwhile); the selection is not highlighted
+      // rather than requested again on every paint
+      _selectionRects.clear();
+      _selectionRectsFor = selection;
+      for (int i = firstPageNumber; i <= lastPageNumber; i++) {
+        _selectionRects[i] = const [];
+      }
+    } finally {
+      _selectionRectsLoading = false;
+    }
+    if (mounted) _invalidate();
+  }
+
+  Widget _wrapWithTextSelectionGestures(Widget child) {
+    if (!widget.params.enableTextSelection) return child;
+    return GestureDetector(
+      onLongPressStart: (details) =>
+          _selectTextAt(details.localPosition, extend: false),
+      onLongPressMoveUpdate: (details) =>
+          _selectTextAt(details.localPosition, extend: true),
+      onTap: () => _controller!.textSelection.value = null,
+      child: child,
+    );
+  }
+
+  /// Start or extend the text selection at [position] (in document coordinates).
+  ///
+  /// While a hit test is running, only the latest position is kept to avoid flooding the worker on dragging.
+  Future<void> _selectTextAt(Offset position, {required bool extend}) async {
+    _pendingTextHitTest = (
+      position: position,
+      // a new selection not processed yet should not be turned into an extension
+      extend: extend && (_pendingTextHitTest?.extend ?? true),
+    );
+    if (_textHitTesting) return;
+    _textHitTesting = true;
+    try {
+      while (_pendingTextHitTest != null && mounted && _document != null) {
+        final request = _pendingTextHitTest!;
+        _pendingTextHitTest = null;
+        final pageIndex = _findPageIndexAt(request.position);
+        if (pageIndex == null) break;
+        final page = _document!.pages[pageIndex];
+        final rect = _layout!.pageLayouts[pageIndex];
+        final scale = page.width / rect.width;
+        final charIndex = await page.getCharIndexAt(
+          (request.position.dx - rect.left) * scale,
+          page.height - (request.position.dy - rect.top) * scale,
+          tolerance: 8 * scale,
+        );
+        if (!mounted) return;
+        final selection = _controller!.textSelection;
+        if (charIndex == null) {
+          if (!request.extend) selection.value = null;
+          continue;
+        }
+        final pos = PdfTextPosition(page.pageNumber, charIndex);
+        selection.value = request.extend && selection.value != null
+            ? selection.value!.extendTo(pos)
+            : PdfTextSelection(anchor: pos, focus: pos);
       }
+    } finally {
+      _textHitTesting = false;
     }
   }
 
+  int? _findPageIndexAt(Offset position) {
+    final pageLayouts = _layout!.pageLayouts;
+    int? nearest;
+    double nearestDistance = double.infinity;
+    for (int i = 0; i < pageLayouts.length; i++) {
+      final rect = pageLayouts[i];
+      if (rect.contains(position)) return i;
+      // the gaps between pages belong to the nearest page
+      final dx =
+          max(0.0, max(rect.left - position.dx, position.dx - rect.right));
+      final dy =
+          max(0.0, max(rect.top - position.dy, position.dy - rect.bottom));
+      final distance = dx * dx + dy * dy;
+      if (distance < nearestDistance) {
+        nearestDistance = distance;
+        nearest = i;
+      }
+    }
+    return nearest;
+  }
+
   void _scheduleTask(int index, Duration wait, void Function() task) {
     _taskTimers[index]?.cancel();
     _taskTimers[index] = Timer(wait, task);
@@ -653,6 +990,15 @@ class _PdfViewerState extends State<PdfViewer>
 
   void _invalidate() => _stream.add(_controller!.value);
 
+  /// Distance between [rect] and [visibleRect] relative to the size of [visibleRect]; 0 if they intersect.
+  static double _distanceToViewport(Rect rect, Rect visibleRect) {
+    final dx = max(0.0,
+        max(rect.left - visibleRect.right, visibleRect.left - rect.right));
+    final dy = max(0.0,
+        max(rect.top - visibleRect.bottom, visibleRect.top - rect.bottom));
+    return sqrt(dx * dx + dy * dy) / max(visibleRect.longestSide, 1.0);
+  }
+
   Future<void> _ensureRealSizeCached(PdfPage page, double scale) async {
     final width = page.width * scale;
     final height = page.height * scale;
@@ -660,58 +1006,154 @@ class _PdfViewerState extends State<PdfViewer>
     if (_realSized[page.pageNumber]?.scale == scale) return;
     await synchronized(() async {
       if (_realSized[page.pageNumber]?.scale == scale) return;
-      final img = await page.render(
-        fullWidth: width,
-        fullHeight: height,
-        backgroundColor: Colors.white,
-        enableAnnotations: widget.params.enableRenderAnnotations,
-      );
-      _realSized[page.pageNumber] =
-          (image: await img.createImage(), scale: scale);
-      img.dispose();
+      final sw = Stopwatch()..start();
+      final ui.Image image;
+      try {
+        image = await _renderPage(
+          page,
+          fullWidth: width,
+          fullHeight: height,
+          isThumb: false,
+          onPartialImage: widget.params.enableProgressiveRendering
+              ? (image) {
+                  if (!mounted) {
+                    image.dispose();
+                    return;
+                  }
+                  _partialRealSized[page.pageNumber]?.dispose();
+                  _partialRealSized[page.pageNumber] = image;
+                  _invalidate();
+                }
+              : null,
+        );
+      } finally {
+        _partialRealSized.remove(page.pageNumber)?.dispose();
+      }
+      _realSized[page.pageNumber] = (image: image, scale: scale);
+      _updatePageCachePolicy(page.pageNumber, cost: sw.elapsed);
       _invalidate();
     });
   }
 
+  Future<void> _ensureDisplayListLoaded(PdfPage page) async {
+    if (_displayLists.containsKey(page.pageNumber)) return;
+    final document = _document;
+    final recording = _controller?._recording;
+    recording?._addRenderRequest(
+        page.pageNumber, PdfViewerRenderKind.displayList, 1);
+    final sw = Stopwatch()..start();
+    PdfPageDisplayList? displayList;
+    try {
+      displayList = await page.loadDisplayList(
+          enableAnnotations: widget.params.enableRenderAnnotations);
+    } catch (e) {
+      displayList = null;
+    }
+    recording?._addRenderComplete(
+        page.pageNumber, PdfViewerRenderKind.displayList, sw.elapsed);
+    if (!mounted ||
+        !identical(_document, document) ||
+        _displayLists.containsKey(page.pageNumber)) {
+      displayList?.dispose();
+      return;
+    }
+    _displayLists[page.pageNumber] = displayList;
+    if (displayList != null) {
+      _updatePageCachePolicy(page.pageNumber, cost: sw.elapsed);
+      _invalidate();
+    }
+  }
+
+  void _clearPartialImages() {
+    for (final image in _partialRealSized.values) {
+      image.dispose();
+    }
+    _partialRealSized.clear();
+  }
+
+  void _clearDisplayLists() {
+    for (final displayList in _displayLists.values) {
+      displayList?.dispose();
+    }
+    _displayLists.clear();
+  }
+
   Future<void> _ensureThumbCached(PdfPage page) async {
     if (_thumbs.containsKey(page.pageNumber)) return;
     await synchronized(() async {
       if (_thumbs.containsKey(page.pageNumber)) return;
-      _removeSomeImagesIfImageCountExceeds(
-        'thumb',
-        _thumbs.keys.toList(),
-        widget.params.maxThumbCacheCount,
+      final sw = Stopwatch()..start();
+      final image = _thumbs[page.pageNumber] = await _renderPage(
         page,
-        (pageNumber) => _thumbs.remove(pageNumber),
-      );
-      final img = await page.render(
         fullWidth: page.width,
         fullHeight: page.height,
-        backgroundColor: Colors.white,
-        enableAnnotations: widget.params.enableRenderAnnotations,
+        isThumb: true,
       );
-      _thumbs[page.pageNumber] = await img.createImage();
-      img.dispose();
+      _thumbCachePolicy.put(page.pageNumber, _imageBytes(image),
+          cost: sw.elapsed);
       _invalidate();
     });
   }
 
-  void _removeSomeImagesIfImageCountExceeds(
-      String label,
-      List<int> pageNumbers,
-      int acceptableCount,
-      PdfPage currentPage,
-      void Function(int pageNumber) removePage) {
-    if (pageNumbers.length <= acceptableCount) return;
-    double dist(int pageNumber) =>
-        (_layout!.pageLayouts[pageNumber - 1].center -
-                _layout!.pageLayouts[currentPage.pageNumber - 1].center)
-            .distanceSquared;
-
-    pageNumbers.sort((a, b) => dist(b).compareTo(dist(a)));
-    for (final key
-        in pageNumbers.sublist(0, pageNumbers.length - acceptableCount)) {
-      removePage(key);
+  Future<ui.Image> _renderPage(
+    PdfPage page, {
+    required double fullWidth,
+    required double fullHeight,
+    required bool isThumb,
+    void Function(ui.Image image)? onPartialImage,
+  }) async {
+    _rendersInFlight++;
+    final kind =
+        isThumb ? PdfViewerRenderKind.thumb : PdfViewerRenderKind.realSize;
+    final recording = _controller?._recording;
+    recording?._addRenderRequest(page.pageNumber, kind, fullWidth / page.width);
+    final sw = Stopwatch()..start();
+    try {
+      if (onPartialImage != null) {
+        // the last image of the stream is the completed one; onPartialImage owns a clone of each image
+        ui.Image? image;
+        try {
+          await for (final img in page.renderProgressive(
+            fullWidth: fullWidth,
+            fullHeight: fullHeight,
+            backgroundColor: Colors.white,
+            enableAnnotations: widget.params.enableRenderAnnotations,
+            limits: widget.params.renderLimits,
+          )) {
+            final ui.Image next;
+            try {
+              next = await img.createImage();
+            } finally {
+              img.dispose();
+            }
+            image?.dispose();
+            image = next;
+            onPartialImage(next.clone());
+          }
+        } catch (e) {
+          image?.dispose();
+          rethrow;
+        }
+        if (image == null) {
+          throw Exception(
+              'Progressive rendering of page ${page.pageNumber} produced no image.');
+        }
+        return image;
+      }
+      final img = await page.render(
+        fullWidth: fullWidth,
+        fullHeight: fullHeight,
+        backgroundColor: Colors.white,
+        enableAnnotations: widget.params.enableRenderAnnotations,
+        limits: widget.params.renderLimits,
+      );
+      final image = await img.createImage();
+      img.dispose();
+      return image;
+    } finally {
+      _rendersInFlight--;
+      _controller?.renderStats._addRender(sw.elapsed, isThumb: isThumb);
+      recording?._addRenderComplete(page.pageNumber, kind, sw.elapsed);
     }
   }
 
@@ -741,6 +1183,416 @@ class _PdfViewerState extends State<PdfViewer>
   }
 }
 
+/// Render/cache statistics collected by [PdfViewer].
+///
+/// The statistics are accumulated on [PdfViewerController.renderStats] while the viewer paints pages
+/// and are mainly used to quantify viewer smoothness on benchmarks; call [reset] to start a new measurement.
+class PdfViewerRenderStats {
+  /// Number of page paints that could use the real size image rendered at the current scale.
+  int realSizeCacheHits = 0;
+
+  /// Number of page paints that could not use the real size image at the current scale.
+  int realSizeCacheMisses = 0;
+
+  /// Number of page paints that fell back to the thumbnail image.
+  int thumbCacheHits = 0;
+
+  /// Number of page paints that had neither real size image nor thumbnail (the page is painted white).
+  int thumbCacheMisses = 0;
+
+  /// Number of completed thumbnail renders.
+  int thumbRenderCount = 0;
+
+  /// Number of completed real size renders.
+  int realSizeRenderCount = 0;
+
+  /// Total time spent on thumbnail renders (including [ui.Image] creation).
+  Duration thumbRenderTime = Duration.zero;
+
+  /// Total time spent on real size renders (including [ui.Image] creation).
+  Duration realSizeRenderTime = Duration.zero;
+
+  /// Number of render tasks pending (scheduled but not started) on the last paint.
+  int pendingTasks = 0;
+
+  /// Number of renders in flight on the last paint.
+  int rendersInFlight = 0;
+
+  /// The maximum render queue depth (pending tasks + renders in flight) observed.
+  int maxQueueDepth = 0;
+
+  int _queueDepthSampleCount = 0;
+  int _queueDepthSum = 0;
+
+  /// The average render queue depth observed on paints.
+  double get averageQueueDepth =>
+      _queueDepthSampleCount == 0 ? 0 : _queueDepthSum / _queueDepthSampleCount;
+
+  /// Hit rate of real size images (0.0 - 1.0).
+  double get realSizeCacheHitRate =>
+      _rate(realSizeCacheHits, realSizeCacheHits + realSizeCacheMisses);
+
+  /// Hit rate of thumbnails when no real size image is available (0.0 - 1.0).
+  double get thumbCacheHitRate =>
+      _rate(thumbCacheHits, thumbCacheHits + thumbCacheMisses);
+
+  static double _rate(int hits, int total) => total == 0 ? 0 : hits / total;
+
+  void _sampleQueueDepth(int pendingTasks, int rendersInFlight) {
+    this.pendingTasks = pendingTasks;
+    this.rendersInFlight = rendersInFlight;
+    final depth = pendingTasks + rendersInFlight;
+    maxQueueDepth = max(maxQueueDepth, depth);
+    _queueDepthSum += depth;
+    _queueDepthSampleCount++;
+  }
+
+  void _addRender(Duration elapsed, {required bool isThumb}) {
+    if (isThumb) {
+      thumbRenderCount++;
+      thumbRenderTime += elapsed;
+    } else {
+      realSizeRenderCount++;
+      realSizeRenderTime += elapsed;
+    }
+  }
+
+  /// Reset all the statistics.
+  void reset() {
+    realSizeCacheHits = realSizeCacheMisses = 0;
+    thumbCacheHits = thumbCacheMisses = 0;
+    thumbRenderCount = realSizeRenderCount = 0;
+    thumbRenderTime = realSizeRenderTime = Duration.zero;
+    pendingTasks = rendersInFlight = maxQueueDepth = 0;
+    _queueDepthSampleCount = _queueDepthSum = 0;
+  }
+
+  /// Convert the statistics to JSON compatible map.
+  Map<String, Object> toJson() => {
+        'realSizeCacheHits': realSizeCacheHits,
+        'realSizeCacheMisses': realSizeCacheMisses,
+        'realSizeCacheHitRate': realSizeCacheHitRate,
+        'thumbCacheHits': thumbCacheHits,
+        'thumbCacheMisses': thumbCacheMisses,
+        'thumbCacheHitRate': thumbCacheHitRate,
+        'thumbRenderCount': thumbRenderCount,
+        'thumbRenderTimeUs': thumbRenderTime.inMicroseconds,
+        'realSizeRenderCount': realSizeRenderCount,
+        'realSizeRenderTimeUs': realSizeRenderTime.inMicroseconds,
+        'maxQueueDepth': maxQueueDepth,
+        'averageQueueDepth': averageQueueDepth,
+      };
+}
+
+/// Kind of the page rendering recorded in [PdfViewerInteractionLog].
+enum PdfViewerRenderKind { thumb, realSize, displayList }
+
+/// Kind of [PdfViewerInteractionEvent].
+enum PdfViewerInteractionEventType {
+  /// The view matrix is changed; [PdfViewerInteractionEvent.values] are zoom, x, y (translation) and the view
+  /// width, height.
+  transform,
+
+  /// The pages are painted; [PdfViewerInteractionEvent.values] are the numbers of real size cache hits, misses,
+  /// thumbnail cache hits and misses on the paint (see [PdfViewerRenderStats]).
+  paint,
+
+  /// A page rendering is started; [PdfViewerInteractionEvent.values] is the rendering scale.
+  renderRequest,
+
+  /// A page rendering is completed; [PdfViewerInteractionEvent.values] is the time taken in microseconds.
+  renderComplete,
+}
+
+/// An event of [PdfViewerInteractionLog].
+@immutable
+class PdfViewerInteractionEvent {
+  const PdfViewerInteractionEvent(
+    this.time,
+    this.type, {
+    this.pageNumber = 0,
+    this.kind,
+    this.values = const [],
+  });
+
+  /// Time since the recording is started.
+  final Duration time;
+
+  final PdfViewerInteractionEventType type;
+
+  /// Page number of the rendering; 0 for the other events.
+  final int pageNumber;
+
+  /// Kind of the rendering; null for the other events.
+  final PdfViewerRenderKind? kind;
+
+  /// Values of the event; see [PdfViewerInteractionEventType].
+  final List<double> values;
+
+  /// The view matrix of [PdfViewerInteractionEventType.transform].
+  Matrix4 get matrix => Matrix4.compose(vec.Vector3(values[1], values[2], 0),
+      vec.Quaternion.identity(), vec.Vector3(values[0], values[0], 1));
+
+  /// The view size of [PdfViewerInteractionEventType.transform].
+  Size get viewSize => Size(values[3], values[4]);
+
+  /// Compact JSON representation: `[timeUs, type, pageNumber, kind (-1 if none), values...]`.
+  List<num> toJson() => [
+        time.inMicroseconds,
+        type.index,
+        pageNumber,
+        kind?.index ?? -1,
+        ...values,
+      ];
+
+  factory PdfViewerInteractionEvent.fromJson(List<dynamic> json) {
+    final kind = (json[3] as num).toInt();
+    return PdfViewerInteractionEvent(
+      Duration(microseconds: (json[0] as num).toInt()),
+      PdfViewerInteractionEventType.values[(json[1] as num).toInt()],
+      pageNumber: (json[2] as num).toInt(),
+      kind: kind < 0 ? null : PdfViewerRenderKind.values[kind],
+      values: [for (final v in json.skip(4)) (v as num).toDouble()],
+    );
+  }
+}
+
+/// Log of the interactions on [PdfViewer] to reproduce and analyze the rendering performance of real sessions.
+///
+/// The log is recorded by [PdfViewerController.startRecording]: view matrix changes, paints (with the cache hits
+/// and misses), page rendering requests and their completion times. It can be saved by [toJson] and fed back to a
+/// viewer showing the same document by [PdfViewerController.replay], which records a new log to compare the
+/// rendering sequences and timings (see [report] and [firstRenderRequestMismatch]) of different devices,
+/// schedulers or cache settings.
+class PdfViewerInteractionLog {
+  PdfViewerInteractionLog({
+    this.sourceName,
+    this.maxEvents = 100000,
+    List<PdfViewerInteractionEvent>? events,
+    Duration Function()? clock,
+  }) : events = events ?? [] {
+    if (clock != null) {
+      _clock = clock;
+    } else {
+      final sw = Stopwatch()..start();
+      _clock = () => sw.elapsed;
+    }
+  }
+
+  /// [PdfDocumentRef.sourceName] of the document shown on the viewer.
+  final String? sourceName;
+
+  /// The maximum number of the events recorded; the events after that are dropped and [isTruncated] is set.
+  final int maxEvents;
+
+  final List<PdfViewerInteractionEvent> events;
+
+  bool _truncated = false;
+
+  /// Whether some events are dropped because of [maxEvents].
+  bool get isTruncated => _truncated;
+
+  late final Duration Function() _clock;
+  Duration _lastTime = Duration.zero;
+  Size? _lastViewSize;
+
+  /// The view size on the first transform event; the log should be replayed on a viewer of the same size.
+  Size? get viewSize {
+    for (final e in events) {
+      if (e.type == PdfViewerInteractionEventType.transform) return e.viewSize;
+    }
+    return null;
+  }
+
+  /// The rendering requests in the order: page number, kind and scale (rounded to 1/1000).
+  List<({int pageNumber, PdfViewerRenderKind kind, double scale})>
+      get renderRequests => [
+            for (final e in events)
+              if (e.type == PdfViewerInteractionEventType.renderRequest)
+                (
+                  pageNumber: e.pageNumber,
+                  kind: e.kind!,
+                  scale: (e.values[0] * 1000).roundToDouble() / 1000,
+                ),
+          ];
+
+  /// The index of the first rendering request different from [other]'s one; null if the requests are identical.
+  int? firstRenderRequestMismatch(PdfViewerInteractionLog other) {
+    final a = renderRequests;
+    final b = other.renderRequests;
+    for (int i = 0; i < min(a.length, b.length); i++) {
+      if (a[i] != b[i]) return i;
+    }
+    return a.length == b.length ? null : min(a.length, b.length);
+  }
+
+  /// Summarize the log.
+  PdfViewerInteractionReport report() => PdfViewerInteractionReport._(this);
+
+  void _add(
+    PdfViewerInteractionEventType type, {
+    int pageNumber = 0,
+    PdfViewerRenderKind? kind,
+    List<double> values = const [],
+  }) {
+    if (events.length >= maxEvents) {
+      _truncated = true;
+      return;
+    }
+    // the clock may go backward if it is replaced (e.g. by a fake one on tests)
+    final time = _clock();
+    if (time > _lastTime) _lastTime = time;
+    events.add(PdfViewerInteractionEvent(_lastTime, type,
+        pageNumber: pageNumber, kind: kind, values: values));
+  }
+
+  void _addTransform(Matrix4 matrix, Size? viewSize) {
+    viewSize ??= _lastViewSize;
+    if (viewSize == null) return;
+    _lastViewSize = viewSize;
+    _add(PdfViewerInteractionEventType.transform, values: [
+      matrix.zoom,
+      matrix.xZoomed,
+      matrix.yZoomed,
+      viewSize.width,
+      viewSize.height,
+    ]);
+  }
+
+  void _addPaint(int realSizeCacheHits, int realSizeCacheMisses,
+      int thumbCacheHits, int thumbCacheMisses) {
+    _add(PdfViewerInteractionEventType.paint, values: [
+      realSizeCacheHits.toDouble(),
+      realSizeCacheMisses.toDouble(),
+      thumbCacheHits.toDouble(),
+      thumbCacheMisses.toDouble(),
+    ]);
+  }
+
+  void _addRenderRequest(
+      int pageNumber, PdfViewerRenderKind kind, double scale) {
+    _add(PdfViewerInteractionEventType.renderRequest,
+        pageNumber: pageNumber, kind: kind, values: [scale]);
+  }
+
+  void _addRenderComplete(
+      int pageNumber, PdfViewerRenderKind kind, Duration elapsed) {
+    _add(PdfViewerInteractionEventType.renderComplete,
+        pageNumber: pageNumber,
+        kind: kind,
+        values: [elapsed.inMicroseconds.toDouble()]);
+  }
+
+  Map<String, Object?> toJson() => {
+        'version': 1,
+        'sourceName': sourceName,
+        'truncated': _truncated,
+        'events': [for (final e in events) e.toJson()],
+      };
+
+  factory PdfViewerInteractionLog.fromJson(Map<String, dynamic> json) {
+    if (json['version'] != 1) {
+      throw FormatException(
+          'Unsupported interaction log version: ${json['version']}');
+    }
+    final log = PdfViewerInteractionLog(
+      sourceName: json['sourceName'] as String?,
+      events: [
+        for (final e in json['events'] as List<dynamic>)
+          PdfViewerInteractionEvent.fromJson(e as List<dynamic>),
+      ],
+    );
+    log._truncated = json['truncated'] == true;
+    return log;
+  }
+}
+
+/// Summary of [PdfViewerInteractionLog]; see [PdfViewerInteractionLog.report].
+class PdfViewerInteractionReport {
+  PdfViewerInteractionReport._(PdfViewerInteractionLog log) {
+    final times = <PdfViewerRenderKind, List<int>>{};
+    for (final e in log.events) {
+      switch (e.type) {
+        case PdfViewerInteractionEventType.transform:
+          transformCount++;
+        case PdfViewerInteractionEventType.paint:
+          paintCount++;
+          realSizeCacheHits += e.values[0].toInt();
+          realSizeCacheMisses += e.values[1].toInt();
+          thumbCacheHits += e.values[2].toInt();
+          thumbCacheMisses += e.values[3].toInt();
+        case PdfViewerInteractionEventType.renderRequest:
+          renderRequestCount++;
+        case PdfViewerInteractionEventType.renderComplete:
+          (times[e.kind!] ??= []).add(e.values[0].toInt());
+      }
+    }
+    duration = log.events.isEmpty ? Duration.zero : log.events.last.time;
+    renderTimes = {
+      for (final entry in times.entries)
+        entry.key: PdfViewerRenderTimes._(entry.value),
+    };
+  }
+
+  /// Time from the start of the recording to the last event.
+  late final Duration duration;
+
+  int transformCount = 0;
+  int paintCount = 0;
+  int renderRequestCount = 0;
+  int realSizeCacheHits = 0;
+  int realSizeCacheMisses = 0;
+  int thumbCacheHits = 0;
+  int thumbCacheMisses = 0;
+
+  /// The rendering times of the completed renderings by kind.
+  late final Map<PdfViewerRenderKind, PdfViewerRenderTimes> renderTimes;
+
+  /// Convert the report to JSON compatible map.
+  Map<String, Object> toJson() => {
+        'durationUs': duration.inMicroseconds,
+        'transformCount': transformCount,
+        'paintCount': paintCount,
+        'renderRequestCount': renderRequestCount,
+        'realSizeCacheHits': realSizeCacheHits,
+        'realSizeCacheMisses': realSizeCacheMisses,
+        'thumbCacheHits': thumbCacheHits,
+        'thumbCacheMisses': thumbCacheMisses,
+        'renderTimes': {
+          for (final entry in renderTimes.entries)
+            entry.key.name: entry.value.toJson(),
+        },
+      };
+}
+
+/// Distribution of the rendering times in [PdfViewerInteractionReport].
+class PdfViewerRenderTimes {
+  PdfViewerRenderTimes._(List<int> timesUs) {
+    timesUs.sort();
+    count = timesUs.length;
+    Duration at(double p) =>
+        Duration(microseconds: timesUs[((count - 1) * p).round()]);
+    total = Duration(microseconds: timesUs.fold(0, (a, b) => a + b));
+    median = at(0.5);
+    p95 = at(0.95);
+    max = at(1);
+  }
+
+  late final int count;
+  late final Duration total;
+  late final Duration median;
+  late final Duration p95;
+  late final Duration max;
+
+  Map<String, Object> toJson() => {
+        'count': count,
+        'totalUs': total.inMicroseconds,
+        'medianUs': median.inMicroseconds,
+        'p95Us': p95.inMicroseconds,
+        'maxUs': max.inMicroseconds,
+      };
+}
+
 class PdfPageLayout {
   PdfPageLayout({required this.pageLayouts, required this.documentSize});
   final List<Rect> pageLayouts;
@@ -753,6 +1605,90 @@ class PdfViewerController extends TransformationController {
 
   static const maxZoom = 8.0;
 
+  /// Render/cache statistics of the attached viewer.
+  final renderStats = PdfViewerRenderStats();
+
+  PdfViewerInteractionLog? _recording;
+
+  /// The interaction log being recorded if any; see [startRecording].
+  PdfViewerInteractionLog? get recording => _recording;
+
+  /// Start recording the interactions on the attached viewer into a new [PdfViewerInteractionLog]; the recording
+  /// in progress (if any) is discarded.
+  ///
+  /// [clock] gives the time since the start of the recording; pass a fake one (e.g. driven by the test's pump) to
+  /// get reproducible timestamps.
+  PdfViewerInteractionLog startRecording({
+    int maxEvents = 100000,
+    Duration Function()? clock,
+  }) {
+    _recording = PdfViewerInteractionLog(
+      sourceName: _state?.widget.documentRef.sourceName,
+      maxEvents: maxEvents,
+      clock: clock,
+    );
+    if (isReady) _recording!._addTransform(value, viewSize);
+    return _recording!;
+  }
+
+  /// Stop the recording and returns the recorded log; null if not recording.
+  PdfViewerInteractionLog? stopRecording() {
+    final log = _recording;
+    _recording = null;
+    return log;
+  }
+
+  /// Replay the view matrix changes of [log] on the attached viewer with the recorded intervals (divided by
+  /// [speed]) while recording a new log, which is returned after the recorded duration of [log].
+  ///
+  /// The viewer should show the same document at the same size ([PdfViewerInteractionLog.viewSize]). The waits
+  /// are done by [Future.delayed], so the replay is deterministic under fake time (e.g. `flutter test` with
+  /// `tester.pump`) and [clock] of [startRecording] should be the fake one then.
+  Future<PdfViewerInteractionLog> replay(
+    PdfViewerInteractionLog log, {
+    double speed = 1.0,
+    Duration Function()? clock,
+  }) async {
+    final recording = startRecording(clock: clock);
+    var time = Duration.zero;
+    for (final e in log.events) {
+      if (e.type != PdfViewerInteractionEventType.transform) continue;
+      final wait = (e.time - time) * (1 / speed);
+      time = e.time;
+      if (wait > Duration.zero) await Future.delayed(wait);
+      if (!identical(_recording, recording) || !isReady) break;
+      value = e.matrix;
+    }
+    // the renderings triggered by the last changes
+    if (log.events.isNotEmpty && identical(_recording, recording)) {
+      final tail = (log.events.last.time - time) * (1 / speed);
+      if (tail > Duration.zero) await Future.delayed(tail);
+    }
+    if (identical(_recording, recording)) _recording = null;
+    return recording;
+  }
+
+  /// Current text selection; it is updated by long-press dragging on the pages if
+  /// [PdfViewerParams.enableTextSelection] is true.
+  final textSelection = ValueNotifier<PdfTextSelection?>(null);
+
+  /// Extract the selected text lazily page by page; see [PdfDocument.streamTextSelection].
+  Stream<String> streamSelectedText() {
+    final selection = textSelection.value;
+    if (selection == null) return const Stream.empty();
+    return _state!._document!.streamTextSelection(selection);
+  }
+
+  /// Copy the selected text to the clipboard.
+  Future<void> copyTextSelection() async {
+    final sb = StringBuffer();
+    await for (final chunk in streamSelectedText()) {
+      sb.write(chunk);
+    }
+    if (sb.isEmpty) return;
+    await Clipboard.setData(ClipboardData(text: sb.toString()));
+  }
+
   Size get documentSize => _state!._layout!.documentSize;
   Size get viewSize => _state!._viewSize!;
   double get coverScale => _state!._coverScale!;
@@ -768,6 +1704,12 @@ class PdfViewerController extends TransformationController {
   /// The current page number if available.
   int? get pageNumber => _state?._pageNumber;
 
+  /// Determine whether the controller is attached to a viewer that has finished the initial layout.
+  bool get isReady =>
+      _state?._document != null &&
+      _state?._layout != null &&
+      _state?._viewSize != null;
+
   void _attach(_PdfViewerState? state) {
     _state = state;
   }
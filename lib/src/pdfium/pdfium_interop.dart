@@ -20,7 +20,8 @@ String _getModuleFileName() {
 final interopLib = DynamicLibrary.open(_getModuleFileName());
 
 final _pdfrx_file_access_create = interopLib.lookupFunction<
-    IntPtr Function(UnsignedLong, IntPtr, IntPtr), int Function(int, int, int)>(
+    IntPtr Function(UnsignedLong, IntPtr, IntPtr, UnsignedInt),
+    int Function(int, int, int, int)>(
   'pdfrx_file_access_create',
 );
 
@@ -29,41 +30,308 @@ final _pdfrx_file_access_destroy =
   'pdfrx_file_access_destroy',
 );
 
-final _pdfrx_file_access_set_value = interopLib
-    .lookupFunction<Void Function(IntPtr, IntPtr), void Function(int, int)>(
+final _pdfrx_file_access_set_value = interopLib.lookupFunction<
+    Void Function(IntPtr, Uint64, Int), void Function(int, int, int)>(
   'pdfrx_file_access_set_value',
 );
 
-typedef _NativeFileReadCallable
-    = NativeCallable<Void Function(IntPtr, IntPtr, Pointer<Uint8>, IntPtr)>;
+final _pdfrx_file_access_cancel =
+    interopLib.lookupFunction<Void Function(IntPtr), void Function(int)>(
+  'pdfrx_file_access_cancel',
+);
+
+final pdfrx_render_page = interopLib.lookupFunction<
+    Int Function(FPDF_PAGE, Pointer<Uint8>, Int64, Int, Int, Int, Int, Int, Int,
+        Int, Int, UnsignedInt, Int),
+    int Function(FPDF_PAGE, Pointer<Uint8>, int, int, int, int, int, int, int,
+        int, int, int, int)>(
+  'pdfrx_render_page',
+);
+
+const pdfrxRenderInvalidArgument = -1; // PDFRX_RENDER_INVALID_ARGUMENT
+
+final pdfrx_buffer_alloc = interopLib.lookupFunction<
+    Pointer<Uint8> Function(Int64), Pointer<Uint8> Function(int)>(
+  'pdfrx_buffer_alloc',
+);
+
+final pdfrx_buffer_retain = interopLib.lookupFunction<
+    Void Function(Pointer<Void>), void Function(Pointer<Void>)>(
+  'pdfrx_buffer_retain',
+);
+
+/// `pdfrx_buffer_release` used as the native finalizer of the pixel buffers.
+final pdfrx_buffer_release_ptr =
+    interopLib.lookup<NativeFinalizerFunction>('pdfrx_buffer_release');
+
+final pdfrx_buffer_release = pdfrx_buffer_release_ptr
+    .asFunction<void Function(Pointer<Void>)>();
+
+final pdfrx_render_progressive_start = interopLib.lookupFunction<
+    IntPtr Function(FPDF_PAGE, Int, Int, Int, Int, Int, Int, UnsignedInt, Int,
+        Int, Int64, Int, Int),
+    int Function(FPDF_PAGE, int, int, int, int, int, int, int, int, int, int,
+        int, int)>(
+  'pdfrx_render_progressive_start',
+);
+
+final pdfrx_render_progressive_continue = interopLib
+    .lookupFunction<Int Function(IntPtr, Int), int Function(int, int)>(
+  'pdfrx_render_progressive_continue',
+);
+
+final pdfrx_render_progressive_status =
+    interopLib.lookupFunction<Int Function(IntPtr), int Function(int)>(
+  'pdfrx_render_progressive_status',
+);
+
+final pdfrx_render_progressive_get_result = interopLib.lookupFunction<
+    Int Function(IntPtr, Pointer<Int>, Pointer<Int>),
+    int Function(int, Pointer<Int>, Pointer<Int>)>(
+  'pdfrx_render_progressive_get_result',
+);
+
+final pdfrx_render_progressive_snapshot = interopLib.lookupFunction<
+    Pointer<Uint8> Function(IntPtr), Pointer<Uint8> Function(int)>(
+  'pdfrx_render_progressive_snapshot',
+);
+
+final pdfrx_render_progressive_close = interopLib.lookupFunction<
+    Pointer<Uint8> Function(IntPtr, Int), Pointer<Uint8> Function(int, int)>(
+  'pdfrx_render_progressive_close',
+);
+
+const pdfrxRenderToBeContinued = 1; // FPDF_RENDER_TOBECONTINUED
+const pdfrxRenderDone = 2; // FPDF_RENDER_DONE
+
+final pdfrx_mapped_file_open = interopLib
+    .lookupFunction<IntPtr Function(Pointer<Char>), int Function(Pointer<Char>)>(
+  'pdfrx_mapped_file_open',
+);
+
+final pdfrx_mapped_file_data = interopLib.lookupFunction<
+    Pointer<Uint8> Function(IntPtr), Pointer<Uint8> Function(int)>(
+  'pdfrx_mapped_file_data',
+);
+
+final pdfrx_mapped_file_size =
+    interopLib.lookupFunction<Int64 Function(IntPtr), int Function(int)>(
+  'pdfrx_mapped_file_size',
+);
+
+final pdfrx_mapped_file_close =
+    interopLib.lookupFunction<Void Function(IntPtr), void Function(int)>(
+  'pdfrx_mapped_file_close',
+);
+
+final pdfrx_page_cache_create = interopLib
+    .lookupFunction<IntPtr Function(Int64), int Function(int)>(
+  'pdfrx_page_cache_create',
+);
+
+final pdfrx_page_cache_destroy =
+    interopLib.lookupFunction<Void Function(IntPtr), void Function(int)>(
+  'pdfrx_page_cache_destroy',
+);
+
+final pdfrx_page_cache_prepare = interopLib.lookupFunction<
+    Int Function(IntPtr, Pointer<FPDF_PAGE>, Int, Int, Int64),
+    int Function(int, Pointer<FPDF_PAGE>, int, int, int)>(
+  'pdfrx_page_cache_prepare',
+);
+
+final pdfrx_page_cache_acquire_text = interopLib.lookupFunction<
+    FPDF_TEXTPAGE Function(IntPtr, FPDF_PAGE),
+    FPDF_TEXTPAGE Function(int, FPDF_PAGE)>(
+  'pdfrx_page_cache_acquire_text',
+);
+
+final pdfrx_page_cache_release_text = interopLib.lookupFunction<
+    Void Function(IntPtr, FPDF_PAGE, FPDF_TEXTPAGE),
+    void Function(int, FPDF_PAGE, FPDF_TEXTPAGE)>(
+  'pdfrx_page_cache_release_text',
+);
+
+final pdfrx_text_selection_rects = interopLib.lookupFunction<
+    Int Function(IntPtr, Pointer<FPDF_PAGE>, Int, Pointer<Int>, Pointer<Int>,
+        Pointer<Double>, Int, Pointer<Int>),
+    int Function(int, Pointer<FPDF_PAGE>, int, Pointer<Int>, Pointer<Int>,
+        Pointer<Double>, int, Pointer<Int>)>(
+  'pdfrx_text_selection_rects',
+);
+
+final pdfrx_text_char_index_at = interopLib.lookupFunction<
+    Int Function(IntPtr, FPDF_PAGE, Double, Double, Double),
+    int Function(int, FPDF_PAGE, double, double, double)>(
+  'pdfrx_text_char_index_at',
+);
+
+final pdfrx_text_get_range = interopLib.lookupFunction<
+    Int Function(IntPtr, FPDF_PAGE, Int, Int, Pointer<Uint16>, Int),
+    int Function(int, FPDF_PAGE, int, int, Pointer<Uint16>, int)>(
+  'pdfrx_text_get_range',
+);
+
+final pdfrx_text_get_region = interopLib.lookupFunction<
+    Pointer<Uint8> Function(
+        IntPtr, FPDF_PAGE, Double, Double, Double, Double, Pointer<Int64>),
+    Pointer<Uint8> Function(int, FPDF_PAGE, double, double, double, double,
+        Pointer<Int64>)>(
+  'pdfrx_text_get_region',
+);
+
+final pdfrx_page_display_list = interopLib.lookupFunction<
+    Pointer<Uint8> Function(
+        IntPtr, FPDF_DOCUMENT, FPDF_PAGE, Int, Int64, Pointer<Int64>),
+    Pointer<Uint8> Function(
+        int, FPDF_DOCUMENT, FPDF_PAGE, int, int, Pointer<Int64>)>(
+  'pdfrx_page_display_list',
+);
+
+final pdfrx_page_reflow = interopLib.lookupFunction<
+    Pointer<Uint8> Function(IntPtr, FPDF_PAGE, Pointer<Int64>),
+    Pointer<Uint8> Function(int, FPDF_PAGE, Pointer<Int64>)>(
+  'pdfrx_page_reflow',
+);
+
+final pdfrx_page_signature = interopLib
+    .lookupFunction<Uint64 Function(FPDF_PAGE), int Function(FPDF_PAGE)>(
+  'pdfrx_page_signature',
+);
+
+final pdfrx_page_diff = interopLib.lookupFunction<
+    Int Function(FPDF_PAGE, FPDF_PAGE, Int, Int, Float, Int, Int,
+        Pointer<Double>, Int, Pointer<Uint8>),
+    int Function(FPDF_PAGE, FPDF_PAGE, int, int, double, int, int,
+        Pointer<Double>, int, Pointer<Uint8>)>(
+  'pdfrx_page_diff',
+);
+
+final pdfrx_annotations_snapshot = interopLib.lookupFunction<
+    Pointer<Uint8> Function(Pointer<FPDF_PAGE>, Int, Pointer<Int64>),
+    Pointer<Uint8> Function(Pointer<FPDF_PAGE>, int, Pointer<Int64>)>(
+  'pdfrx_annotations_snapshot',
+);
+
+final pdfrx_free = interopLib.lookupFunction<Void Function(Pointer<Void>),
+    void Function(Pointer<Void>)>(
+  'pdfrx_free',
+);
+
+final pdfrx_form_fields_snapshot = interopLib.lookupFunction<
+    Pointer<Uint8> Function(
+        FPDF_DOCUMENT, Pointer<FPDF_PAGE>, Int, Pointer<Int64>),
+    Pointer<Uint8> Function(
+        FPDF_DOCUMENT, Pointer<FPDF_PAGE>, int, Pointer<Int64>)>(
+  'pdfrx_form_fields_snapshot',
+);
+
+final pdfrx_form_fields_update = interopLib.lookupFunction<
+    Int Function(
+        FPDF_DOCUMENT, Pointer<FPDF_PAGE>, Int, Pointer<Uint8>, Int64),
+    int Function(FPDF_DOCUMENT, Pointer<FPDF_PAGE>, int, Pointer<Uint8>,
+        int)>(
+  'pdfrx_form_fields_update',
+);
+
+final pdfrx_attachments_snapshot = interopLib.lookupFunction<
+    Pointer<Uint8> Function(FPDF_DOCUMENT, Pointer<Int64>),
+    Pointer<Uint8> Function(FPDF_DOCUMENT, Pointer<Int64>)>(
+  'pdfrx_attachments_snapshot',
+);
+
+final pdfrx_attachment_write_file = interopLib.lookupFunction<
+    Int64 Function(FPDF_DOCUMENT, Int, Pointer<Char>, Int),
+    int Function(FPDF_DOCUMENT, int, Pointer<Char>, int)>(
+  'pdfrx_attachment_write_file',
+);
+
+final pdfrx_fingerprint_hash_chunks = interopLib.lookupFunction<
+    Int64 Function(Pointer<Uint8>, Int64, Int64, Int, Pointer<Uint64>),
+    int Function(Pointer<Uint8>, int, int, int, Pointer<Uint64>)>(
+  'pdfrx_fingerprint_hash_chunks',
+);
+
+final pdfrx_fingerprint_combine = interopLib.lookupFunction<
+    Uint64 Function(Pointer<Uint64>, Int64, Int64, Pointer<Uint8>, Int),
+    int Function(Pointer<Uint64>, int, int, Pointer<Uint8>, int)>(
+  'pdfrx_fingerprint_combine',
+);
+
+final pdfrx_fingerprint_file = interopLib.lookupFunction<
+    Int Function(Pointer<Char>, Int, Pointer<Uint8>, Int, Pointer<Uint64>,
+        Pointer<Int64>),
+    int Function(Pointer<Char>, int, Pointer<Uint8>, int, Pointer<Uint64>,
+        Pointer<Int64>)>(
+  'pdfrx_fingerprint_file',
+);
+
+final pdfrx_fingerprint_file_chunks = interopLib.lookupFunction<
+    Int64 Function(
+        Pointer<Char>, Int, Pointer<Uint64>, Int64, Pointer<Int64>),
+    int Function(Pointer<Char>, int, Pointer<Uint64>, int, Pointer<Int64>)>(
+  'pdfrx_fingerprint_file_chunks',
+);
+
+final pdfrx_fingerprint_file_identifier = interopLib.lookupFunction<
+    Int Function(FPDF_DOCUMENT, Pointer<Uint8>, Int),
+    int Function(FPDF_DOCUMENT, Pointer<Uint8>, int)>(
+  'pdfrx_fingerprint_file_identifier',
+);
+
+typedef _NativeFileReadCallable = NativeCallable<
+    Void Function(IntPtr, IntPtr, Pointer<Uint8>, IntPtr, Uint64)>;
 
 class FileAccess {
   FileAccess(
     int fileSize,
-    FutureOr<int> Function(Uint8List buffer, int position, int size) read,
-  ) {
+    FutureOr<int> Function(Uint8List buffer, int position, int size) read, {
+    Duration readTimeout = defaultReadTimeout,
+  }) {
     void readNative(
       int param,
       int position,
       Pointer<Uint8> buffer,
       int size,
+      int requestId,
     ) async {
+      // NOTE: buffer is valid until the result is set; the native object is not destroyed while reading
+      _pendingReads++;
+      int readSize;
       try {
-        final readSize = await read(buffer.asTypedList(size), position, size);
-        _pdfrx_file_access_set_value(_fileAccess, readSize);
+        readSize = await read(buffer.asTypedList(size), position, size);
       } catch (e) {
-        _pdfrx_file_access_set_value(_fileAccess, -1);
+        readSize = -1;
+      }
+      _pendingReads--;
+      _pdfrx_file_access_set_value(_fileAccess, requestId, readSize);
+      if (_disposed && _pendingReads == 0) {
+        _pdfrx_file_access_destroy(_fileAccess);
       }
     }
 
     _nativeCallable = _NativeFileReadCallable.listener(readNative);
-    _fileAccess = _pdfrx_file_access_create(
-        fileSize, _nativeCallable.nativeFunction.address, 0);
+    _fileAccess = _pdfrx_file_access_create(fileSize,
+        _nativeCallable.nativeFunction.address, 0, readTimeout.inMilliseconds);
+  }
+
+  /// The default timeout for a block read; [Duration.zero] means no timeout.
+  static const defaultReadTimeout = Duration(seconds: 60);
+
+  /// Cancel the file access; pending and future reads fail immediately.
+  void cancel() {
+    if (_disposed) return;
+    _pdfrx_file_access_cancel(_fileAccess);
   }
 
   void dispose() {
-    _pdfrx_file_access_destroy(_fileAccess);
+    if (_disposed) return;
+    _disposed = true;
     _nativeCallable.close();
+    // if some reads are still running (timed out), they will destroy the native object
+    if (_pendingReads == 0) {
+      _pdfrx_file_access_destroy(_fileAccess);
+    }
   }
 
   Pointer<FPDF_FILEACCESS> get fileAccess =>
@@ -71,4 +339,6 @@ class FileAccess {
 
   late final int _fileAccess;
   late final _NativeFileReadCallable _nativeCallable;
+  int _pendingReads = 0;
+  bool _disposed = false;
 }
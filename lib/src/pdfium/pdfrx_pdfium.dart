@@ -2,6 +2,7 @@
 import 'dart:async';
 import 'dart:ffi';
 import 'dart:io';
+import 'dart:math';
 import 'dart:ui' as ui;
 
 import 'package:ffi/ffi.dart';
@@ -49,14 +50,70 @@ void _init() {
 class PdfDocumentFactoryImpl extends PdfDocumentFactory {
   @override
   Future<PdfDocument> openAsset(String name, {String? password}) async {
+    final path = _assetFilePath(name);
+    if (path != null) {
+      final document = await _openMappedFile(
+        path,
+        'asset:$name',
+        password: password,
+      );
+      if (document != null) return document;
+    }
+    // the asset is copied once; the content is read from the Dart buffer on demand
     final data = await rootBundle.load(name);
     return await _openData(
-      data.buffer.asUint8List(),
+      data.buffer.asUint8List(data.offsetInBytes, data.lengthInBytes),
       'asset:$name',
       password: password,
     );
   }
 
+  /// Path of the asset if the assets are stored as plain files (`flutter_assets` directory of the desktop apps and
+  /// iOS); null otherwise (Android packs them into the APK).
+  static String? _assetFilePath(String name) {
+    final exeDir = File(Platform.resolvedExecutable).parent.path;
+    final String assetsDir;
+    if (Platform.isLinux || Platform.isWindows) {
+      assetsDir = '$exeDir/data/flutter_assets';
+    } else if (Platform.isMacOS) {
+      // the executable is in Contents/MacOS
+      assetsDir =
+          '$exeDir/../Frameworks/App.framework/Resources/flutter_assets';
+    } else if (Platform.isIOS) {
+      assetsDir = '$exeDir/Frameworks/App.framework/flutter_assets';
+    } else {
+      return null;
+    }
+    final path = File('$assetsDir/$name').absolute.path;
+    return File(path).existsSync() ? path : null;
+  }
+
+  /// Open the file by mapping it on memory instead of reading it; returns null if the file cannot be mapped.
+  Future<PdfDocument?> _openMappedFile(
+    String path,
+    String sourceName, {
+    String? password,
+  }) async {
+    _init();
+    final file = using((arena) => pdfrx_mapped_file_open(path.toUtf8(arena)));
+    if (file == 0) return null;
+    try {
+      return await using((arena) => PdfDocumentPdfium.fromPdfDocument(
+            pdfium.FPDF_LoadMemDocument64(
+              pdfrx_mapped_file_data(file).cast<Void>(),
+              pdfrx_mapped_file_size(file),
+              password?.toUtf8(arena) ?? nullptr,
+            ),
+            sourceName: sourceName,
+            source: _PdfDocumentSource.file(path),
+            disposeCallback: () => pdfrx_mapped_file_close(file),
+          ));
+    } catch (e) {
+      pdfrx_mapped_file_close(file);
+      rethrow;
+    }
+  }
+
   @override
   Future<PdfDocument> openData(
     Uint8List data, {
@@ -79,6 +136,7 @@ class PdfDocumentFactoryImpl extends PdfDocumentFactory {
         pdfium.FPDF_LoadDocument(
             filePath.toUtf8(arena), password?.toUtf8(arena) ?? nullptr),
         sourceName: filePath,
+        source: _PdfDocumentSource.file(filePath),
       );
     });
   }
@@ -97,9 +155,7 @@ class PdfDocumentFactoryImpl extends PdfDocumentFactory {
           size = data.length - position;
           if (size < 0) return -1;
         }
-        for (int i = 0; i < size; i++) {
-          buffer[i] = data[position + i];
-        }
+        buffer.setRange(0, size, data, position);
         return size;
       },
       fileSize: data.length,
@@ -119,16 +175,30 @@ class PdfDocumentFactoryImpl extends PdfDocumentFactory {
     String? password,
     int? maxSizeToCacheOnMemory,
     void Function()? onDispose,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
   }) async {
     _init();
 
     maxSizeToCacheOnMemory ??= 1024 * 1024; // the default is 1MB
 
+    final openToken =
+        PdfCancellationToken.withTimeout(cancellationToken, timeout);
+    openToken?.throwIfCanceled();
+
     // If the file size is smaller than the specified size, load the file on memory
     if (fileSize < maxSizeToCacheOnMemory) {
       return await using((arena) async {
         final buffer = calloc.allocate<Uint8>(fileSize);
-        await read(buffer.asTypedList(fileSize), 0, fileSize);
+        try {
+          await read(buffer.asTypedList(fileSize), 0, fileSize);
+          openToken?.throwIfCanceled();
+        } catch (e) {
+          calloc.free(buffer);
+          rethrow;
+        } finally {
+          openToken?.complete();
+        }
         return PdfDocumentPdfium.fromPdfDocument(
           pdfium.FPDF_LoadMemDocument(
             buffer.cast<Void>(),
@@ -136,6 +206,7 @@ class PdfDocumentFactoryImpl extends PdfDocumentFactory {
             password?.toUtf8(arena) ?? nullptr,
           ),
           sourceName: sourceName,
+          source: _PdfDocumentSource.custom(read, fileSize),
           disposeCallback: () {
             calloc.free(buffer);
             onDispose?.call();
@@ -146,22 +217,43 @@ class PdfDocumentFactoryImpl extends PdfDocumentFactory {
 
     // Otherwise, load the file on demand
     final fa = FileAccess(fileSize, read);
-    final doc = await using((arena) async => (await _globalWorker).compute(
-          (params) {
-            return pdfium.FPDF_LoadCustomDocument(
-              Pointer<pdfium_bindings.FPDF_FILEACCESS>.fromAddress(
-                  params.fileAccess),
-              Pointer<Char>.fromAddress(params.password),
-            ).address;
-          },
-          (
-            fileAccess: fa.fileAccess.address,
-            password: password?.toUtf8(arena).address ?? 0,
-          ),
-        ));
+    // cancellation makes the pending/future reads fail and FPDF_LoadCustomDocument returns immediately
+    openToken?.addListener(fa.cancel);
+    final int doc;
+    try {
+      doc = await using((arena) async => (await _globalWorker).compute(
+            (params) {
+              return pdfium.FPDF_LoadCustomDocument(
+                Pointer<pdfium_bindings.FPDF_FILEACCESS>.fromAddress(
+                    params.fileAccess),
+                Pointer<Char>.fromAddress(params.password),
+              ).address;
+            },
+            (
+              fileAccess: fa.fileAccess.address,
+              password: password?.toUtf8(arena).address ?? 0,
+            ),
+          ));
+    } finally {
+      openToken?.complete();
+      openToken?.removeListener(fa.cancel);
+    }
+    if (doc == 0 || openToken?.isCanceled == true) {
+      if (doc != 0) {
+        await (await _globalWorker).compute(
+          (doc) => pdfium.FPDF_CloseDocument(
+              pdfium_bindings.FPDF_DOCUMENT.fromAddress(doc)),
+          doc,
+        );
+      }
+      fa.dispose();
+      openToken?.throwIfCanceled();
+      throw Exception('Failed to load PDF document');
+    }
     return PdfDocumentPdfium.fromPdfDocument(
       pdfium_bindings.FPDF_DOCUMENT.fromAddress(doc),
       sourceName: sourceName,
+      source: _PdfDocumentSource.custom(read, fileSize),
       disposeCallback: () {
         fa.dispose();
         onDispose?.call();
@@ -173,8 +265,68 @@ class PdfDocumentFactoryImpl extends PdfDocumentFactory {
   Future<PdfDocument> openUri(
     Uri uri, {
     String? password,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
   }) {
-    return pdfDocumentFromUri(uri, password: password);
+    return pdfDocumentFromUri(
+      uri,
+      password: password,
+      cancellationToken: cancellationToken,
+      timeout: timeout,
+    );
+  }
+
+  @override
+  Future<PdfDocument> openUriSynced(
+    Uri uri, {
+    required String filePath,
+    Uri? manifestUri,
+    String? password,
+    void Function(PdfSyncResult result)? onSynced,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
+  }) {
+    return pdfDocumentSyncFromUri(
+      uri,
+      filePath: filePath,
+      manifestUri: manifestUri,
+      password: password,
+      onSynced: onSynced,
+      cancellationToken: cancellationToken,
+      timeout: timeout,
+    );
+  }
+
+  @override
+  Future<PdfBlockManifest> createBlockManifest(String filePath) async {
+    final manifest = await compute(_hashFileBlocks, filePath);
+    if (manifest == null) {
+      throw FileSystemException('Failed to hash the file blocks.', filePath);
+    }
+    return manifest;
+  }
+
+  static PdfBlockManifest? _hashFileBlocks(String filePath) {
+    return using((arena) {
+      final path = filePath.toUtf8(arena);
+      final size = arena.allocate<Int64>(sizeOf<Int64>());
+      // the file may grow between the calls; retry with the larger buffer
+      var maxChunks = 0;
+      for (;;) {
+        final hashes =
+            arena.allocate<Uint64>(sizeOf<Uint64>() * max(1, maxChunks));
+        final count =
+            pdfrx_fingerprint_file_chunks(path, 0, hashes, maxChunks, size);
+        if (count < 0) return null;
+        if (count <= maxChunks) {
+          return PdfBlockManifest(
+            size: size.value,
+            blocks: hashes.asTypedList(count).toList(growable: false),
+          );
+        }
+        maxChunks = count;
+      }
+    });
   }
 }
 
@@ -189,6 +341,13 @@ class PdfDocumentPdfium extends PdfDocument {
   final _worker = BackgroundWorker.create();
   final int securityHandlerRevision;
 
+  /// Source of the document content; used by [computeFingerprint].
+  final _PdfDocumentSource? _source;
+
+  /// Text pages prepared by [preparePages] (`pdfrx_page_cache`).
+  final int _pageCache = pdfrx_page_cache_create(_defaultPageCacheBudget);
+  static const _defaultPageCacheBudget = 32 * 1024 * 1024;
+
   @override
   bool get isEncrypted => securityHandlerRevision != 0;
   @override
@@ -200,10 +359,15 @@ class PdfDocumentPdfium extends PdfDocument {
     required this.securityHandlerRevision,
     required this.permissions,
     this.disposeCallback,
-  });
+    _PdfDocumentSource? source,
+  }) : _source = source;
 
-  static Future<PdfDocument> fromPdfDocument(pdfium_bindings.FPDF_DOCUMENT doc,
-      {required String sourceName, void Function()? disposeCallback}) async {
+  static Future<PdfDocument> fromPdfDocument(
+    pdfium_bindings.FPDF_DOCUMENT doc, {
+    required String sourceName,
+    void Function()? disposeCallback,
+    _PdfDocumentSource? source,
+  }) async {
     if (doc.address == 0) {
       throw Exception('Failed to load PDF document');
     }
@@ -247,6 +411,7 @@ class PdfDocumentPdfium extends PdfDocument {
           ? PdfPermissions(result.permissions, result.securityHandlerRevision)
           : null,
       disposeCallback: disposeCallback,
+      source: source,
     );
 
     final pages = <PdfPagePdfium>[];
@@ -274,10 +439,720 @@ class PdfDocumentPdfium extends PdfDocument {
   bool isIdenticalDocumentHandle(Object? other) =>
       other is PdfDocumentPdfium && doc.address == other.doc.address;
 
+  @override
+  Future<Map<int, List<PdfRect>>> getTextSelectionRects(
+    PdfTextSelection selection, {
+    int? firstPageNumber,
+    int? lastPageNumber,
+  }) async {
+    final first = max(selection.firstPageNumber, firstPageNumber ?? 1);
+    final last = min(selection.lastPageNumber, lastPageNumber ?? pages.length);
+    if (first > last) return {};
+    final ranges = [
+      for (int i = first; i <= last; i++) selection.rangeOnPage(i)!,
+    ];
+    final result = await synchronized(
+      () async => (await _worker).compute(
+        (params) => using(
+          (arena) {
+            final pageCount = params.pages.length;
+            final pagesBuf = arena.allocate<pdfium_bindings.FPDF_PAGE>(
+                sizeOf<IntPtr>() * pageCount);
+            final starts = arena.allocate<Int>(sizeOf<Int>() * pageCount);
+            final counts = arena.allocate<Int>(sizeOf<Int>() * pageCount);
+            final rectCounts = arena.allocate<Int>(sizeOf<Int>() * pageCount);
+            for (int i = 0; i < pageCount; i++) {
+              pagesBuf[i] =
+                  pdfium_bindings.FPDF_PAGE.fromAddress(params.pages[i]);
+              starts[i] = params.starts[i];
+              counts[i] = params.counts[i];
+            }
+            // most selections fit in the initial buffer; otherwise retry with the exact size
+            int maxRects = 256;
+            for (;;) {
+              final rects =
+                  arena.allocate<Double>(sizeOf<Double>() * 4 * maxRects);
+              final total = pdfrx_text_selection_rects(params.cache,
+                  pagesBuf, pageCount, starts, counts, rects, maxRects,
+                  rectCounts);
+              if (total <= maxRects) {
+                // copy out of the arena (sublist creates a new typed list)
+                return (
+                  rects: rects.asTypedList(total * 4).sublist(0),
+                  rectCounts:
+                      rectCounts.cast<Int32>().asTypedList(pageCount).sublist(0),
+                );
+              }
+              maxRects = total;
+            }
+          },
+        ),
+        (
+          cache: _pageCache,
+          pages: [
+            for (int i = first; i <= last; i++) pages[i - 1].page.address,
+          ],
+          starts: [for (final r in ranges) r.start],
+          counts: [for (final r in ranges) r.count],
+        ),
+      ),
+    );
+    final rectsByPage = <int, List<PdfRect>>{};
+    int pos = 0;
+    for (int i = 0; i < result.rectCounts.length; i++) {
+      final count = result.rectCounts[i];
+      rectsByPage[first + i] = List.generate(count, (j) {
+        final k = (pos + j) * 4;
+        return PdfRect(result.rects[k], result.rects[k + 1],
+            result.rects[k + 2], result.rects[k + 3]);
+      });
+      pos += count;
+    }
+    return rectsByPage;
+  }
+
+  @override
+  Stream<PdfPageDiff> diffPages(
+    PdfDocument other, {
+    double scale = 1.0,
+    int tileSize = 16,
+    int threshold = 24,
+    bool createOverlay = false,
+  }) async* {
+    if (other is! PdfDocumentPdfium) {
+      throw ArgumentError.value(other, 'other', 'must be a PDFium document');
+    }
+    final signaturesA = await _pageSignatures();
+    final signaturesB = await other._pageSignatures();
+    for (final (a, b) in _matchPages(signaturesA, signaturesB)) {
+      if (a == null || b == null) {
+        yield PdfPageDiff(pageNumberA: a, pageNumberB: b);
+        continue;
+      }
+      yield await _diffPage(other, a, b,
+          scale: scale,
+          tileSize: tileSize,
+          threshold: threshold,
+          createOverlay: createOverlay);
+    }
+  }
+
+  @override
+  Future<Map<int, List<PdfAnnotation>>> loadAllAnnotations() async {
+    final snapshot = await _loadAnnotationsSnapshot(pages);
+    return {
+      for (final (i, annotations) in snapshot.indexed) i + 1: annotations,
+    };
+  }
+
+  /// Load the annotations of [pages] by a single native call; the snapshot is parsed on the calling isolate
+  /// because sending the parsed objects between isolates costs more than parsing them.
+  Future<List<List<PdfAnnotation>>> _loadAnnotationsSnapshot(
+      List<PdfPagePdfium> pages) async {
+    final bytes = await _loadPacked(
+      'pdfrx_annotations_snapshot',
+      [for (final page in pages) page.page.address],
+      (pages, arena, size) => pdfrx_annotations_snapshot(
+          _allocatePages(arena, pages), pages.length, size),
+    );
+    return _AnnotationsSnapshotReader(bytes).read();
+  }
+
+  /// Call [snapshot] on the worker and copy the packed buffer (see [_PackedReader]) it returns to the calling
+  /// isolate; the native buffer is released by `pdfrx_free`. Throws if [snapshot] returns null.
+  ///
+  /// [snapshot] runs on the worker isolate with [params], an arena for the temporary allocations and the pointer
+  /// to receive the size of the buffer; it must not capture anything that cannot be sent to the worker.
+  Future<Uint8List> _loadPacked<T>(
+    String name,
+    T params,
+    Pointer<Uint8> Function(T params, Arena arena, Pointer<Int64> size)
+        snapshot,
+  ) async {
+    final bytes = await synchronized(
+      () async => (await _worker).compute(
+        (params) => using((arena) {
+          final size = arena.allocate<Int64>(sizeOf<Int64>());
+          final buffer = params.snapshot(params.params, arena, size);
+          if (buffer.address == 0) return null;
+          final bytes = buffer.asTypedList(size.value).sublist(0);
+          pdfrx_free(buffer.cast<Void>());
+          return bytes;
+        }),
+        (params: params, snapshot: snapshot),
+      ),
+    );
+    if (bytes == null) {
+      throw Exception('$name failed.');
+    }
+    return bytes;
+  }
+
+  @override
+  Future<List<PdfFormField>> loadFormFields() async {
+    final bytes = await _loadPacked(
+      'pdfrx_form_fields_snapshot',
+      (
+        doc: doc.address,
+        pages: [for (final page in pages) page.page.address],
+      ),
+      (params, arena, size) => pdfrx_form_fields_snapshot(
+          pdfium_bindings.FPDF_DOCUMENT.fromAddress(params.doc),
+          _allocatePages(arena, params.pages),
+          params.pages.length,
+          size),
+    );
+    return _FormFieldsSnapshotReader(bytes).read();
+  }
+
+  @override
+  Future<int> updateFormFields(List<PdfFormFieldUpdate> updates) async {
+    if (updates.isEmpty) return 0;
+    final request = _encodeFormFieldUpdates(updates);
+    final applied = await synchronized(
+      () async => (await _worker).compute(
+        (params) => using((arena) {
+          final (doc, pages, request) = params;
+          final buffer = arena.allocate<Uint8>(request.length);
+          buffer.asTypedList(request.length).setAll(0, request);
+          return pdfrx_form_fields_update(
+              pdfium_bindings.FPDF_DOCUMENT.fromAddress(doc),
+              _allocatePages(arena, pages),
+              pages.length,
+              buffer,
+              request.length);
+        }),
+        (doc.address, [for (final page in pages) page.page.address], request),
+      ),
+    );
+    if (applied < 0) {
+      throw Exception('pdfrx_form_fields_update failed.');
+    }
+    return applied;
+  }
+
+  @override
+  Future<List<PdfAttachment>> loadAttachments() async {
+    final bytes = await _loadPacked(
+      'pdfrx_attachments_snapshot',
+      doc.address,
+      (doc, arena, size) => pdfrx_attachments_snapshot(
+          pdfium_bindings.FPDF_DOCUMENT.fromAddress(doc), size),
+    );
+    // version, count, names (strings)
+    final reader = _PackedReader(bytes)
+      .._checkVersion(1, 'attachments snapshot');
+    return List.generate(
+        reader._i32(), (i) => PdfAttachment(i, reader._string()));
+  }
+
+  @override
+  Future<int> saveAttachment(
+    PdfAttachment attachment,
+    String path, {
+    int chunkSize = 1024 * 1024,
+  }) async {
+    final size = await synchronized(
+      () async => (await _worker).compute(
+        (params) => using((arena) {
+          final (doc, index, path, chunkSize) = params;
+          return pdfrx_attachment_write_file(
+              pdfium_bindings.FPDF_DOCUMENT.fromAddress(doc),
+              index,
+              path.toNativeUtf8(allocator: arena).cast<Char>(),
+              chunkSize);
+        }),
+        (doc.address, attachment.index, path, chunkSize),
+      ),
+    );
+    if (size < 0) {
+      throw Exception(
+          'Failed to save attachment #${attachment.index} to $path.');
+    }
+    return size;
+  }
+
+  @override
+  Future<int> preparePages(
+    List<int> pageNumbers, {
+    bool loadText = true,
+    int maxTextCacheBytes = _defaultPageCacheBudget,
+  }) =>
+      synchronized(
+        () async => (await _worker).compute(
+          (params) => using((arena) {
+            final (cache, pages, loadText, budget) = params;
+            final pagesBuf = arena.allocate<pdfium_bindings.FPDF_PAGE>(
+                sizeOf<IntPtr>() * max(1, pages.length));
+            for (int i = 0; i < pages.length; i++) {
+              pagesBuf[i] = pdfium_bindings.FPDF_PAGE.fromAddress(pages[i]);
+            }
+            return pdfrx_page_cache_prepare(
+                cache, pagesBuf, pages.length, loadText ? 1 : 0, budget);
+          }),
+          (
+            _pageCache,
+            [
+              for (final n in pageNumbers)
+                if (n >= 1 && n <= pages.length) pages[n - 1].page.address,
+            ],
+            loadText,
+            maxTextCacheBytes,
+          ),
+        ),
+      );
+
+  @override
+  Future<PdfDocumentFingerprint> computeFingerprint({
+    bool? sampled,
+    int threadCount = 0,
+  }) async {
+    final source = _source;
+    if (source == null) {
+      throw StateError('The document source is not available.');
+    }
+    sampled ??= source.filePath == null;
+    final fileId = await synchronized(
+      () async => (await _worker).compute(
+        (doc) => using((arena) {
+          final d = pdfium_bindings.FPDF_DOCUMENT.fromAddress(doc);
+          final length = pdfrx_fingerprint_file_identifier(d, nullptr, 0);
+          if (length == 0) return null;
+          final buffer = arena.allocate<Uint8>(length + 1);
+          pdfrx_fingerprint_file_identifier(d, buffer, length + 1);
+          return buffer.asTypedList(length).sublist(0);
+        }),
+        doc.address,
+      ),
+    );
+    // the mode is also hashed so that the fingerprints of the different modes never collide
+    final extra = Uint8List.fromList([sampled ? 1 : 0, ...?fileId]);
+
+    final (int, int)? result;
+    if (source.filePath != null && !sampled) {
+      result = await compute(
+          _fingerprintFile, (source.filePath!, extra, threadCount));
+    } else {
+      final raf = source.filePath != null
+          ? await File(source.filePath!).open()
+          : null;
+      try {
+        final FutureOr<int> Function(Uint8List, int, int) read = raf != null
+            ? (Uint8List buffer, int position, int size) async {
+                await raf.setPosition(position);
+                return await raf.readInto(buffer, 0, size);
+              }
+            : source.read!;
+        final fileSize = raf != null ? await raf.length() : source.fileSize;
+        result = sampled
+            ? await _fingerprintSampled(read, fileSize, extra)
+            : await _fingerprintCustom(read, fileSize, extra, threadCount);
+      } finally {
+        await raf?.close();
+      }
+    }
+    if (result == null) {
+      throw Exception('Failed to compute the fingerprint of $sourceName.');
+    }
+    return PdfDocumentFingerprint(
+      hash: result.$1,
+      fileSize: result.$2,
+      sampled: sampled,
+      fileIdentifier: fileId
+          ?.map((b) => b.toRadixString(16).padLeft(2, '0'))
+          .join(),
+    );
+  }
+
+  static (int, int)? _fingerprintFile((String, Uint8List, int) params) {
+    final (path, extra, threadCount) = params;
+    return using((arena) {
+      final extraBuf = arena.allocate<Uint8>(extra.length);
+      extraBuf.asTypedList(extra.length).setAll(0, extra);
+      final hash = arena.allocate<Uint64>(sizeOf<Uint64>());
+      final size = arena.allocate<Int64>(sizeOf<Int64>());
+      if (pdfrx_fingerprint_file(path.toUtf8(arena), threadCount, extraBuf,
+              extra.length, hash, size) !=
+          0) {
+        return null;
+      }
+      return (hash.value, size.value);
+    });
+  }
+
+  static void _hashChunks((int, int, int, int, int) params) {
+    final (data, size, firstChunkIndex, threadCount, chunkHashes) = params;
+    pdfrx_fingerprint_hash_chunks(Pointer.fromAddress(data), size,
+        firstChunkIndex, threadCount, Pointer.fromAddress(chunkHashes));
+  }
+
+  static int _combineFingerprint(Pointer<Uint64> chunkHashes, int chunkCount,
+      int fileSize, Uint8List extra) {
+    return using((arena) {
+      final extraBuf = arena.allocate<Uint8>(extra.length);
+      extraBuf.asTypedList(extra.length).setAll(0, extra);
+      return pdfrx_fingerprint_combine(
+          chunkHashes, chunkCount, fileSize, extraBuf, extra.length);
+    });
+  }
+
+  /// Hash the whole content read by [read]; it is read into a native buffer window by window and each window is
+  /// hashed on another isolate, so the result is the same as the one of `pdfrx_fingerprint_file`.
+  static Future<(int, int)> _fingerprintCustom(
+    FutureOr<int> Function(Uint8List buffer, int position, int size) read,
+    int fileSize,
+    Uint8List extra,
+    int threadCount,
+  ) async {
+    const window = 16 * _fingerprintChunkSize;
+    final chunkCount =
+        (fileSize + _fingerprintChunkSize - 1) ~/ _fingerprintChunkSize;
+    final chunkHashes = calloc.allocate<Uint64>(
+        sizeOf<Uint64>() * max(1, chunkCount));
+    final buffer = calloc.allocate<Uint8>(max(1, min(window, fileSize)));
+    try {
+      for (int pos = 0; pos < fileSize; pos += window) {
+        final size = min(window, fileSize - pos);
+        await _readFully(read, buffer.asTypedList(size), pos);
+        final firstChunkIndex = pos ~/ _fingerprintChunkSize;
+        await compute(_hashChunks, (
+          buffer.address,
+          size,
+          firstChunkIndex,
+          threadCount,
+          chunkHashes.address + firstChunkIndex * sizeOf<Uint64>(),
+        ));
+      }
+      return (
+        _combineFingerprint(chunkHashes, chunkCount, fileSize, extra),
+        fileSize
+      );
+    } finally {
+      calloc.free(buffer);
+      calloc.free(chunkHashes);
+    }
+  }
+
+  /// Hash the file size, the head, the tail and the cross reference section (pointed by `startxref`) of the file.
+  static Future<(int, int)> _fingerprintSampled(
+    FutureOr<int> Function(Uint8List buffer, int position, int size) read,
+    int fileSize,
+    Uint8List extra,
+  ) async {
+    const blockSize = 64 * 1024;
+    Future<Uint8List> readBlock(int position) async {
+      final block = Uint8List(min(blockSize, fileSize - position));
+      await _readFully(read, block, position);
+      return block;
+    }
+
+    final head = await readBlock(0);
+    final tail = await readBlock(max(0, fileSize - blockSize));
+    final xref = _findStartXref(tail);
+    final samples = BytesBuilder(copy: false)
+      ..add(head)
+      ..add(tail);
+    if (xref != null && xref < fileSize) samples.add(await readBlock(xref));
+
+    final bytes = samples.takeBytes();
+    return using((arena) {
+      final data = arena.allocate<Uint8>(max(1, bytes.length));
+      data.asTypedList(bytes.length).setAll(0, bytes);
+      final chunkHashes = arena.allocate<Uint64>(
+          sizeOf<Uint64>() * (bytes.length ~/ _fingerprintChunkSize + 1));
+      final chunkCount = pdfrx_fingerprint_hash_chunks(
+          data, bytes.length, 0, 1, chunkHashes);
+      return (
+        _combineFingerprint(chunkHashes, chunkCount, fileSize, extra),
+        fileSize
+      );
+    });
+  }
+
+  /// Parse the offset after the last `startxref` keyword in [tail].
+  static int? _findStartXref(Uint8List tail) {
+    const keyword = 'startxref';
+    final text = String.fromCharCodes(tail);
+    final index = text.lastIndexOf(keyword);
+    if (index < 0) return null;
+    final match =
+        RegExp(r'\s*(\d+)').matchAsPrefix(text, index + keyword.length);
+    return match != null ? int.tryParse(match.group(1)!) : null;
+  }
+
+  static Future<void> _readFully(
+    FutureOr<int> Function(Uint8List buffer, int position, int size) read,
+    Uint8List buffer,
+    int position,
+  ) async {
+    for (int done = 0; done < buffer.length;) {
+      final n = await read(Uint8List.sublistView(buffer, done),
+          position + done, buffer.length - done);
+      if (n <= 0) {
+        throw Exception('Failed to read the document at ${position + done}.');
+      }
+      done += n;
+    }
+  }
+
+  /// Encode the updates in the format read by `pdfrx_form_fields_update` (src/pdfrx_forms.cpp):
+  ///
+  /// ```
+  /// version, updateCount
+  /// for each update: kind, intValue, widgetIndex (-1 for all), name, text (strings)
+  /// string: length (UTF-16 code units), code units padded to 4 bytes
+  /// ```
+  static Uint8List _encodeFormFieldUpdates(List<PdfFormFieldUpdate> updates) {
+    int stringSize(String s) => 4 + ((s.length * 2 + 3) & ~3);
+    int size = 8;
+    for (final u in updates) {
+      size += 12 + stringSize(u.name) + stringSize(u.text ?? '');
+    }
+    final data = ByteData(size);
+    int pos = 0;
+    void i32(int v) {
+      data.setInt32(pos, v, Endian.host);
+      pos += 4;
+    }
+
+    void string(String s) {
+      i32(s.length);
+      for (int i = 0; i < s.length; i++) {
+        data.setUint16(pos + i * 2, s.codeUnitAt(i), Endian.host);
+      }
+      pos += (s.length * 2 + 3) & ~3;
+    }
+
+    i32(1);
+    i32(updates.length);
+    for (final u in updates) {
+      i32(u.kind);
+      i32(u.intValue);
+      i32(u.widgetIndex ?? -1);
+      string(u.name);
+      string(u.text ?? '');
+    }
+    return data.buffer.asUint8List();
+  }
+
+  Future<List<int>> _pageSignatures() => synchronized(
+        () async => (await _worker).compute(
+          (pages) => [
+            for (final page in pages)
+              pdfrx_page_signature(
+                  pdfium_bindings.FPDF_PAGE.fromAddress(page)),
+          ],
+          [for (final page in pages) page.page.address],
+        ),
+      );
+
+  /// Match the pages by the longest common subsequence of the signatures; the unmatched pages between two
+  /// matched pages are paired in order (modified pages) and the rest are deleted/inserted ones.
+  static List<(int?, int?)> _matchPages(List<int> a, List<int> b) {
+    final n = a.length, m = b.length;
+    // lcs[i * (m + 1) + j] = LCS length of a[i..] and b[j..]
+    final lcs = List<int>.filled((n + 1) * (m + 1), 0);
+    for (int i = n - 1; i >= 0; i--) {
+      for (int j = m - 1; j >= 0; j--) {
+        lcs[i * (m + 1) + j] = a[i] == b[j]
+            ? lcs[(i + 1) * (m + 1) + j + 1] + 1
+            : max(lcs[(i + 1) * (m + 1) + j], lcs[i * (m + 1) + j + 1]);
+      }
+    }
+    final result = <(int?, int?)>[];
+    final gapA = <int>[], gapB = <int>[];
+    void flushGap() {
+      final paired = min(gapA.length, gapB.length);
+      for (int k = 0; k < paired; k++) {
+        result.add((gapA[k], gapB[k]));
+      }
+      for (int k = paired; k < gapA.length; k++) {
+        result.add((gapA[k], null));
+      }
+      for (int k = paired; k < gapB.length; k++) {
+        result.add((null, gapB[k]));
+      }
+      gapA.clear();
+      gapB.clear();
+    }
+
+    int i = 0, j = 0;
+    while (i < n || j < m) {
+      if (i < n && j < m && a[i] == b[j]) {
+        flushGap();
+        result.add((i + 1, j + 1));
+        i++;
+        j++;
+      } else if (j >= m ||
+          (i < n && lcs[(i + 1) * (m + 1) + j] >= lcs[i * (m + 1) + j + 1])) {
+        gapA.add(++i);
+      } else {
+        gapB.add(++j);
+      }
+    }
+    flushGap();
+    return result;
+  }
+
+  Future<PdfPageDiff> _diffPage(
+    PdfDocumentPdfium other,
+    int pageNumberA,
+    int pageNumberB, {
+    required double scale,
+    required int tileSize,
+    required int threshold,
+    required bool createOverlay,
+  }) async {
+    final pageA = pages[pageNumberA - 1];
+    final pageB = other.pages[pageNumberB - 1];
+    final width = (max(pageA.width, pageB.width) * scale).ceil();
+    final height = (max(pageA.height, pageB.height) * scale).ceil();
+    final overlay =
+        createOverlay ? pdfrx_buffer_alloc(width * height * 4) : nullptr;
+    if (createOverlay && overlay.address == 0) {
+      throw Exception('Failed to allocate ${width}x$height overlay.');
+    }
+    try {
+      // both documents are locked (in a consistent order to avoid dead-locks) while their pages are used
+      final (first, second) = identityHashCode(this) <= identityHashCode(other)
+          ? (this, other)
+          : (other, this);
+      Future<T> lockBoth<T>(Future<T> Function() action) =>
+          identical(first, second)
+              ? first.synchronized(action)
+              : first.synchronized(() => second.synchronized(action));
+      final rects = await lockBoth(
+        () async => (await _worker).compute(
+          (params) => using((arena) {
+            final maxRects = ((params.width + params.tileSize - 1) ~/
+                    params.tileSize) *
+                ((params.height + params.tileSize - 1) ~/ params.tileSize);
+            final buffer =
+                arena.allocate<Double>(sizeOf<Double>() * 4 * maxRects);
+            final count = pdfrx_page_diff(
+              pdfium_bindings.FPDF_PAGE.fromAddress(params.pageA),
+              pdfium_bindings.FPDF_PAGE.fromAddress(params.pageB),
+              params.width,
+              params.height,
+              params.scale,
+              params.tileSize,
+              params.threshold,
+              buffer,
+              maxRects,
+              Pointer<Uint8>.fromAddress(params.overlay),
+            );
+            // NOTE: exceptions are not propagated from the worker
+            if (count < 0) return null;
+            return buffer.asTypedList(count * 4).sublist(0);
+          }),
+          (
+            pageA: pageA.page.address,
+            pageB: pageB.page.address,
+            width: width,
+            height: height,
+            scale: scale,
+            tileSize: tileSize,
+            threshold: threshold,
+            overlay: overlay.address,
+          ),
+        ),
+      );
+      if (rects == null) {
+        throw Exception(
+            'pdfrx_page_diff failed (page $pageNumberA/$pageNumberB).');
+      }
+      return PdfPageDiff(
+        pageNumberA: pageNumberA,
+        pageNumberB: pageNumberB,
+        changedRects: [
+          for (int k = 0; k < rects.length; k += 4)
+            PdfRect(rects[k], rects[k + 1], rects[k + 2], rects[k + 3]),
+        ],
+        overlay: createOverlay
+            ? PdfImagePdfium._(width: width, height: height, buffer: overlay)
+            : null,
+      );
+    } catch (e) {
+      if (overlay.address != 0) pdfrx_buffer_release(overlay.cast());
+      rethrow;
+    }
+  }
+
+  @override
+  Stream<String> streamTextSelection(PdfTextSelection selection) async* {
+    for (int pageNumber = selection.firstPageNumber;
+        pageNumber <= selection.lastPageNumber;
+        pageNumber++) {
+      if (pageNumber > pages.length) break;
+      final range = selection.rangeOnPage(pageNumber)!;
+      final text = await synchronized(
+        () async => (await _worker).compute(
+          (params) => using(
+            (arena) {
+              final page = pdfium_bindings.FPDF_PAGE.fromAddress(params.page);
+              final length = pdfrx_text_get_range(
+                  params.cache, page, params.start, params.count, nullptr, 0);
+              if (length <= 0) return '';
+              final buffer = arena.allocate<Uint16>(
+                  sizeOf<Uint16>() * (length + 1));
+              final copied = pdfrx_text_get_range(params.cache, page,
+                  params.start, params.count, buffer, length + 1);
+              return String.fromCharCodes(buffer.asTypedList(copied));
+            },
+          ),
+          (
+            cache: _pageCache,
+            page: pages[pageNumber - 1].page.address,
+            start: range.start,
+            count: range.count,
+          ),
+        ),
+      );
+      if (pageNumber != selection.firstPageNumber) yield '\r\n';
+      yield text;
+    }
+  }
+
+  /// Run [render] on the worker with the document locked.
+  ///
+  /// The result is delivered by a [NativeCallable.listener] that the worker calls as soon as [render] returns,
+  /// rather than by a reply message to a new `ReceivePort` as [BackgroundWorker.compute] does, so a render costs a
+  /// single message each way.
+  Future<_RenderResult> _renderOnWorker<T>(
+    T params,
+    _RenderResult Function(T params) render,
+  ) =>
+      synchronized(() async {
+        final worker = await _worker;
+        final completer = Completer<_RenderResult>();
+        late final _RenderDoneCallable done;
+        done = _RenderDoneCallable.listener(
+          (bool ok, int value, int width, int height, int degradation) {
+            done.close();
+            if (ok) {
+              completer.complete((
+                value: value,
+                width: width,
+                height: height,
+                degradation: degradation,
+              ));
+            } else {
+              completer.completeError(Exception('Rendering failed.'));
+            }
+          },
+        );
+        worker.post(
+          _renderAndNotify<T>,
+          (params: params, render: render, done: done.nativeFunction.address),
+        );
+        return completer.future;
+      });
+
   @override
   Future<void> dispose() async {
     (await _worker).dispose();
     await synchronized(() {
+      pdfrx_page_cache_destroy(_pageCache);
       for (final page in pages) {
         pdfium.FPDF_ClosePage(page.page);
       }
@@ -306,6 +1181,12 @@ class PdfPagePdfium extends PdfPage {
     required this.page,
   });
 
+  final _degradations = <PdfRenderDegradation>{};
+
+  @override
+  Set<PdfRenderDegradation> get degradations =>
+      Set.unmodifiable(_degradations);
+
   @override
   Future<PdfImage> render({
     int x = 0,
@@ -316,77 +1197,945 @@ class PdfPagePdfium extends PdfPage {
     double? fullHeight,
     Color? backgroundColor,
     bool enableAnnotations = true,
+    PdfRenderLimits? limits,
   }) async {
     fullWidth ??= this.width;
     fullHeight ??= this.height;
     width ??= fullWidth.toInt();
     height ??= fullHeight.toInt();
     backgroundColor ??= Colors.white;
+    if (limits != null) {
+      return _renderLimited(_jobParams(
+        x: x,
+        y: y,
+        width: width,
+        height: height,
+        fullWidth: fullWidth,
+        fullHeight: fullHeight,
+        backgroundColor: backgroundColor,
+        enableAnnotations: enableAnnotations,
+        limits: limits,
+        timeSliceMs: 0,
+      ));
+    }
     const rgbaSize = 4;
-    final buffer = malloc.allocate<Uint8>(width * height * rgbaSize);
+    final buffer = pdfrx_buffer_alloc(width * height * rgbaSize);
+    if (buffer.address == 0) {
+      throw Exception('Failed to allocate ${width}x$height image.');
+    }
+    final result = await _renderTo(
+      buffer.address,
+      width * height * rgbaSize,
+      width: width,
+      height: height,
+      stride: width * rgbaSize,
+      format: PdfBitmapFormat.bgra,
+      x: x,
+      y: y,
+      fullWidth: fullWidth,
+      fullHeight: fullHeight,
+      backgroundColor: backgroundColor,
+      enableAnnotations: enableAnnotations,
+    );
+    if (result != 0) {
+      pdfrx_buffer_release(buffer.cast());
+      throw Exception('Rendering page $pageNumber failed ($result).');
+    }
 
-    await document.synchronized(
-      () async {
-        await (await document._worker).compute(
-          (params) {
-            final bmp = pdfium.FPDFBitmap_CreateEx(
-              params.width,
-              params.height,
-              pdfium_bindings.FPDFBitmap_BGRA,
-              Pointer.fromAddress(params.buffer),
-              params.width * rgbaSize,
-            );
-            if (bmp.address == 0) {
-              throw Exception(
-                  'FPDFBitmap_CreateEx(${params.width}, ${params.height}) failed.');
-            }
-            pdfium.FPDFBitmap_FillRect(
-              bmp,
-              0,
-              0,
-              params.width,
-              params.height,
-              params.backgroundColor,
-            );
-            pdfium.FPDF_RenderPageBitmap(
-              bmp,
-              pdfium_bindings.FPDF_PAGE.fromAddress(params.page),
-              -params.x,
-              -params.y,
-              params.fullWidth,
-              params.fullHeight,
-              0,
-              params.enableAnnotation ? pdfium_bindings.FPDF_ANNOT : 0,
-            );
-            pdfium.FPDFBitmap_Destroy(bmp);
-          },
-          (
-            page: page.address,
-            buffer: buffer.address,
-            x: x,
-            y: y,
-            width: width!,
-            height: height!,
-            fullWidth: fullWidth!.toInt(),
-            fullHeight: fullHeight!.toInt(),
-            backgroundColor: backgroundColor!.value,
-            enableAnnotation: enableAnnotations,
-          ),
-        );
+    return PdfImagePdfium._(
+      width: width,
+      height: height,
+      buffer: buffer,
+    );
+  }
+
+  @override
+  Future<void> renderToBuffer({
+    required int bufferAddress,
+    required int bufferSize,
+    required int width,
+    required int height,
+    int? stride,
+    PdfBitmapFormat format = PdfBitmapFormat.bgra,
+    int x = 0,
+    int y = 0,
+    double? fullWidth,
+    double? fullHeight,
+    Color? backgroundColor,
+    bool enableAnnotations = true,
+  }) async {
+    stride ??= width * format.bytesPerPixel;
+    if (bufferAddress == 0 ||
+        width <= 0 ||
+        height <= 0 ||
+        stride < width * format.bytesPerPixel ||
+        bufferSize < stride * (height - 1) + width * format.bytesPerPixel) {
+      throw ArgumentError(
+          'The buffer ($bufferSize bytes, stride $stride) is not large enough for ${width}x$height ${format.name}.');
+    }
+    final result = await _renderTo(
+      bufferAddress,
+      bufferSize,
+      width: width,
+      height: height,
+      stride: stride,
+      format: format,
+      x: x,
+      y: y,
+      fullWidth: fullWidth ?? this.width,
+      fullHeight: fullHeight ?? this.height,
+      backgroundColor: backgroundColor ?? Colors.white,
+      enableAnnotations: enableAnnotations,
+    );
+    if (result == pdfrxRenderInvalidArgument) {
+      throw ArgumentError('Invalid render target for page $pageNumber.');
+    } else if (result != 0) {
+      throw Exception('Rendering page $pageNumber failed ($result).');
+    }
+  }
+
+  @override
+  Stream<PdfImage> renderProgressive({
+    int x = 0,
+    int y = 0,
+    int? width,
+    int? height,
+    double? fullWidth,
+    double? fullHeight,
+    Color? backgroundColor,
+    bool enableAnnotations = true,
+    PdfRenderLimits? limits,
+    Duration interval = const Duration(milliseconds: 100),
+  }) {
+    fullWidth ??= this.width;
+    fullHeight ??= this.height;
+    final params = _jobParams(
+      x: x,
+      y: y,
+      width: width ?? fullWidth.toInt(),
+      height: height ?? fullHeight.toInt(),
+      fullWidth: fullWidth,
+      fullHeight: fullHeight,
+      backgroundColor: backgroundColor ?? Colors.white,
+      enableAnnotations: enableAnnotations,
+      limits: limits,
+      timeSliceMs: max(1, interval.inMilliseconds),
+    );
+    final controller = StreamController<PdfImage>();
+    controller.onListen = () {
+      // PDFium keeps the progress on the page; the document is locked until the job is closed
+      document
+          .synchronized(() => _renderProgressive(controller, params))
+          .then((_) => controller.close(), onError: (e, s) {
+        controller.addError(e, s);
+        controller.close();
+      });
+    };
+    return controller.stream;
+  }
+
+  _RenderJobParams _jobParams({
+    required int x,
+    required int y,
+    required int width,
+    required int height,
+    required double fullWidth,
+    required double fullHeight,
+    required Color backgroundColor,
+    required bool enableAnnotations,
+    required PdfRenderLimits? limits,
+    required int timeSliceMs,
+  }) =>
+      (
+        page: page.address,
+        width: width,
+        height: height,
+        x: x,
+        y: y,
+        fullWidth: fullWidth.toInt(),
+        fullHeight: fullHeight.toInt(),
+        backgroundColor: backgroundColor.value,
+        flags: enableAnnotations ? pdfium_bindings.FPDF_ANNOT : 0,
+        timeSliceMs: timeSliceMs,
+        maxBitmapBytes: limits?.maxBitmapBytes ?? 0,
+        maxPageObjects: limits?.maxPageObjects ?? 0,
+        timeLimitMs: max(0, limits?.timeLimit?.inMilliseconds ?? 0),
+      );
+
+  /// Render the page in a single job with the limits; the job is aborted at the time limit in the first slice.
+  Future<PdfImage> _renderLimited(_RenderJobParams params) async {
+    final result = await document._renderOnWorker(params, (params) {
+      final job = _startRenderJob(params);
+      if (job == 0) return (value: 0, width: 0, height: 0, degradation: 0);
+      final result = _closeRenderJob(job, take: true);
+      return (
+        value: result.buffer,
+        width: result.width,
+        height: result.height,
+        degradation: result.degradation,
+      );
+    });
+    if (result.value == 0) {
+      throw Exception(
+          'Rendering page $pageNumber failed (${params.width}x${params.height}).');
+    }
+    return _createImage(result.value,
+        width: result.width,
+        height: result.height,
+        degradation: result.degradation);
+  }
+
+  Future<void> _renderProgressive(
+    StreamController<PdfImage> controller,
+    _RenderJobParams params,
+  ) async {
+    final worker = await document._worker;
+    final started = await worker.compute(
+      (params) {
+        final job = _startRenderJob(params);
+        return (job: job, state: job != 0 ? _getRenderJobState(job) : null);
       },
+      params,
     );
+    final job = started.job;
+    final state = started.state;
+    if (state == null) {
+      throw Exception(
+          'Rendering page $pageNumber failed (${params.width}x${params.height}).');
+    }
+
+    // the job (and its buffer) must be closed whatever happens; PDFium keeps the progress on the page until then
+    var closed = false;
+    try {
+      var status = state.status;
+      while (status == pdfrxRenderToBeContinued && controller.hasListener) {
+        final snapshot = await worker.compute(
+          (job) => pdfrx_render_progressive_snapshot(job).address,
+          job,
+        );
+        if (snapshot != 0) {
+          controller.add(_createImage(snapshot,
+              width: state.width,
+              height: state.height,
+              degradation: state.degradation));
+        }
+        status = await worker.compute(
+          (params) => pdfrx_render_progressive_continue(
+              params.job, params.timeSliceMs),
+          (job: job, timeSliceMs: params.timeSliceMs),
+        );
+      }
+      closed = true;
+      final result = await worker.compute(
+        (params) => _closeRenderJob(params.job, take: params.take),
+        (job: job, take: controller.hasListener),
+      );
+      if (result.buffer != 0) {
+        controller.add(_createImage(result.buffer,
+            width: result.width,
+            height: result.height,
+            degradation: result.degradation));
+      } else if (controller.hasListener) {
+        throw Exception(
+            'Rendering page $pageNumber failed (${result.status}).');
+      }
+    } finally {
+      if (!closed) {
+        await worker.compute(
+          (job) => _closeRenderJob(job, take: false).status,
+          job,
+        );
+      }
+    }
+  }
 
+  /// Create the image on the buffer of the job and mark the page degraded if the job exceeded the limits.
+  PdfImagePdfium _createImage(
+    int buffer, {
+    required int width,
+    required int height,
+    required int degradation,
+  }) {
+    final degradations = {
+      for (final d in PdfRenderDegradation.values)
+        if (degradation & (1 << d.index) != 0) d,
+    };
+    _degradations.addAll(degradations);
     return PdfImagePdfium._(
       width: width,
       height: height,
-      buffer: buffer,
+      buffer: Pointer.fromAddress(buffer),
+      degradations: degradations,
     );
   }
 
+  /// Render the page into the buffer by `pdfrx_render_page` and returns its result code.
+  Future<int> _renderTo(
+    int bufferAddress,
+    int bufferSize, {
+    required int width,
+    required int height,
+    required int stride,
+    required PdfBitmapFormat format,
+    required int x,
+    required int y,
+    required double fullWidth,
+    required double fullHeight,
+    required Color backgroundColor,
+    required bool enableAnnotations,
+  }) async {
+    final result = await document._renderOnWorker(
+      (
+        page: page.address,
+        buffer: bufferAddress,
+        bufferSize: bufferSize,
+        width: width,
+        height: height,
+        stride: stride,
+        format: format.pdfiumFormat,
+        x: x,
+        y: y,
+        fullWidth: fullWidth.toInt(),
+        fullHeight: fullHeight.toInt(),
+        backgroundColor: backgroundColor.value,
+        enableAnnotations: enableAnnotations,
+      ),
+      (params) => (
+        value: pdfrx_render_page(
+          pdfium_bindings.FPDF_PAGE.fromAddress(params.page),
+          Pointer.fromAddress(params.buffer),
+          params.bufferSize,
+          params.width,
+          params.height,
+          params.stride,
+          params.format,
+          params.x,
+          params.y,
+          params.fullWidth,
+          params.fullHeight,
+          params.backgroundColor,
+          params.enableAnnotations ? pdfium_bindings.FPDF_ANNOT : 0,
+        ),
+        width: params.width,
+        height: params.height,
+        degradation: 0,
+      ),
+    );
+    return result.value;
+  }
+
   @override
   Future<PdfPageText?> loadText() => PdfPageTextPdfium._loadText(this);
+
+  @override
+  Future<List<PdfAnnotation>> loadAnnotations() async =>
+      (await document._loadAnnotationsSnapshot([this])).first;
+
+  @override
+  Future<PdfPageTextRegion> loadTextInRect(PdfRect rect) async {
+    final bytes = await document._loadPacked(
+      'pdfrx_text_get_region',
+      (
+        cache: document._pageCache,
+        page: page.address,
+        left: rect.left,
+        top: rect.top,
+        right: rect.right,
+        bottom: rect.bottom,
+      ),
+      (params, arena, size) => pdfrx_text_get_region(
+        params.cache,
+        pdfium_bindings.FPDF_PAGE.fromAddress(params.page),
+        params.left,
+        params.top,
+        params.right,
+        params.bottom,
+        size,
+      ),
+    );
+    // version, count, for each char: charIndex, charCode, rect (l, t, r, b)
+    final reader = _PackedReader(bytes).._checkVersion(1, 'text region');
+    final count = reader._i32();
+    final charCodes = List<int>.filled(count, 0);
+    final charIndices = List<int>.filled(count, 0);
+    final charRects = <PdfRect>[];
+    for (int i = 0; i < count; i++) {
+      charIndices[i] = reader._i32();
+      charCodes[i] = reader._i32();
+      charRects.add(PdfRect(
+          reader._f32(), reader._f32(), reader._f32(), reader._f32()));
+    }
+    return PdfPageTextRegion(
+      rect: rect,
+      text: String.fromCharCodes(charCodes),
+      charIndices: charIndices,
+      charRects: charRects,
+    );
+  }
+
+  @override
+  Future<PdfPageDisplayList?> loadDisplayList({
+    bool enableAnnotations = true,
+    int maxBytes = 16 * 1024 * 1024,
+  }) async {
+    final bytes = await document._loadPacked(
+      'pdfrx_page_display_list',
+      (
+        cache: document._pageCache,
+        doc: document.doc.address,
+        page: page.address,
+        enableAnnotations: enableAnnotations,
+        maxBytes: maxBytes,
+      ),
+      (params, arena, size) => pdfrx_page_display_list(
+        params.cache,
+        pdfium_bindings.FPDF_DOCUMENT.fromAddress(params.doc),
+        pdfium_bindings.FPDF_PAGE.fromAddress(params.page),
+        params.enableAnnotations ? 1 : 0,
+        params.maxBytes,
+        size,
+      ),
+    );
+    return _DisplayListReader(bytes).read(width: width, height: height);
+  }
+
+  @override
+  Future<List<PdfReflowBlock>> loadReflowBlocks() async {
+    final bytes = await document._loadPacked(
+      'pdfrx_page_reflow',
+      (cache: document._pageCache, page: page.address),
+      (params, arena, size) => pdfrx_page_reflow(
+        params.cache,
+        pdfium_bindings.FPDF_PAGE.fromAddress(params.page),
+        size,
+      ),
+    );
+    return _ReflowBlocksReader(bytes).read();
+  }
+
+  @override
+  Future<int?> getCharIndexAt(double x, double y,
+      {double tolerance = 4}) async {
+    final index = await document.synchronized(
+      () async => (await document._worker).compute(
+        (params) => pdfrx_text_char_index_at(
+          params.cache,
+          pdfium_bindings.FPDF_PAGE.fromAddress(params.page),
+          params.x,
+          params.y,
+          params.tolerance,
+        ),
+        (
+          cache: document._pageCache,
+          page: page.address,
+          x: x,
+          y: y,
+          tolerance: tolerance,
+        ),
+      ),
+    );
+    return index < 0 ? null : index;
+  }
+}
+
+/// Must be same to `PDFRX_FINGERPRINT_CHUNK_SIZE` (src/pdfium_interop.h).
+const _fingerprintChunkSize = 4 * 1024 * 1024;
+
+/// Result of a render on the worker ([PdfDocumentPdfium._renderOnWorker]); [value] is the result code of
+/// `pdfrx_render_page` or the address of the rendered buffer, depending on the render.
+typedef _RenderResult = ({int value, int width, int height, int degradation});
+
+typedef _RenderDoneNative = Void Function(Bool, Int64, Int32, Int32, Int32);
+typedef _RenderDone = void Function(bool, int, int, int, int);
+typedef _RenderDoneCallable = NativeCallable<_RenderDoneNative>;
+
+/// Run the render on the worker and call the listener of [PdfDocumentPdfium._renderOnWorker] with the result.
+void _renderAndNotify<T>(
+    ({T params, _RenderResult Function(T params) render, int done}) message) {
+  final done = Pointer<NativeFunction<_RenderDoneNative>>.fromAddress(
+          message.done)
+      .asFunction<_RenderDone>();
+  try {
+    final result = message.render(message.params);
+    done(true, result.value, result.width, result.height, result.degradation);
+  } catch (e) {
+    done(false, 0, 0, 0, 0);
+  }
+}
+
+typedef _RenderJobParams = ({
+  int page,
+  int width,
+  int height,
+  int x,
+  int y,
+  int fullWidth,
+  int fullHeight,
+  int backgroundColor,
+  int flags,
+  int timeSliceMs,
+  int maxBitmapBytes,
+  int maxPageObjects,
+  int timeLimitMs,
+});
+
+/// Start `pdfrx_render_job` on the worker; returns the address of the job or 0 on failure.
+int _startRenderJob(_RenderJobParams params) => pdfrx_render_progressive_start(
+      pdfium_bindings.FPDF_PAGE.fromAddress(params.page),
+      params.width,
+      params.height,
+      params.x,
+      params.y,
+      params.fullWidth,
+      params.fullHeight,
+      params.backgroundColor,
+      params.flags,
+      params.timeSliceMs,
+      params.maxBitmapBytes,
+      params.maxPageObjects,
+      params.timeLimitMs,
+    );
+
+/// [degradation] is the `PDFRX_RENDER_DEGRADED_*` flags in the order of [PdfRenderDegradation].
+({int status, int width, int height, int degradation}) _getRenderJobState(
+        int job) =>
+    using((arena) {
+      final width = arena<Int>();
+      final height = arena<Int>();
+      final degradation =
+          pdfrx_render_progressive_get_result(job, width, height);
+      return (
+        status: pdfrx_render_progressive_status(job),
+        width: width.value,
+        height: height.value,
+        degradation: degradation,
+      );
+    });
+
+/// Close the job; [buffer] is the pooled buffer of the completed image if [take] is true, otherwise 0.
+({int buffer, int status, int width, int height, int degradation})
+    _closeRenderJob(int job, {required bool take}) {
+  final state = _getRenderJobState(job);
+  final buffer = pdfrx_render_progressive_close(
+          job, take && state.status == pdfrxRenderDone ? 1 : 0)
+      .address;
+  return (
+    buffer: buffer,
+    status: state.status,
+    width: state.width,
+    height: state.height,
+    degradation: state.degradation,
+  );
+}
+
+/// Source of the document content; see [PdfDocumentPdfium.computeFingerprint].
+class _PdfDocumentSource {
+  _PdfDocumentSource.file(String this.filePath)
+      : read = null,
+        fileSize = 0;
+  _PdfDocumentSource.custom(
+      FutureOr<int> Function(Uint8List buffer, int position, int size)
+          this.read,
+      this.fileSize)
+      : filePath = null;
+
+  final String? filePath;
+  final FutureOr<int> Function(Uint8List buffer, int position, int size)? read;
+  final int fileSize;
+}
+
+/// Reads the packed buffers written by `PackedWriter` (src/pdfrx_packed_buffer.h):
+///
+/// ```
+/// i32/f32: 4 bytes in the host byte order
+/// string: length (UTF-16 code units), code units padded to 4 bytes
+/// bytes: raw bytes padded to 4 bytes (the length is known from the context)
+/// ```
+class _PackedReader {
+  _PackedReader(Uint8List bytes) : _data = ByteData.sublistView(bytes);
+
+  final ByteData _data;
+  int _pos = 0;
+
+  int _i32() {
+    final v = _data.getInt32(_pos, Endian.host);
+    _pos += 4;
+    return v;
+  }
+
+  double _f32() {
+    final v = _data.getFloat32(_pos, Endian.host);
+    _pos += 4;
+    return v;
+  }
+
+  String _string() {
+    final length = _i32();
+    final codes = List<int>.generate(
+        length, (i) => _data.getUint16(_pos + i * 2, Endian.host));
+    _pos += (length * 2 + 3) & ~3;
+    return String.fromCharCodes(codes);
+  }
+
+  /// The view of the next [length] bytes.
+  Uint8List _bytes(int length) {
+    final bytes = Uint8List.sublistView(_data, _pos, _pos + length);
+    _pos += (length + 3) & ~3;
+    return bytes;
+  }
+
+  /// Read the version and throw if it is not [version].
+  void _checkVersion(int version, String what) {
+    final v = _i32();
+    if (v != version) {
+      throw Exception('Unsupported $what version: $v');
+    }
+  }
+}
+
+/// Allocate an `FPDF_PAGE` array of [pages] (page addresses) on [arena].
+Pointer<pdfium_bindings.FPDF_PAGE> _allocatePages(
+    Arena arena, List<int> pages) {
+  final buffer = arena
+      .allocate<pdfium_bindings.FPDF_PAGE>(sizeOf<IntPtr>() * pages.length);
+  for (int i = 0; i < pages.length; i++) {
+    buffer[i] = pdfium_bindings.FPDF_PAGE.fromAddress(pages[i]);
+  }
+  return buffer;
 }
 
+/// Parses the snapshot created by `pdfrx_annotations_snapshot` (src/pdfrx_annotations.cpp).
+///
+/// The snapshot consists of 4-byte items in the host byte order:
+///
+/// ```
+/// version, pageCount
+/// for each page: annotCount, annotations...
+/// annotation: subtype (-1 if failed to load; nothing follows), flags, rect (l, t, r, b), color (ARGB),
+///   interiorColor (ARGB), borderWidth, Contents, T, Subj, M, NM (strings), attachment points (count, 8 floats
+///   each), ink paths (count, each has point count and x/y pairs), vertices (count, x/y pairs),
+///   line (1 + 4 floats or 0)
+/// string: length (UTF-16 code units), code units padded to 4 bytes
+/// ```
+class _AnnotationsSnapshotReader extends _PackedReader {
+  _AnnotationsSnapshotReader(super.bytes);
+
+  Color? _color() {
+    final argb = _i32() & 0xffffffff;
+    return argb == 0 ? null : Color(argb);
+  }
+
+  String? _optionalString() {
+    final s = _string();
+    return s.isEmpty ? null : s;
+  }
+
+  Offset _point() => Offset(_f32(), _f32());
+
+  List<Offset> _points(int count) =>
+      List.generate(count, (_) => _point(), growable: false);
+
+  List<List<PdfAnnotation>> read() {
+    _checkVersion(1, 'annotation snapshot');
+    return List.generate(_i32(), (_) {
+      final annotations = <PdfAnnotation>[];
+      final count = _i32();
+      for (int i = 0; i < count; i++) {
+        final subtype = _i32();
+        if (subtype < 0) continue;
+        annotations.add(
+          PdfAnnotation(
+            subtype: subtype < PdfAnnotationSubtype.values.length
+                ? PdfAnnotationSubtype.values[subtype]
+                : PdfAnnotationSubtype.unknown,
+            flags: _i32(),
+            rect: PdfRect(_f32(), _f32(), _f32(), _f32()),
+            color: _color(),
+            interiorColor: _color(),
+            borderWidth: _f32(),
+            contents: _optionalString(),
+            author: _optionalString(),
+            subject: _optionalString(),
+            modificationDate: _optionalString(),
+            name: _optionalString(),
+            attachmentPoints: List.generate(_i32(), (_) => _points(4)),
+            inkPaths: List.generate(_i32(), (_) => _points(_i32())),
+            vertices: _points(_i32()),
+            line: _i32() != 0 ? (_point(), _point()) : null,
+          ),
+        );
+      }
+      return annotations;
+    });
+  }
+}
+
+/// Parses the snapshot created by `pdfrx_form_fields_snapshot` (src/pdfrx_forms.cpp).
+///
+/// The snapshot uses the same encoding as [_AnnotationsSnapshotReader]:
+///
+/// ```
+/// version
+/// for each widget: pageIndex, annotIndex, fieldType, fieldFlags, rect (l, t, r, b),
+///   checked (-1 if not checkable, 0, 1), name, value (strings), optionCount, options...
+/// option: selected (0/1), label (string)
+/// terminated by pageIndex -1
+/// ```
+class _FormFieldsSnapshotReader extends _PackedReader {
+  _FormFieldsSnapshotReader(super.bytes);
+
+  List<PdfFormField> read() {
+    _checkVersion(1, 'form field snapshot');
+    final fields = <PdfFormField>[];
+    for (;;) {
+      final pageIndex = _i32();
+      if (pageIndex < 0) break;
+      final annotationIndex = _i32();
+      final type = _i32();
+      final flags = _i32();
+      final rect = PdfRect(_f32(), _f32(), _f32(), _f32());
+      final checked = _i32();
+      fields.add(
+        PdfFormField(
+          pageNumber: pageIndex + 1,
+          annotationIndex: annotationIndex,
+          type: type >= 0 && type < PdfFormFieldType.values.length
+              ? PdfFormFieldType.values[type]
+              : PdfFormFieldType.unknown,
+          flags: flags,
+          rect: rect,
+          isChecked: checked < 0 ? null : checked != 0,
+          name: _string(),
+          value: _string(),
+          options: List.generate(
+            _i32(),
+            (_) {
+              final selected = _i32() != 0;
+              return PdfFormFieldOption(_string(), selected);
+            },
+          ),
+        ),
+      );
+    }
+    return fields;
+  }
+}
+
+/// Parses the blocks created by `pdfrx_page_reflow` (src/pdfrx_reflow.cpp):
+///
+/// ```
+/// version
+/// for each block: kind (0: paragraph, 1: figure), rect (l, t, r, b)
+///   paragraph: runCount, runs...
+/// run: fontSize (float), fontWeight, flags (1: italic, 2: monospace, 4: serif), text (string)
+/// terminated by kind -1
+/// ```
+class _ReflowBlocksReader extends _PackedReader {
+  _ReflowBlocksReader(super.bytes);
+
+  List<PdfReflowBlock> read() {
+    _checkVersion(1, 'reflow format');
+    final blocks = <PdfReflowBlock>[];
+    for (;;) {
+      final kind = _i32();
+      if (kind < 0) break;
+      final rect = PdfRect(_f32(), _f32(), _f32(), _f32());
+      switch (kind) {
+        case 0:
+          final runCount = _i32();
+          final runs = <PdfReflowRun>[];
+          for (int i = 0; i < runCount; i++) {
+            final fontSize = _f32();
+            final fontWeight = _i32();
+            final flags = _i32();
+            runs.add(PdfReflowRun(
+              text: _string(),
+              fontSize: fontSize,
+              fontWeight: fontWeight,
+              isItalic: flags & 1 != 0,
+              isMonospace: flags & 2 != 0,
+              isSerif: flags & 4 != 0,
+            ));
+          }
+          blocks.add(PdfReflowParagraph(rect, runs));
+        case 1:
+          blocks.add(PdfReflowFigure(rect));
+        default:
+          throw Exception('Unknown reflow block: $kind');
+      }
+    }
+    return blocks;
+  }
+}
+
+/// Replays the display list created by `pdfrx_page_display_list` (src/pdfrx_display_list.cpp) into a [ui.Picture].
+///
+/// ```
+/// version, flags (the list is empty if not 0), page matrix (a, b, c, d, e, f)
+/// operations terminated by -1:
+///   0: save, 1: restore
+///   2: clip: matrix, path
+///   3: path: matrix, fillMode (0: none, 1: even-odd, 2: non-zero), stroke (0/1), fillColor, strokeColor (ARGB),
+///      strokeWidth, lineCap, lineJoin, path
+///   4: glyph definition: glyphId, path (at font size 1)
+///   5: glyph: glyphId, matrix, fillColor
+///   6: image: matrix, width, height, RGBA pixels mapped to the unit square
+/// path: segmentCount, for each segment: type (0: line, 1: bezier, 2: move) | (close << 8), x, y
+/// ```
+class _DisplayListReader extends _PackedReader {
+  _DisplayListReader(super.bytes);
+
+  static const _caps = [StrokeCap.butt, StrokeCap.round, StrokeCap.square];
+  static const _joins = [StrokeJoin.miter, StrokeJoin.round, StrokeJoin.bevel];
+
+  Color _color() => Color(_i32() & 0xffffffff);
+
+  Float64List _matrix() {
+    final (a, b, c, d) = (_f32(), _f32(), _f32(), _f32());
+    final (e, f) = (_f32(), _f32());
+    return Float64List.fromList(
+        [a, b, 0, 0, c, d, 0, 0, 0, 0, 1, 0, e, f, 0, 1]);
+  }
+
+  ui.Path _path({ui.PathFillType fillType = ui.PathFillType.nonZero}) {
+    final path = ui.Path()..fillType = fillType;
+    final count = _i32();
+    final controlPoints = <double>[];
+    for (int i = 0; i < count; i++) {
+      final type = _i32();
+      final x = _f32();
+      final y = _f32();
+      switch (type & 0xff) {
+        case 0:
+          path.lineTo(x, y);
+        case 1:
+          // a cubic bezier is three consecutive segments
+          controlPoints.addAll([x, y]);
+          if (controlPoints.length == 6) {
+            path.cubicTo(controlPoints[0], controlPoints[1], controlPoints[2],
+                controlPoints[3], x, y);
+            controlPoints.clear();
+          }
+        case 2:
+          path.moveTo(x, y);
+      }
+      if (type & 0x100 != 0) path.close();
+    }
+    return path;
+  }
+
+  Future<PdfPageDisplayList?> read({
+    required double width,
+    required double height,
+  }) async {
+    _checkVersion(1, 'display list');
+    if (_i32() != 0) return null;
+    final pageMatrix = _matrix();
+
+    // images are decoded asynchronously, so the operations are recorded after reading all of them
+    final ops = <void Function(Canvas canvas)>[];
+    final glyphs = <int, ui.Path>{};
+    final images = <ui.Image>[];
+    try {
+      for (var op = _i32(); op != -1; op = _i32()) {
+        switch (op) {
+          case 0:
+            ops.add((canvas) => canvas.save());
+          case 1:
+            ops.add((canvas) => canvas.restore());
+          case 2:
+            final m = _matrix();
+            final path = _path().transform(m);
+            ops.add((canvas) => canvas.clipPath(path));
+          case 3:
+            final m = _matrix();
+            final fillMode = _i32();
+            final stroke = _i32() != 0;
+            final fill = Paint()..color = _color();
+            final strokePaint = Paint()
+              ..style = PaintingStyle.stroke
+              ..color = _color()
+              ..strokeWidth = _f32()
+              ..strokeCap = _caps.elementAtOrNull(_i32()) ?? StrokeCap.butt
+              ..strokeJoin =
+                  _joins.elementAtOrNull(_i32()) ?? StrokeJoin.miter
+              ..strokeMiterLimit = 10; // the PDF default
+            final path = _path(
+                fillType: fillMode == 1
+                    ? ui.PathFillType.evenOdd
+                    : ui.PathFillType.nonZero);
+            ops.add((canvas) {
+              canvas.save();
+              canvas.transform(m);
+              if (fillMode != 0) canvas.drawPath(path, fill);
+              if (stroke) canvas.drawPath(path, strokePaint);
+              canvas.restore();
+            });
+          case 4:
+            final id = _i32();
+            glyphs[id] = _path();
+          case 5:
+            final path = glyphs[_i32()]!;
+            final m = _matrix();
+            final paint = Paint()..color = _color();
+            ops.add((canvas) {
+              canvas.save();
+              canvas.transform(m);
+              canvas.drawPath(path, paint);
+              canvas.restore();
+            });
+          case 6:
+            final m = _matrix();
+            final w = _i32();
+            final h = _i32();
+            final pixels = _bytes(w * h * 4);
+            final comp = Completer<ui.Image>();
+            ui.decodeImageFromPixels(pixels, w, h, ui.PixelFormat.rgba8888,
+                (image) => comp.complete(image));
+            final image = await comp.future;
+            images.add(image);
+            // the first row of the image is at the top of the unit square
+            final toUnitSquare = Float64List.fromList(
+                [1 / w, 0, 0, 0, 0, -1 / h, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1]);
+            final paint = Paint()..filterQuality = FilterQuality.medium;
+            ops.add((canvas) {
+              canvas.save();
+              canvas.transform(m);
+              canvas.transform(toUnitSquare);
+              canvas.drawImage(image, Offset.zero, paint);
+              canvas.restore();
+            });
+          default:
+            throw Exception('Unknown display list operation: $op');
+        }
+      }
+
+      final recorder = ui.PictureRecorder();
+      final canvas = Canvas(recorder);
+      canvas.transform(pageMatrix);
+      for (final op in ops) {
+        op(canvas);
+      }
+      return PdfPageDisplayList(
+        picture: recorder.endRecording(),
+        width: width,
+        height: height,
+        byteSize: _data.lengthInBytes,
+      );
+    } finally {
+      // the picture holds its own references to the images
+      for (final image in images) {
+        image.dispose();
+      }
+    }
+  }
+}
+
+/// Image on a pooled native buffer (`pdfrx_buffer_alloc`).
+///
+/// The image and its [pixels] hold their own references to the buffer, which are released by [dispose] or the
+/// native finalizers when they are garbage collected; the buffer returns to the pool when both are gone, so
+/// [pixels] never refers to a freed buffer.
 class PdfImagePdfium extends PdfImage {
   @override
   final int width;
@@ -395,19 +2144,43 @@ class PdfImagePdfium extends PdfImage {
   @override
   ui.PixelFormat get format => ui.PixelFormat.bgra8888;
   @override
-  Uint8List get pixels => _buffer.asTypedList(width * height * 4);
+  Uint8List get pixels {
+    if (_disposed) throw StateError('The image is already disposed.');
+    return _pixels ??= _createPixels();
+  }
+
+  @override
+  final Set<PdfRenderDegradation> degradations;
 
   final Pointer<Uint8> _buffer;
+  Uint8List? _pixels;
+  bool _disposed = false;
+
+  static final _finalizer = NativeFinalizer(pdfrx_buffer_release_ptr);
 
   PdfImagePdfium._({
     required this.width,
     required this.height,
     required Pointer<Uint8> buffer,
-  }) : _buffer = buffer;
+    this.degradations = const {},
+  }) : _buffer = buffer {
+    _finalizer.attach(this, buffer.cast(),
+        detach: this, externalSize: width * height * 4);
+  }
+
+  Uint8List _createPixels() {
+    pdfrx_buffer_retain(_buffer.cast());
+    return _buffer.asTypedList(width * height * 4,
+        finalizer: pdfrx_buffer_release_ptr, token: _buffer.cast());
+  }
 
   @override
   void dispose() {
-    calloc.free(_buffer);
+    if (_disposed) return;
+    _disposed = true;
+    _pixels = null;
+    _finalizer.detach(this);
+    pdfrx_buffer_release(_buffer.cast());
   }
 }
 
@@ -474,8 +2247,10 @@ class PdfPageTextPdfium extends PdfPageText {
             () async => (await page.document._worker).compute(
               (params) => using(
                 (arena) {
-                  final textPage = pdfium.FPDFText_LoadPage(
-                      pdfium_bindings.FPDF_PAGE.fromAddress(params.page));
+                  final page =
+                      pdfium_bindings.FPDF_PAGE.fromAddress(params.page);
+                  final textPage =
+                      pdfrx_page_cache_acquire_text(params.cache, page);
                   try {
                     final charCount = pdfium.FPDFText_CountChars(textPage);
                     final charRects = <PdfRect>[];
@@ -488,11 +2263,11 @@ class PdfPageTextPdfium extends PdfPageText {
                       fragments: fragments
                     );
                   } finally {
-                    pdfium.FPDFText_ClosePage(textPage);
+                    pdfrx_page_cache_release_text(params.cache, page, textPage);
                   }
                 },
               ),
-              (page: page.page.address),
+              (cache: page.document._pageCache, page: page.page.address),
             ),
           );
 
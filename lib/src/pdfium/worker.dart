@@ -40,6 +40,12 @@ class BackgroundWorker {
     return await sendPort.first as R;
   }
 
+  /// Run [callback] on the worker without sending the result back; [callback] should report its completion by
+  /// itself (e.g. by calling a `NativeCallable.listener`) and must not throw.
+  void post<M>(void Function(M message) callback, M message) {
+    _sendPort.send(_ComputeParams<M, void>(null, callback, message));
+  }
+
   Future<void> dispose() async {
     _sendPort.send(null);
     _receivePort.close();
@@ -48,9 +54,12 @@ class BackgroundWorker {
 
 class _ComputeParams<M, R> {
   _ComputeParams(this.sendPort, this.callback, this.message);
-  final SendPort sendPort;
+  final SendPort? sendPort;
   final ComputeCallback<M, R> callback;
   final M message;
 
-  void execute() => sendPort.send(callback(message));
+  void execute() {
+    final result = callback(message);
+    sendPort?.send(result);
+  }
 }
@@ -32,17 +32,39 @@ class PdfDocumentFactoryImpl extends PdfDocumentFactory {
     String? password,
     int? maxSizeToCacheOnMemory,
     void Function()? onDispose,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
   }) async {
-    final buffer = Uint8List(fileSize);
-    await read(buffer, 0, fileSize);
-    return await PdfDocumentWeb.fromDocument(
-      await pdfjsGetDocumentFromData(
-        buffer.buffer,
-        password: password,
-      ),
-      sourceName: sourceName,
-      onDispose: onDispose,
-    );
+    final token = PdfCancellationToken.withTimeout(cancellationToken, timeout);
+    try {
+      token?.throwIfCanceled();
+      final buffer = Uint8List(fileSize);
+      await read(buffer, 0, fileSize);
+      token?.throwIfCanceled();
+      return await _disposeIfCanceled(
+        await PdfDocumentWeb.fromDocument(
+          await pdfjsGetDocumentFromData(
+            buffer.buffer,
+            password: password,
+          ),
+          sourceName: sourceName,
+          onDispose: onDispose,
+        ),
+        token,
+      );
+    } finally {
+      token?.complete();
+    }
+  }
+
+  /// pdf.js loading cannot be aborted from here; the document is discarded if the loading is canceled meanwhile.
+  static Future<PdfDocument> _disposeIfCanceled(
+      PdfDocument doc, PdfCancellationToken? token) async {
+    if (token?.isCanceled == true) {
+      await doc.dispose();
+      token!.throwIfCanceled();
+    }
+    return doc;
   }
 
   @override
@@ -77,11 +99,39 @@ class PdfDocumentFactoryImpl extends PdfDocumentFactory {
   Future<PdfDocument> openUri(
     Uri uri, {
     String? password,
-  }) =>
-      openFile(
-        uri.path,
-        password: password,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
+  }) async {
+    final token = PdfCancellationToken.withTimeout(cancellationToken, timeout);
+    try {
+      token?.throwIfCanceled();
+      return await _disposeIfCanceled(
+        await openFile(
+          uri.path,
+          password: password,
+        ),
+        token,
       );
+    } finally {
+      token?.complete();
+    }
+  }
+
+  @override
+  Future<PdfDocument> openUriSynced(
+    Uri uri, {
+    required String filePath,
+    Uri? manifestUri,
+    String? password,
+    void Function(PdfSyncResult result)? onSynced,
+    PdfCancellationToken? cancellationToken,
+    Duration? timeout,
+  }) =>
+      Future.error(UnsupportedError('openUriSynced is not supported on Web.'));
+
+  @override
+  Future<PdfBlockManifest> createBlockManifest(String filePath) => Future.error(
+      UnsupportedError('createBlockManifest is not supported on Web.'));
 }
 
 class PdfDocumentWeb extends PdfDocument {
@@ -152,6 +202,114 @@ class PdfDocumentWeb extends PdfDocument {
   @override
   bool isIdenticalDocumentHandle(Object? other) =>
       other is PdfDocumentWeb && _document == other._document;
+
+  // NOTE: pdf.js does not provide per-character boxes; on Web, character indices are the ones on
+  // PdfPageText.fullText and the character positions are interpolated inside the text items.
+
+  @override
+  Future<Map<int, List<PdfRect>>> getTextSelectionRects(
+    PdfTextSelection selection, {
+    int? firstPageNumber,
+    int? lastPageNumber,
+  }) async {
+    final result = <int, List<PdfRect>>{};
+    for (int i = selection.firstPageNumber; i <= selection.lastPageNumber; i++) {
+      if (i < (firstPageNumber ?? 1) || i > (lastPageNumber ?? pages.length)) {
+        continue;
+      }
+      final text = await pages[i - 1].loadText();
+      final range = selection.rangeOnPage(i)!;
+      final end = range.count < 0
+          ? text!.fullText.length
+          : range.start + range.count;
+      final rects = <PdfRect>[];
+      for (final f in text!.fragments) {
+        final from = f.index < range.start ? range.start : f.index;
+        final to =
+            f.index + f.text.length > end ? end : f.index + f.text.length;
+        if (from >= to) continue;
+        final cw = f.bounds.width / f.text.length;
+        final r = PdfRect(
+          f.bounds.left + cw * (from - f.index),
+          f.bounds.top,
+          f.bounds.left + cw * (to - f.index),
+          f.bounds.bottom,
+        );
+        if (rects.isNotEmpty &&
+            rects.last.top == r.top &&
+            rects.last.bottom == r.bottom) {
+          rects.last = rects.last.merge(r);
+        } else {
+          rects.add(r);
+        }
+      }
+      result[i] = rects;
+    }
+    return result;
+  }
+
+  @override
+  Future<Map<int, List<PdfAnnotation>>> loadAllAnnotations() =>
+      Future.error(UnsupportedError('Annotations are not supported on Web.'));
+
+  @override
+  Future<List<PdfFormField>> loadFormFields() =>
+      Future.error(UnsupportedError('Form fields are not supported on Web.'));
+
+  @override
+  Future<int> updateFormFields(List<PdfFormFieldUpdate> updates) =>
+      Future.error(UnsupportedError('Form fields are not supported on Web.'));
+
+  @override
+  Future<List<PdfAttachment>> loadAttachments() =>
+      Future.error(UnsupportedError('Attachments are not supported on Web.'));
+
+  @override
+  Future<int> saveAttachment(
+    PdfAttachment attachment,
+    String path, {
+    int chunkSize = 1024 * 1024,
+  }) =>
+      Future.error(UnsupportedError('Attachments are not supported on Web.'));
+
+  @override
+  Future<int> preparePages(
+    List<int> pageNumbers, {
+    bool loadText = true,
+    int maxTextCacheBytes = 32 * 1024 * 1024,
+  }) =>
+      Future.value(0);
+
+  @override
+  Future<PdfDocumentFingerprint> computeFingerprint({
+    bool? sampled,
+    int threadCount = 0,
+  }) =>
+      Future.error(UnsupportedError('Fingerprint is not supported on Web.'));
+
+  @override
+  Stream<PdfPageDiff> diffPages(
+    PdfDocument other, {
+    double scale = 1.0,
+    int tileSize = 16,
+    int threshold = 24,
+    bool createOverlay = false,
+  }) =>
+      Stream.error(UnsupportedError('diffPages is not supported on Web.'));
+
+  @override
+  Stream<String> streamTextSelection(PdfTextSelection selection) async* {
+    for (int i = selection.firstPageNumber; i <= selection.lastPageNumber; i++) {
+      final text = (await pages[i - 1].loadText())!.fullText;
+      final range = selection.rangeOnPage(i)!;
+      final start = range.start.clamp(0, text.length);
+      final end = range.count < 0
+          ? text.length
+          : (range.start + range.count).clamp(start, text.length);
+      if (i != selection.firstPageNumber) yield '\r\n';
+      yield text.substring(start, end);
+    }
+  }
 }
 
 class PdfPageWeb extends PdfPage {
@@ -182,6 +340,7 @@ class PdfPageWeb extends PdfPage {
     double? fullHeight,
     Color? backgroundColor,
     bool enableAnnotations = true,
+    PdfRenderLimits? limits,
   }) async {
     fullWidth ??= this.width;
     fullHeight ??= this.height;
@@ -257,8 +416,116 @@ class PdfPageWeb extends PdfPage {
     return src;
   }
 
+  @override
+  Future<void> renderToBuffer({
+    required int bufferAddress,
+    required int bufferSize,
+    required int width,
+    required int height,
+    int? stride,
+    PdfBitmapFormat format = PdfBitmapFormat.bgra,
+    int x = 0,
+    int y = 0,
+    double? fullWidth,
+    double? fullHeight,
+    Color? backgroundColor,
+    bool enableAnnotations = true,
+  }) =>
+      Future.error(
+          UnsupportedError('Rendering to native buffers is not supported on Web.'));
+
+  @override
+  Stream<PdfImage> renderProgressive({
+    int x = 0,
+    int y = 0,
+    int? width,
+    int? height,
+    double? fullWidth,
+    double? fullHeight,
+    Color? backgroundColor,
+    bool enableAnnotations = true,
+    PdfRenderLimits? limits,
+    Duration interval = const Duration(milliseconds: 100),
+  }) =>
+      Stream.fromFuture(render(
+        x: x,
+        y: y,
+        width: width,
+        height: height,
+        fullWidth: fullWidth,
+        fullHeight: fullHeight,
+        backgroundColor: backgroundColor,
+        enableAnnotations: enableAnnotations,
+      ));
+
   @override
   Future<PdfPageText?> loadText() => PdfPageTextWeb._loadText(this);
+
+  @override
+  Future<List<PdfAnnotation>> loadAnnotations() =>
+      Future.error(UnsupportedError('Annotations are not supported on Web.'));
+
+  @override
+  Future<PdfPageDisplayList?> loadDisplayList({
+    bool enableAnnotations = true,
+    int maxBytes = 16 * 1024 * 1024,
+  }) =>
+      Future.value(null);
+
+  @override
+  Future<List<PdfReflowBlock>> loadReflowBlocks() => Future.error(
+      UnsupportedError('loadReflowBlocks is not supported on Web.'));
+
+  /// pdf.js has no character boxes; they are estimated by dividing the fragments evenly as [getCharIndexAt] does.
+  @override
+  Future<PdfPageTextRegion> loadTextInRect(PdfRect rect) async {
+    final text = await loadText();
+    final sb = StringBuffer();
+    final charIndices = <int>[];
+    final charRects = <PdfRect>[];
+    for (final f in text!.fragments) {
+      final b = f.bounds;
+      if (b.left > rect.right ||
+          b.right < rect.left ||
+          b.bottom > rect.top ||
+          b.top < rect.bottom) {
+        continue;
+      }
+      final charWidth = f.text.isEmpty ? 0.0 : b.width / f.text.length;
+      for (int i = 0; i < f.text.length; i++) {
+        final left = b.left + charWidth * i;
+        if (left > rect.right || left + charWidth < rect.left) continue;
+        sb.write(f.text[i]);
+        charIndices.add(f.index + i);
+        charRects.add(PdfRect(left, b.top, left + charWidth, b.bottom));
+      }
+    }
+    return PdfPageTextRegion(
+      rect: rect,
+      text: sb.toString(),
+      charIndices: charIndices,
+      charRects: charRects,
+    );
+  }
+
+  @override
+  Future<int?> getCharIndexAt(double x, double y,
+      {double tolerance = 4}) async {
+    final text = await loadText();
+    for (final f in text!.fragments) {
+      final b = f.bounds;
+      if (x < b.left - tolerance ||
+          x > b.right + tolerance ||
+          y < b.bottom - tolerance ||
+          y > b.top + tolerance) {
+        continue;
+      }
+      if (f.text.isEmpty || b.width <= 0) return f.index;
+      final offset = ((x - b.left) / b.width * f.text.length).floor();
+      return f.index + offset.clamp(0, f.text.length - 1);
+    }
+    return null;
+  }
 }
 
 class PdfImageWeb extends PdfImage {
@@ -1,32 +1,36 @@
+#include "pdfium_interop.h"
+
 #include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include <thread>
 #include <condition_variable>
 #include <mutex>
-#include <fpdfview.h>
-
-#if defined(_WIN32)
-#define EXPORT __declspec(dllexport)
-#define INTEROP_API __stdcall
-#else
-#define EXPORT __attribute__((visibility("default"))) __attribute__((used))
-#define INTEROP_API
-#endif
 
-struct pdfrx_file_access;
-
-typedef void(INTEROP_API *pdfrx_read_function)(void *param,
-                                               size_t position,
-                                               unsigned char *pBuf,
-                                               size_t size);
+struct pdfrx_read_request
+{
+  std::vector<unsigned char> buffer;
+  bool completed = false;
+  int retValue = 0;
+};
 
 struct pdfrx_file_access
 {
   FPDF_FILEACCESS fileAccess;
-  int retValue;
   pdfrx_read_function readBlock;
   void *param;
+  unsigned int timeoutMs;
   std::mutex mutex;
   std::condition_variable cond;
+  uint64_t nextRequestId;
+  bool canceled;
+  // Requests whose results are not notified yet; timed out requests are kept until the results are
+  // notified because the reader may still be writing to their buffers.
+  std::unordered_map<uint64_t, std::shared_ptr<pdfrx_read_request>> requests;
+  pdfrx_file_access_stats stats;
 };
 
 static int INTEROP_API read(void *param,
@@ -35,21 +39,79 @@ static int INTEROP_API read(void *param,
                             unsigned long size)
 {
   auto fileAccess = reinterpret_cast<pdfrx_file_access *>(param);
+  const auto start = std::chrono::steady_clock::now();
   std::unique_lock<std::mutex> lock(fileAccess->mutex);
-  fileAccess->readBlock(fileAccess->param, position, pBuf, size);
-  fileAccess->cond.wait(lock);
-  return fileAccess->retValue;
+  if (fileAccess->canceled)
+  {
+    fileAccess->stats.canceledCount++;
+    return 0;
+  }
+  const auto requestId = fileAccess->nextRequestId++;
+  auto request = std::make_shared<pdfrx_read_request>();
+  request->buffer.resize(size);
+  fileAccess->requests[requestId] = request;
+  // the reader may notify the result synchronously
+  lock.unlock();
+  fileAccess->readBlock(fileAccess->param, position, request->buffer.data(), size, requestId);
+  lock.lock();
+
+  const auto isCompleted = [fileAccess, &request]
+  { return request->completed || fileAccess->canceled; };
+  bool completed;
+  if (fileAccess->timeoutMs == 0)
+  {
+    fileAccess->cond.wait(lock, isCompleted);
+    completed = true;
+  }
+  else
+  {
+    completed = fileAccess->cond.wait_for(lock, std::chrono::milliseconds(fileAccess->timeoutMs), isCompleted);
+  }
+
+  const auto waitUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+  auto &stats = fileAccess->stats;
+  stats.readCount++;
+  stats.totalWaitMicroseconds += waitUs;
+  if (waitUs > stats.maxWaitMicroseconds)
+    stats.maxWaitMicroseconds = waitUs;
+
+  if (!request->completed)
+  {
+    // leave the request on the map; pdfrx_file_access_set_value will release it
+    if (completed)
+      stats.canceledCount++;
+    else
+      stats.timeoutCount++;
+    return 0;
+  }
+  fileAccess->requests.erase(requestId);
+
+  // PDFium expects non-zero on success and 0 on failure
+  const int retValue = request->retValue;
+  if (retValue <= 0 || static_cast<unsigned long>(retValue) > size)
+  {
+    stats.failedCount++;
+    return 0;
+  }
+  memcpy(pBuf, request->buffer.data(), retValue);
+  if (static_cast<unsigned long>(retValue) < size)
+    memset(pBuf + retValue, 0, size - retValue);
+  stats.readBytes += retValue;
+  return 1;
 }
 
-extern "C" EXPORT pdfrx_file_access *INTEROP_API pdfrx_file_access_create(unsigned long fileSize, pdfrx_read_function readBlock, void *param)
+extern "C" EXPORT pdfrx_file_access *INTEROP_API pdfrx_file_access_create(unsigned long fileSize, pdfrx_read_function readBlock, void *param, unsigned int timeoutMs)
 {
   auto fileAccess = new pdfrx_file_access();
   fileAccess->fileAccess.m_FileLen = fileSize;
   fileAccess->fileAccess.m_GetBlock = read;
   fileAccess->fileAccess.m_Param = fileAccess;
-  fileAccess->retValue = 0;
   fileAccess->readBlock = readBlock;
   fileAccess->param = param;
+  fileAccess->timeoutMs = timeoutMs;
+  fileAccess->nextRequestId = 1;
+  fileAccess->canceled = false;
+  fileAccess->stats = pdfrx_file_access_stats();
   return fileAccess;
 }
 
@@ -58,11 +120,34 @@ extern "C" EXPORT void INTEROP_API pdfrx_file_access_destroy(pdfrx_file_access *
   delete fileAccess;
 }
 
-extern "C" EXPORT void INTEROP_API pdfrx_file_access_set_value(pdfrx_file_access *fileAccess, int retValue)
+extern "C" EXPORT void INTEROP_API pdfrx_file_access_set_value(pdfrx_file_access *fileAccess, uint64_t requestId, int retValue)
+{
+  std::unique_lock<std::mutex> lock(fileAccess->mutex);
+  auto it = fileAccess->requests.find(requestId);
+  if (it == fileAccess->requests.end())
+    return;
+  it->second->retValue = retValue;
+  it->second->completed = true;
+  if (it->second.use_count() == 1)
+  {
+    // nobody waits for the request anymore (timed out)
+    fileAccess->requests.erase(it);
+    return;
+  }
+  fileAccess->cond.notify_all();
+}
+
+extern "C" EXPORT void INTEROP_API pdfrx_file_access_cancel(pdfrx_file_access *fileAccess)
+{
+  std::unique_lock<std::mutex> lock(fileAccess->mutex);
+  fileAccess->canceled = true;
+  fileAccess->cond.notify_all();
+}
+
+extern "C" EXPORT void INTEROP_API pdfrx_file_access_get_stats(pdfrx_file_access *fileAccess, pdfrx_file_access_stats *stats)
 {
   std::unique_lock<std::mutex> lock(fileAccess->mutex);
-  fileAccess->retValue = retValue;
-  fileAccess->cond.notify_one();
+  *stats = fileAccess->stats;
 }
 
 #if defined(__APPLE__)
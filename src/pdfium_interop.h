@@ -0,0 +1,258 @@
+#ifndef PDFRX_PDFIUM_INTEROP_H
+#define PDFRX_PDFIUM_INTEROP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <fpdfview.h>
+
+#if defined(_WIN32)
+#define EXPORT __declspec(dllexport)
+#define INTEROP_API __stdcall
+#else
+#define EXPORT __attribute__((visibility("default"))) __attribute__((used))
+#define INTEROP_API
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  struct pdfrx_file_access;
+
+  // The read function is called on the PDFium thread and it should not block; the result should be
+  // notified later by pdfrx_file_access_set_value with the same requestId. pBuf is owned by the file access
+  // and valid until the result is notified or the file access is destroyed.
+  typedef void(INTEROP_API *pdfrx_read_function)(void *param,
+                                                 size_t position,
+                                                 unsigned char *pBuf,
+                                                 size_t size,
+                                                 uint64_t requestId);
+
+  struct pdfrx_file_access_stats
+  {
+    uint64_t readCount;
+    uint64_t readBytes;
+    uint64_t failedCount;
+    uint64_t timeoutCount;
+    uint64_t canceledCount;
+    uint64_t totalWaitMicroseconds;
+    uint64_t maxWaitMicroseconds;
+  };
+
+  // timeoutMs is the maximum time to wait for a block read; 0 to wait infinitely.
+  EXPORT pdfrx_file_access *INTEROP_API pdfrx_file_access_create(unsigned long fileSize, pdfrx_read_function readBlock, void *param, unsigned int timeoutMs);
+  EXPORT void INTEROP_API pdfrx_file_access_destroy(pdfrx_file_access *fileAccess);
+  EXPORT void INTEROP_API pdfrx_file_access_set_value(pdfrx_file_access *fileAccess, uint64_t requestId, int retValue);
+  // Cancel the file access; pending and future reads fail immediately without calling the read function.
+  EXPORT void INTEROP_API pdfrx_file_access_cancel(pdfrx_file_access *fileAccess);
+  EXPORT void INTEROP_API pdfrx_file_access_get_stats(pdfrx_file_access *fileAccess, pdfrx_file_access_stats *stats);
+
+  // Page cache (pdfrx_page_cache.cpp)
+  //
+  // Per-document cache of the text pages (FPDF_TEXTPAGE) prepared ahead of use within a memory budget; the calls on
+  // a cache should be serialized (like the other calls on the document) and the cache should be destroyed before
+  // closing the pages.
+
+  struct pdfrx_page_cache;
+
+  EXPORT pdfrx_page_cache *INTEROP_API pdfrx_page_cache_create(int64_t budgetBytes);
+  EXPORT void INTEROP_API pdfrx_page_cache_destroy(pdfrx_page_cache *cache);
+  // Load the text pages of the pages (if loadText is non-zero) in the order of priority until the cache reaches
+  // budgetBytes, which also replaces the budget of the cache. Returns the number of the text pages newly loaded.
+  EXPORT int INTEROP_API pdfrx_page_cache_prepare(pdfrx_page_cache *cache, FPDF_PAGE *pages, int pageCount, int loadText, int64_t budgetBytes);
+  // Returns the (cached) text page of the page; release it by pdfrx_page_cache_release_text. If cache is null,
+  // the text page is simply loaded and closed on release.
+  EXPORT FPDF_TEXTPAGE INTEROP_API pdfrx_page_cache_acquire_text(pdfrx_page_cache *cache, FPDF_PAGE page);
+  EXPORT void INTEROP_API pdfrx_page_cache_release_text(pdfrx_page_cache *cache, FPDF_PAGE page, FPDF_TEXTPAGE textPage);
+  EXPORT int64_t INTEROP_API pdfrx_page_cache_used_bytes(pdfrx_page_cache *cache);
+
+  // Rendering (pdfrx_render.cpp)
+
+#define PDFRX_RENDER_OK 0
+#define PDFRX_RENDER_INVALID_ARGUMENT -1
+#define PDFRX_RENDER_BITMAP_FAILED -2
+
+  // Render the width x height area at (x, y) of the page scaled to fullWidth x fullHeight into the caller-owned
+  // buffer of bufferSize bytes with stride bytes per row in format (FPDFBitmap_Gray/BGR/BGRx/BGRA) after filling
+  // it with backgroundColor (ARGB). flags are FPDF_RenderPageBitmap's. The buffer size and the stride are validated
+  // before rendering. Returns PDFRX_RENDER_OK or one of the negative PDFRX_RENDER_* errors.
+  EXPORT int INTEROP_API pdfrx_render_page(FPDF_PAGE page, unsigned char *buffer, int64_t bufferSize, int width, int height, int stride, int format, int x, int y, int fullWidth, int fullHeight, unsigned int backgroundColor, int flags);
+
+  // Reference-counted pixel buffers recycled through a process-wide pool. A buffer is allocated with one reference
+  // and returns to the pool when the last reference is released; pdfrx_buffer_release has the signature of the Dart
+  // native finalizers so that the typed lists on the buffers can own references.
+  EXPORT unsigned char *INTEROP_API pdfrx_buffer_alloc(int64_t size);
+  EXPORT void INTEROP_API pdfrx_buffer_retain(void *buffer);
+  EXPORT void INTEROP_API pdfrx_buffer_release(void *buffer);
+  // Set the maximum total size of the idle buffers kept in the pool (64MB by default); 0 to disable pooling.
+  EXPORT void INTEROP_API pdfrx_buffer_pool_set_max_idle_bytes(int64_t maxIdleBytes);
+
+  // Progressive rendering into a pooled BGRA buffer (width * 4 bytes per row). Each call renders for about
+  // timeSliceMs (without pausing if it is 0) and the status is FPDF_RENDER_TOBECONTINUED until FPDF_RENDER_DONE or
+  // FPDF_RENDER_FAILED. PDFium keeps the progress on the page, so the page must not be rendered otherwise until the
+  // job is closed.
+  //
+  // The job is limited to protect the callers from pathological pages (each limit is ignored if it is 0):
+  // - maxBitmapBytes: the image is rendered at the lower resolution that fits the limit.
+  // - maxPageObjects: pages with more objects are not rendered at all; the image is only filled with the background.
+  // - timeLimitMs: the rendering is aborted (FPDF_RENDER_DONE) at the time limit and the image is what is rendered
+  //   so far. PDFium checks the time between the page objects, so a single heavy object may exceed it.
+  // The limits applied are reported by pdfrx_render_progressive_get_result as PDFRX_RENDER_DEGRADED_* flags.
+  struct pdfrx_render_job;
+
+#define PDFRX_RENDER_DEGRADED_BITMAP_SIZE 1
+#define PDFRX_RENDER_DEGRADED_PAGE_OBJECTS 2
+#define PDFRX_RENDER_DEGRADED_TIME 4
+
+  // Start the job and render the first slice; returns null if the arguments are invalid or allocation fails.
+  EXPORT pdfrx_render_job *INTEROP_API pdfrx_render_progressive_start(FPDF_PAGE page, int width, int height, int x, int y, int fullWidth, int fullHeight, unsigned int backgroundColor, int flags, int timeSliceMs, int64_t maxBitmapBytes, int maxPageObjects, int timeLimitMs);
+  // Render the next slice if the job is not finished; returns the status.
+  EXPORT int INTEROP_API pdfrx_render_progressive_continue(pdfrx_render_job *job, int timeSliceMs);
+  EXPORT int INTEROP_API pdfrx_render_progressive_status(pdfrx_render_job *job);
+  // Get the actual size of the image (smaller than requested if maxBitmapBytes is applied) and returns the
+  // PDFRX_RENDER_DEGRADED_* flags.
+  EXPORT int INTEROP_API pdfrx_render_progressive_get_result(pdfrx_render_job *job, int *width, int *height);
+  // Returns a copy of the pixels rendered so far in a new pooled buffer; null if allocation fails.
+  EXPORT unsigned char *INTEROP_API pdfrx_render_progressive_snapshot(pdfrx_render_job *job);
+  // Close the job; if takeBuffer is non-zero, the reference to the job's buffer is passed to the caller and returned.
+  EXPORT unsigned char *INTEROP_API pdfrx_render_progressive_close(pdfrx_render_job *job, int takeBuffer);
+
+  // Memory-mapped files (pdfrx_mapped_file.cpp)
+  //
+  // Read-only mapping of a whole file (e.g. a bundled asset) to be opened by FPDF_LoadMemDocument64 without copying
+  // it; the file should be closed after the document is closed.
+
+  struct pdfrx_mapped_file;
+
+  // path is in UTF-8; returns null if the file cannot be opened or mapped, or is empty.
+  EXPORT pdfrx_mapped_file *INTEROP_API pdfrx_mapped_file_open(const char *path);
+  EXPORT const unsigned char *INTEROP_API pdfrx_mapped_file_data(pdfrx_mapped_file *file);
+  EXPORT int64_t INTEROP_API pdfrx_mapped_file_size(pdfrx_mapped_file *file);
+  EXPORT void INTEROP_API pdfrx_mapped_file_close(pdfrx_mapped_file *file);
+
+  // Text selection (pdfrx_text.cpp)
+  //
+  // Character indices are PDFium's (FPDFText_*) ones; a negative count means up to the end of the page.
+  // The text pages are taken from cache if it is not null.
+
+  // Compute highlight rectangles of the character ranges on multiple pages at once; the rectangles are merged into
+  // line runs and written to rects as (left, top, right, bottom) in PDF page coordinates up to maxRects.
+  // rectCounts[i] receives the number of the rectangles for pages[i]. Returns the total number of the rectangles,
+  // which may exceed maxRects (call again with a larger buffer then).
+  EXPORT int INTEROP_API pdfrx_text_selection_rects(pdfrx_page_cache *cache, FPDF_PAGE *pages, int pageCount, const int *starts, const int *counts, double *rects, int maxRects, int *rectCounts);
+  // Returns the index of the character at (or nearest to) the position in PDF page coordinates; -1 if none.
+  EXPORT int INTEROP_API pdfrx_text_char_index_at(pdfrx_page_cache *cache, FPDF_PAGE page, double x, double y, double tolerance);
+  // Copy the text of the character range to buffer (UTF-16, not NUL-terminated) and returns the number of
+  // characters copied; if buffer is null, returns the number of characters in the range.
+  EXPORT int INTEROP_API pdfrx_text_get_range(pdfrx_page_cache *cache, FPDF_PAGE page, int start, int count, unsigned short *buffer, int bufferLength);
+  // Returns the characters whose boxes intersect the rectangle (PDF page coordinates, top > bottom) in the packed
+  // buffer (released by pdfrx_free) of: version (1), count, and for each character, its index, UTF-16 code unit and
+  // box (left, top, right, bottom as float). The boxes are looked up in a grid index kept along with the cached text
+  // page, so the cost is proportional to the characters around the rectangle rather than the whole page.
+  EXPORT unsigned char *INTEROP_API pdfrx_text_get_region(pdfrx_page_cache *cache, FPDF_PAGE page, double left, double top, double right, double bottom, int64_t *size);
+
+  // Page display list (pdfrx_display_list.cpp)
+  //
+  // The page objects are converted into a resolution independent list of drawing operations that can be replayed
+  // at any scale without PDFium: paths, glyph outlines of the filled text, decoded images and clip paths, with form
+  // XObjects flattened. The pages that cannot be represented faithfully (shadings, dashed strokes, stroked or
+  // clipping text, fonts without glyph outlines, visible annotations if enableAnnotations, ...) are reported by the
+  // flags with no operations and should be rendered by PDFium.
+
+#define PDFRX_DISPLAY_LIST_INCOMPLETE 1
+#define PDFRX_DISPLAY_LIST_TOO_LARGE 2
+
+  // Returns a packed buffer (released by pdfrx_free) of: version (1), PDFRX_DISPLAY_LIST_* flags, the matrix from the
+  // PDF page coordinates to the top-left origin page coordinates in points (6 floats), and the operations terminated
+  // by -1 (see pdfrx_display_list.cpp for the layout). The list is abandoned if it exceeds maxBytes.
+  EXPORT unsigned char *INTEROP_API pdfrx_page_display_list(pdfrx_page_cache *cache, FPDF_DOCUMENT doc, FPDF_PAGE page, int enableAnnotations, int64_t maxBytes, int64_t *size);
+
+  // Page reflow (pdfrx_reflow.cpp)
+  //
+  // The page text is extracted in the reading order as paragraphs of styled runs (font size, weight and style from
+  // the text page) to be laid out as native text at any width; the images and the form XObjects without text are
+  // reported as figure rectangles to be rendered as cropped regions of the page.
+
+#define PDFRX_REFLOW_RUN_ITALIC 1
+#define PDFRX_REFLOW_RUN_MONOSPACE 2
+#define PDFRX_REFLOW_RUN_SERIF 4
+
+  // Returns a packed buffer (released by pdfrx_free) of: version (1) and the blocks terminated by -1; a paragraph
+  // block is 0, its rectangle (left, top, right, bottom as float in PDF page coordinates), the run count and for
+  // each run, its font size (float), font weight, PDFRX_REFLOW_RUN_* flags and text (UTF-16); a figure block is 1
+  // and its rectangle. The figures are placed before the first paragraph below their top.
+  EXPORT unsigned char *INTEROP_API pdfrx_page_reflow(pdfrx_page_cache *cache, FPDF_PAGE page, int64_t *size);
+
+  // Visual page diff (pdfrx_diff.cpp)
+
+  // Returns a hash of the page content used to match pages between two documents; the text is used if the page
+  // has any, otherwise a coarse rendering.
+  EXPORT uint64_t INTEROP_API pdfrx_page_signature(FPDF_PAGE page);
+  // Render pageA and pageB at scale into width x height bitmaps (top-left aligned) and compare them tile by tile;
+  // a tile is changed if any channel differs more than threshold (0-255). The changed tiles are merged into
+  // rectangles (left, top, right, bottom in PDF page coordinates of pageB) and written to rects up to maxRects.
+  // If overlay is not null, a BGRA bitmap of width x height (pageB faded with the changed pixels in red) is written
+  // to it. Returns the number of the changed rectangles or -1 on error.
+  EXPORT int INTEROP_API pdfrx_page_diff(FPDF_PAGE pageA, FPDF_PAGE pageB, int width, int height, float scale, int tileSize, int threshold, double *rects, int maxRects, unsigned char *overlay);
+
+  // Annotations (pdfrx_annotations.cpp)
+
+  // Returns a packed snapshot of all the annotations on the pages (allocated by malloc; release it by pdfrx_free)
+  // and stores its size to size. See lib/src/pdfium/pdfrx_pdfium.dart (_AnnotationsSnapshotReader) for the format.
+  EXPORT unsigned char *INTEROP_API pdfrx_annotations_snapshot(FPDF_PAGE *pages, int pageCount, int64_t *size);
+  // Release memory allocated by pdfrx functions.
+  EXPORT void INTEROP_API pdfrx_free(void *p);
+
+  // Form fields (pdfrx_forms.cpp)
+
+  // Returns a packed snapshot of all the form fields (widget annotations) on the pages (allocated by malloc;
+  // release it by pdfrx_free). See lib/src/pdfium/pdfrx_pdfium.dart (_FormFieldsSnapshotReader) for the format.
+  EXPORT unsigned char *INTEROP_API pdfrx_form_fields_snapshot(FPDF_DOCUMENT doc, FPDF_PAGE *pages, int pageCount, int64_t *size);
+  // Apply the packed form field updates (see PdfFormFieldUpdate on the Dart side) at once and returns the number of
+  // the widgets updated or -1 if the updates are malformed.
+  EXPORT int INTEROP_API pdfrx_form_fields_update(FPDF_DOCUMENT doc, FPDF_PAGE *pages, int pageCount, const unsigned char *updates, int64_t size);
+
+  // Attachments (pdfrx_attachments.cpp)
+
+  // Sink for pdfrx_attachment_write; returns 0 to continue or non-zero to abort.
+  typedef int(INTEROP_API *pdfrx_write_function)(void *param, const unsigned char *data, size_t size);
+
+  // Returns a packed list of the names of the embedded files (allocated by malloc; release it by pdfrx_free).
+  // See lib/src/pdfium/pdfrx_pdfium.dart (PdfDocumentPdfium.loadAttachments) for the format.
+  EXPORT unsigned char *INTEROP_API pdfrx_attachments_snapshot(FPDF_DOCUMENT doc, int64_t *size);
+  // Stream the content of the embedded file to write in chunks of chunkSize bytes (0 for the default, 1MB).
+  // Returns the size of the content or -1 on error (including the abort by the sink).
+  EXPORT int64_t INTEROP_API pdfrx_attachment_write(FPDF_DOCUMENT doc, int index, pdfrx_write_function write, void *param, int chunkSize);
+  // Stream the content of the embedded file to the file descriptor; the descriptor is not closed.
+  EXPORT int64_t INTEROP_API pdfrx_attachment_write_fd(FPDF_DOCUMENT doc, int index, int fd, int chunkSize);
+  // Stream the content of the embedded file to the file (UTF-8 path); the file is removed on error.
+  EXPORT int64_t INTEROP_API pdfrx_attachment_write_file(FPDF_DOCUMENT doc, int index, const char *path, int chunkSize);
+
+  // Content fingerprint (pdfrx_fingerprint.cpp)
+  //
+  // The content is split into PDFRX_FINGERPRINT_CHUNK_SIZE byte chunks hashed (XXH64 seeded by the chunk index)
+  // in parallel, and the chunk hashes are combined with the total size and optional extra bytes (e.g. the file
+  // identifier). The result does not depend on the thread count or how the content is fed.
+
+#define PDFRX_FINGERPRINT_CHUNK_SIZE (4 * 1024 * 1024)
+
+  // Hash the chunks of data (the first chunk is the firstChunkIndex-th one of the whole content) to chunkHashes
+  // using threadCount threads (0 for the number of the CPU cores). Returns the number of the chunks.
+  // size must be a multiple of PDFRX_FINGERPRINT_CHUNK_SIZE unless data is the last part of the content.
+  EXPORT int64_t INTEROP_API pdfrx_fingerprint_hash_chunks(const unsigned char *data, int64_t size, int64_t firstChunkIndex, int threadCount, uint64_t *chunkHashes);
+  EXPORT uint64_t INTEROP_API pdfrx_fingerprint_combine(const uint64_t *chunkHashes, int64_t chunkCount, int64_t totalSize, const unsigned char *extra, int extraSize);
+  // Fingerprint the file (UTF-8 path) by memory-mapping it; returns 0 on success or -1 on error.
+  EXPORT int INTEROP_API pdfrx_fingerprint_file(const char *path, int threadCount, const unsigned char *extra, int extraSize, uint64_t *hash, int64_t *size);
+  // Hash the chunks of the file (UTF-8 path) to chunkHashes and store the file size; returns the number of the chunks
+  // (chunkHashes is untouched if it exceeds maxChunks) or -1 on error. Used to compare the file with a block manifest.
+  EXPORT int64_t INTEROP_API pdfrx_fingerprint_file_chunks(const char *path, int threadCount, uint64_t *chunkHashes, int64_t maxChunks, int64_t *size);
+  // Copy the permanent file identifier (the first element of the trailer ID) to buffer if it is large enough
+  // (length + 1 bytes for the terminating NUL) and returns its length; 0 if the document has no identifier.
+  EXPORT int INTEROP_API pdfrx_fingerprint_file_identifier(FPDF_DOCUMENT doc, unsigned char *buffer, int length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PDFRX_PDFIUM_INTEROP_H
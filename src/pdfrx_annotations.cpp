@@ -0,0 +1,127 @@
+#include "pdfium_interop.h"
+
+#include <fpdf_annot.h>
+
+#include "pdfrx_packed_buffer.h"
+
+#include <vector>
+
+namespace
+{
+  using pdfrx::PackedWriter;
+
+  void writeColor(PackedWriter &w, FPDF_ANNOTATION annot, FPDFANNOT_COLORTYPE type)
+  {
+    unsigned int r, g, b, a;
+    if (FPDFAnnot_GetColor(annot, type, &r, &g, &b, &a))
+      w.i32(static_cast<int32_t>((a << 24) | (r << 16) | (g << 8) | b));
+    else
+      w.i32(0); // fully transparent; no color
+  }
+
+  void writeString(PackedWriter &w, FPDF_ANNOTATION annot, const char *key)
+  {
+    w.utf16([&](FPDF_WCHAR *buffer, unsigned long length)
+            { return FPDFAnnot_GetStringValue(annot, key, buffer, length); });
+  }
+
+  void writeAnnotation(PackedWriter &w, FPDF_ANNOTATION annot)
+  {
+    w.i32(FPDFAnnot_GetSubtype(annot));
+    w.i32(FPDFAnnot_GetFlags(annot));
+    FS_RECTF rect = {};
+    FPDFAnnot_GetRect(annot, &rect);
+    w.f32(rect.left);
+    w.f32(rect.top);
+    w.f32(rect.right);
+    w.f32(rect.bottom);
+    writeColor(w, annot, FPDFANNOT_COLORTYPE_Color);
+    writeColor(w, annot, FPDFANNOT_COLORTYPE_InteriorColor);
+    float hr = 0, vr = 0, width = 0;
+    FPDFAnnot_GetBorder(annot, &hr, &vr, &width);
+    w.f32(width);
+
+    writeString(w, annot, "Contents");
+    writeString(w, annot, "T");
+    writeString(w, annot, "Subj");
+    writeString(w, annot, "M");
+    writeString(w, annot, "NM");
+
+    const size_t quadCount = FPDFAnnot_CountAttachmentPoints(annot);
+    w.i32(static_cast<int32_t>(quadCount));
+    for (size_t i = 0; i < quadCount; i++)
+    {
+      FS_QUADPOINTSF q = {};
+      FPDFAnnot_GetAttachmentPoints(annot, i, &q);
+      const float values[] = {q.x1, q.y1, q.x2, q.y2, q.x3, q.y3, q.x4, q.y4};
+      for (float v : values)
+        w.f32(v);
+    }
+
+    std::vector<FS_POINTF> points;
+    const unsigned long inkCount = FPDFAnnot_GetInkListCount(annot);
+    w.i32(static_cast<int32_t>(inkCount));
+    for (unsigned long i = 0; i < inkCount; i++)
+    {
+      const unsigned long n = FPDFAnnot_GetInkListPath(annot, i, nullptr, 0);
+      points.resize(n);
+      FPDFAnnot_GetInkListPath(annot, i, points.data(), n);
+      w.i32(static_cast<int32_t>(n));
+      for (const auto &p : points)
+      {
+        w.f32(p.x);
+        w.f32(p.y);
+      }
+    }
+
+    const unsigned long vertexCount = FPDFAnnot_GetVertices(annot, nullptr, 0);
+    points.resize(vertexCount);
+    FPDFAnnot_GetVertices(annot, points.data(), vertexCount);
+    w.i32(static_cast<int32_t>(vertexCount));
+    for (const auto &p : points)
+    {
+      w.f32(p.x);
+      w.f32(p.y);
+    }
+
+    FS_POINTF start = {}, end = {};
+    const bool hasLine = FPDFAnnot_GetLine(annot, &start, &end);
+    w.i32(hasLine ? 1 : 0);
+    if (hasLine)
+    {
+      w.f32(start.x);
+      w.f32(start.y);
+      w.f32(end.x);
+      w.f32(end.y);
+    }
+  }
+} // namespace
+
+extern "C" EXPORT unsigned char *INTEROP_API pdfrx_annotations_snapshot(FPDF_PAGE *pages, int pageCount, int64_t *size)
+{
+  PackedWriter w;
+  w.i32(1); // format version
+  w.i32(pageCount);
+  for (int i = 0; i < pageCount; i++)
+  {
+    const int count = FPDFPage_GetAnnotCount(pages[i]);
+    w.i32(count);
+    for (int j = 0; j < count; j++)
+    {
+      FPDF_ANNOTATION annot = FPDFPage_GetAnnot(pages[i], j);
+      if (!annot)
+      {
+        w.i32(-1); // subtype -1: failed to load the annotation; no other fields follow
+        continue;
+      }
+      writeAnnotation(w, annot);
+      FPDFPage_CloseAnnot(annot);
+    }
+  }
+  return w.detach(size);
+}
+
+extern "C" EXPORT void INTEROP_API pdfrx_free(void *p)
+{
+  free(p);
+}
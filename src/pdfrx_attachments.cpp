@@ -0,0 +1,148 @@
+#if defined(_WIN32)
+// before any include; windows.h (also included by fpdfview.h) should not define the min/max macros
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#endif
+
+#include "pdfium_interop.h"
+
+#include <fpdf_attachment.h>
+
+#include "pdfrx_packed_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  using pdfrx::PackedWriter;
+
+  const int kDefaultChunkSize = 1024 * 1024;
+
+  int INTEROP_API writeToFd(void *param, const unsigned char *data, size_t size)
+  {
+    const int fd = static_cast<int>(reinterpret_cast<intptr_t>(param));
+    while (size > 0)
+    {
+#if defined(_WIN32)
+      const int written = _write(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 0x40000000)));
+#else
+      const ssize_t written = write(fd, data, size);
+      if (written < 0 && errno == EINTR)
+        continue;
+#endif
+      if (written <= 0)
+        return -1;
+      data += written;
+      size -= static_cast<size_t>(written);
+    }
+    return 0;
+  }
+
+  int INTEROP_API writeToFile(void *param, const unsigned char *data, size_t size)
+  {
+    return fwrite(data, 1, size, static_cast<FILE *>(param)) == size ? 0 : -1;
+  }
+
+#if defined(_WIN32)
+  std::vector<wchar_t> widePath(const char *utf8Path)
+  {
+    const int length = MultiByteToWideChar(CP_UTF8, 0, utf8Path, -1, nullptr, 0);
+    std::vector<wchar_t> path(length > 0 ? length : 1, 0);
+    if (length > 0)
+      MultiByteToWideChar(CP_UTF8, 0, utf8Path, -1, path.data(), length);
+    return path;
+  }
+
+  FILE *openFile(const char *utf8Path) { return _wfopen(widePath(utf8Path).data(), L"wb"); }
+  void removeFile(const char *utf8Path) { _wremove(widePath(utf8Path).data()); }
+#else
+  FILE *openFile(const char *utf8Path) { return fopen(utf8Path, "wb"); }
+  void removeFile(const char *utf8Path) { remove(utf8Path); }
+#endif
+} // namespace
+
+extern "C" EXPORT unsigned char *INTEROP_API pdfrx_attachments_snapshot(FPDF_DOCUMENT doc, int64_t *size)
+{
+  PackedWriter w;
+  w.i32(1); // format version
+  const int count = std::max(0, FPDFDoc_GetAttachmentCount(doc));
+  w.i32(count);
+  for (int i = 0; i < count; i++)
+  {
+    FPDF_ATTACHMENT attachment = FPDFDoc_GetAttachment(doc, i);
+    if (!attachment)
+    {
+      w.i32(0);
+      continue;
+    }
+    w.utf16([&](FPDF_WCHAR *buffer, unsigned long length)
+            { return FPDFAttachment_GetName(attachment, buffer, length); });
+  }
+  return w.detach(size);
+}
+
+extern "C" EXPORT int64_t INTEROP_API pdfrx_attachment_write(FPDF_DOCUMENT doc, int index, pdfrx_write_function write, void *param, int chunkSize)
+{
+  FPDF_ATTACHMENT attachment = FPDFDoc_GetAttachment(doc, index);
+  if (!attachment)
+    return -1;
+  // PDFium only provides the whole decoded content; it is kept in a native buffer and passed to the sink in
+  // chunks so that the caller never has to hold the whole file on its side.
+  unsigned long length = 0;
+  if (!FPDFAttachment_GetFile(attachment, nullptr, 0, &length))
+    return -1;
+  unsigned char *buffer = static_cast<unsigned char *>(malloc(length ? length : 1));
+  if (!buffer)
+    return -1;
+  int64_t result = -1;
+  unsigned long copied = 0;
+  if (FPDFAttachment_GetFile(attachment, buffer, length, &copied) && copied == length)
+  {
+    const size_t chunk = chunkSize > 0 ? static_cast<size_t>(chunkSize) : kDefaultChunkSize;
+    size_t pos = 0;
+    while (pos < length)
+    {
+      const size_t n = std::min(chunk, static_cast<size_t>(length) - pos);
+      if (write(param, buffer + pos, n) != 0)
+        break;
+      pos += n;
+    }
+    if (pos == length)
+      result = static_cast<int64_t>(length);
+  }
+  free(buffer);
+  return result;
+}
+
+extern "C" EXPORT int64_t INTEROP_API pdfrx_attachment_write_fd(FPDF_DOCUMENT doc, int index, int fd, int chunkSize)
+{
+  return pdfrx_attachment_write(doc, index, writeToFd, reinterpret_cast<void *>(static_cast<intptr_t>(fd)), chunkSize);
+}
+
+extern "C" EXPORT int64_t INTEROP_API pdfrx_attachment_write_file(FPDF_DOCUMENT doc, int index, const char *path, int chunkSize)
+{
+  FILE *fp = openFile(path);
+  if (!fp)
+    return -1;
+  int64_t result = pdfrx_attachment_write(doc, index, writeToFile, fp, chunkSize);
+  if (fclose(fp) != 0)
+    result = -1;
+  if (result < 0)
+    removeFile(path); // do not leave a truncated file
+  return result;
+}
@@ -0,0 +1,233 @@
+#include "pdfium_interop.h"
+
+#include <fpdf_text.h>
+
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+  const uint64_t kFnvOffset = 1469598103934665603ull;
+  const uint64_t kFnvPrime = 1099511628211ull;
+
+  uint64_t fnv1a(uint64_t hash, uint64_t value)
+  {
+    for (int i = 0; i < 8; i++)
+    {
+      hash ^= (value >> (i * 8)) & 0xff;
+      hash *= kFnvPrime;
+    }
+    return hash;
+  }
+
+  // Render buffers are reused across the calls on the same (worker) thread; diffing hundreds of pages
+  // would otherwise allocate and page-fault two full-page bitmaps for every page.
+  struct BufferPool
+  {
+    std::vector<unsigned char> a;
+    std::vector<unsigned char> b;
+    std::vector<unsigned char> tiles;
+  };
+  thread_local BufferPool pool;
+
+  bool renderPage(FPDF_PAGE page, unsigned char *buffer, int width, int height, float scale)
+  {
+    FPDF_BITMAP bitmap = FPDFBitmap_CreateEx(width, height, FPDFBitmap_BGRA, buffer, width * 4);
+    if (!bitmap)
+      return false;
+    FPDFBitmap_FillRect(bitmap, 0, 0, width, height, 0xffffffff);
+    // pages of the different sizes are aligned to the top-left corner
+    const int w = static_cast<int>(std::ceil(FPDF_GetPageWidthF(page) * scale));
+    const int h = static_cast<int>(std::ceil(FPDF_GetPageHeightF(page) * scale));
+    FPDF_RenderPageBitmap(bitmap, page, 0, 0, w, h, 0, FPDF_ANNOT);
+    FPDFBitmap_Destroy(bitmap);
+    return true;
+  }
+
+  // Whether the tile has any pixel whose channel differs more than threshold; the inner loop is kept simple
+  // so that the compiler can vectorize it.
+  bool isTileChanged(const unsigned char *a, const unsigned char *b, int stride, int x0, int y0, int x1, int y1, int threshold)
+  {
+    const size_t rowBytes = static_cast<size_t>(x1 - x0) * 4;
+    bool identical = true;
+    for (int y = y0; y < y1 && identical; y++)
+    {
+      const size_t offset = static_cast<size_t>(y) * stride + static_cast<size_t>(x0) * 4;
+      identical = memcmp(a + offset, b + offset, rowBytes) == 0;
+    }
+    if (identical)
+      return false;
+    for (int y = y0; y < y1; y++)
+    {
+      const size_t offset = static_cast<size_t>(y) * stride + static_cast<size_t>(x0) * 4;
+      const unsigned char *pa = a + offset;
+      const unsigned char *pb = b + offset;
+      int maxDelta = 0;
+      for (size_t i = 0; i < rowBytes; i++)
+      {
+        const int d = pa[i] > pb[i] ? pa[i] - pb[i] : pb[i] - pa[i];
+        maxDelta = d > maxDelta ? d : maxDelta;
+      }
+      if (maxDelta > threshold)
+        return true;
+    }
+    return false;
+  }
+} // namespace
+
+extern "C" EXPORT uint64_t INTEROP_API pdfrx_page_signature(FPDF_PAGE page)
+{
+  uint64_t hash = kFnvOffset;
+  hash = fnv1a(hash, static_cast<uint64_t>(std::lround(FPDF_GetPageWidthF(page))));
+  hash = fnv1a(hash, static_cast<uint64_t>(std::lround(FPDF_GetPageHeightF(page))));
+
+  int charCount = 0;
+  FPDF_TEXTPAGE textPage = FPDFText_LoadPage(page);
+  if (textPage)
+  {
+    charCount = FPDFText_CountChars(textPage);
+    for (int i = 0; i < charCount; i++)
+      hash = fnv1a(hash, FPDFText_GetUnicode(textPage, i));
+    FPDFText_ClosePage(textPage);
+  }
+  if (charCount > 0)
+    return hash;
+
+  // no text (scanned page, drawings); use a coarse rendering instead
+  const int size = 32;
+  const float scale = static_cast<float>(size) / std::max(1.0f, std::max(FPDF_GetPageWidthF(page), FPDF_GetPageHeightF(page)));
+  std::vector<unsigned char> buffer(size * size * 4);
+  if (renderPage(page, buffer.data(), size, size, scale))
+  {
+    for (size_t i = 0; i < buffer.size(); i += 4)
+    {
+      // quantize to tolerate anti-aliasing differences
+      const int luminance = (buffer[i] * 114 + buffer[i + 1] * 587 + buffer[i + 2] * 299) / 1000;
+      hash = fnv1a(hash, static_cast<uint64_t>(luminance >> 5));
+    }
+  }
+  return hash;
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_page_diff(FPDF_PAGE pageA,
+                                                   FPDF_PAGE pageB,
+                                                   int width,
+                                                   int height,
+                                                   float scale,
+                                                   int tileSize,
+                                                   int threshold,
+                                                   double *rects,
+                                                   int maxRects,
+                                                   unsigned char *overlay)
+{
+  if (width <= 0 || height <= 0 || tileSize <= 0 || scale <= 0)
+    return -1;
+  const size_t bytes = static_cast<size_t>(width) * height * 4;
+  pool.a.resize(bytes);
+  pool.b.resize(bytes);
+  if (!renderPage(pageA, pool.a.data(), width, height, scale) || !renderPage(pageB, pool.b.data(), width, height, scale))
+    return -1;
+  const unsigned char *a = pool.a.data();
+  const unsigned char *b = pool.b.data();
+  const int stride = width * 4;
+
+  const int tilesX = (width + tileSize - 1) / tileSize;
+  const int tilesY = (height + tileSize - 1) / tileSize;
+  auto &tiles = pool.tiles;
+  tiles.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+  const bool pageIdentical = memcmp(a, b, bytes) == 0;
+  if (!pageIdentical)
+  {
+    for (int ty = 0; ty < tilesY; ty++)
+    {
+      for (int tx = 0; tx < tilesX; tx++)
+      {
+        const int x0 = tx * tileSize, y0 = ty * tileSize;
+        tiles[ty * tilesX + tx] = isTileChanged(a, b, stride, x0, y0, std::min(x0 + tileSize, width), std::min(y0 + tileSize, height), threshold) ? 1 : 0;
+      }
+    }
+  }
+
+  // merge the 8-connected changed tiles into rectangles
+  int count = 0;
+  const double pageHeightB = FPDF_GetPageHeightF(pageB);
+  std::vector<int> stack;
+  for (int i = 0; i < tilesX * tilesY; i++)
+  {
+    if (tiles[i] != 1)
+      continue;
+    int minX = tilesX, minY = tilesY, maxX = -1, maxY = -1;
+    tiles[i] = 2;
+    stack.push_back(i);
+    while (!stack.empty())
+    {
+      const int t = stack.back();
+      stack.pop_back();
+      const int tx = t % tilesX, ty = t / tilesX;
+      minX = std::min(minX, tx);
+      maxX = std::max(maxX, tx);
+      minY = std::min(minY, ty);
+      maxY = std::max(maxY, ty);
+      for (int dy = -1; dy <= 1; dy++)
+      {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+          const int nx = tx + dx, ny = ty + dy;
+          if (nx < 0 || ny < 0 || nx >= tilesX || ny >= tilesY)
+            continue;
+          const int n = ny * tilesX + nx;
+          if (tiles[n] == 1)
+          {
+            tiles[n] = 2;
+            stack.push_back(n);
+          }
+        }
+      }
+    }
+    if (count < maxRects)
+    {
+      // in PDF page coordinates of pageB
+      double *p = rects + count * 4;
+      p[0] = minX * tileSize / scale;
+      p[1] = pageHeightB - minY * tileSize / scale;
+      p[2] = std::min((maxX + 1) * tileSize, width) / scale;
+      p[3] = pageHeightB - std::min((maxY + 1) * tileSize, height) / scale;
+    }
+    count++;
+  }
+
+  if (overlay)
+  {
+    // pageB faded, changed pixels in red
+    for (int y = 0; y < height; y++)
+    {
+      const int ty = y / tileSize;
+      for (int x = 0; x < width; x++)
+      {
+        const size_t i = static_cast<size_t>(y) * stride + static_cast<size_t>(x) * 4;
+        bool changed = false;
+        if (tiles[ty * tilesX + x / tileSize] != 0)
+        {
+          const int d = std::max(std::abs(a[i] - b[i]), std::max(std::abs(a[i + 1] - b[i + 1]), std::abs(a[i + 2] - b[i + 2])));
+          changed = d > threshold;
+        }
+        if (changed)
+        {
+          overlay[i] = 0;
+          overlay[i + 1] = 0;
+          overlay[i + 2] = 255;
+        }
+        else
+        {
+          overlay[i] = static_cast<unsigned char>((b[i] + 255 * 3) / 4);
+          overlay[i + 1] = static_cast<unsigned char>((b[i + 1] + 255 * 3) / 4);
+          overlay[i + 2] = static_cast<unsigned char>((b[i + 2] + 255 * 3) / 4);
+        }
+        overlay[i + 3] = 255;
+      }
+    }
+  }
+  return count;
+}
@@ -0,0 +1,430 @@
+#include "pdfium_interop.h"
+
+#include <fpdf_annot.h>
+#include <fpdf_edit.h>
+#include <fpdf_text.h>
+#include <fpdf_transformpage.h>
+
+#include "pdfrx_packed_buffer.h"
+#include "pdfrx_page_objects.h"
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+  using pdfrx::concat;
+  using pdfrx::PackedWriter;
+
+  const int kAnnotLink = 2;   // FPDF_ANNOT_LINK
+  const int kAnnotPopup = 16; // FPDF_ANNOT_POPUP
+
+  enum Op
+  {
+    kOpEnd = -1,
+    kOpSave = 0,
+    kOpRestore = 1,
+    kOpClip = 2,     // matrix, segments
+    kOpPath = 3,     // matrix, fill mode, stroke, fill color, stroke color, stroke width, line cap, line join, segments
+    kOpGlyphDef = 4, // glyph id, segments (the glyph outline at font size 1)
+    kOpGlyph = 5,    // glyph id, matrix, fill color
+    kOpImage = 6,    // matrix, width, height, RGBA pixels
+  };
+
+  const FS_MATRIX kIdentity = {1, 0, 0, 1, 0, 0};
+
+  class DisplayListWriter
+  {
+  public:
+    DisplayListWriter(FPDF_DOCUMENT doc, FPDF_PAGE page, FPDF_TEXTPAGE textPage, int64_t maxBytes, PackedWriter &w)
+        : doc_(doc), page_(page), textPage_(textPage), maxBytes_(maxBytes), w_(w)
+    {
+      // the characters of the text page are the only way to get the glyph positions of the text objects
+      const int charCount = textPage ? FPDFText_CountChars(textPage) : 0;
+      for (int i = 0; i < charCount; i++)
+      {
+        FPDF_PAGEOBJECT obj = FPDFText_GetTextObject(textPage, i);
+        if (obj)
+          textChars_[obj].push_back(i);
+      }
+    }
+
+    int flags() const { return flags_; }
+
+    bool writePage()
+    {
+      const int count = FPDFPage_CountObjects(page_);
+      for (int i = 0; i < count; i++)
+      {
+        if (!writeObject(FPDFPage_GetObject(page_, i), kIdentity, 0))
+          return false;
+      }
+      return true;
+    }
+
+  private:
+    bool fail(int flag)
+    {
+      flags_ |= flag;
+      return false;
+    }
+
+    bool checkSize() { return static_cast<int64_t>(w_.size()) <= maxBytes_ || fail(PDFRX_DISPLAY_LIST_TOO_LARGE); }
+
+    void matrix(const FS_MATRIX &m)
+    {
+      w_.f32(m.a);
+      w_.f32(m.b);
+      w_.f32(m.c);
+      w_.f32(m.d);
+      w_.f32(m.e);
+      w_.f32(m.f);
+    }
+
+    template <typename GetSegment>
+    bool segments(int count, GetSegment getSegment)
+    {
+      w_.i32(count > 0 ? count : 0);
+      for (int i = 0; i < count; i++)
+      {
+        FPDF_PATHSEGMENT segment = getSegment(i);
+        float x, y;
+        const int type = segment ? FPDFPathSegment_GetType(segment) : FPDF_SEGMENT_UNKNOWN;
+        if (type == FPDF_SEGMENT_UNKNOWN || !FPDFPathSegment_GetPoint(segment, &x, &y))
+          return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+        w_.i32(type | (FPDFPathSegment_GetClose(segment) ? 0x100 : 0));
+        w_.f32(x);
+        w_.f32(y);
+      }
+      return true;
+    }
+
+    static int32_t argb(unsigned int r, unsigned int g, unsigned int b, unsigned int a)
+    {
+      return static_cast<int32_t>((a << 24) | (r << 16) | (g << 8) | b);
+    }
+
+    static int32_t fillColor(FPDF_PAGEOBJECT obj)
+    {
+      unsigned int r, g, b, a;
+      return FPDFPageObj_GetFillColor(obj, &r, &g, &b, &a) ? argb(r, g, b, a) : argb(0, 0, 0, 255);
+    }
+
+    static int32_t strokeColor(FPDF_PAGEOBJECT obj)
+    {
+      unsigned int r, g, b, a;
+      return FPDFPageObj_GetStrokeColor(obj, &r, &g, &b, &a) ? argb(r, g, b, a) : argb(0, 0, 0, 255);
+    }
+
+    bool writeObject(FPDF_PAGEOBJECT obj, const FS_MATRIX &parent, int depth)
+    {
+      if (!obj)
+        return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+      // the clip paths are in the coordinates of the content stream containing the object
+      FPDF_CLIPPATH clip = FPDFPageObj_GetClipPath(obj);
+      const int clipCount = clip ? FPDFClipPath_CountPaths(clip) : 0;
+      if (clipCount > 0)
+      {
+        w_.i32(kOpSave);
+        for (int i = 0; i < clipCount; i++)
+        {
+          w_.i32(kOpClip);
+          matrix(parent);
+          if (!segments(FPDFClipPath_CountPathSegments(clip, i), [&](int j)
+                        { return FPDFClipPath_GetPathSegment(clip, i, j); }))
+            return false;
+        }
+      }
+
+      bool ok;
+      switch (FPDFPageObj_GetType(obj))
+      {
+      case FPDF_PAGEOBJ_PATH:
+        ok = writePath(obj, parent);
+        break;
+      case FPDF_PAGEOBJ_TEXT:
+        ok = writeText(obj);
+        break;
+      case FPDF_PAGEOBJ_IMAGE:
+        ok = writeImage(obj, parent);
+        break;
+      case FPDF_PAGEOBJ_FORM:
+        ok = writeForm(obj, parent, depth);
+        break;
+      default:
+        // shadings and unknown objects are left to PDFium
+        ok = fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+        break;
+      }
+      if (clipCount > 0)
+        w_.i32(kOpRestore);
+      return ok && checkSize();
+    }
+
+    bool writePath(FPDF_PAGEOBJECT obj, const FS_MATRIX &parent)
+    {
+      int fillMode;
+      FPDF_BOOL stroke;
+      FS_MATRIX m;
+      if (!FPDFPath_GetDrawMode(obj, &fillMode, &stroke) || !FPDFPageObj_GetMatrix(obj, &m))
+        return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+      if (fillMode == FPDF_FILLMODE_NONE && !stroke)
+        return true;
+      if (stroke && FPDFPageObj_GetDashCount(obj) > 0)
+        return fail(PDFRX_DISPLAY_LIST_INCOMPLETE); // Flutter does not support dashes natively
+      float strokeWidth = 1;
+      FPDFPageObj_GetStrokeWidth(obj, &strokeWidth);
+      w_.i32(kOpPath);
+      matrix(concat(m, parent));
+      w_.i32(fillMode);
+      w_.i32(stroke ? 1 : 0);
+      w_.i32(fillColor(obj));
+      w_.i32(strokeColor(obj));
+      w_.f32(strokeWidth);
+      w_.i32(FPDFPageObj_GetLineCap(obj));
+      w_.i32(FPDFPageObj_GetLineJoin(obj));
+      return segments(FPDFPath_CountSegments(obj), [&](int i)
+                      { return FPDFPath_GetPathSegment(obj, i); });
+    }
+
+    bool writeText(FPDF_PAGEOBJECT obj)
+    {
+      const int mode = FPDFTextObj_GetTextRenderMode(obj);
+      if (mode == FPDF_TEXTRENDERMODE_INVISIBLE)
+        return true;
+      // stroked and clipping text are left to PDFium
+      if (mode != FPDF_TEXTRENDERMODE_FILL || !textPage_)
+        return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+      auto it = textChars_.find(obj);
+      if (it == textChars_.end())
+        return true; // no visible characters (e.g. spaces)
+      FPDF_FONT font = FPDFTextObj_GetFont(obj);
+      float fontSize = 0;
+      if (!font || !FPDFTextObj_GetFontSize(obj, &fontSize))
+        return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+      const int32_t color = fillColor(obj);
+      for (int i : it->second)
+      {
+        const int glyph = glyphId(font, FPDFText_GetUnicode(textPage_, i));
+        if (glyph == kNoGlyph)
+          return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+        if (glyph == kEmptyGlyph)
+          continue;
+        // the character matrix is the text matrix (including the form matrices) without the font size
+        FS_MATRIX m;
+        double x, y;
+        if (!FPDFText_GetMatrix(textPage_, i, &m) || !FPDFText_GetCharOrigin(textPage_, i, &x, &y))
+          return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+        w_.i32(kOpGlyph);
+        w_.i32(glyph);
+        matrix(FS_MATRIX{m.a * fontSize, m.b * fontSize, m.c * fontSize, m.d * fontSize, static_cast<float>(x), static_cast<float>(y)});
+        w_.i32(color);
+      }
+      return true;
+    }
+
+    static const int kNoGlyph = -1;
+    static const int kEmptyGlyph = -2;
+
+    // The glyph outlines are written once for each font/character and referenced by id.
+    int glyphId(FPDF_FONT font, unsigned int unicode)
+    {
+      const auto key = std::make_pair(font, unicode);
+      auto it = glyphs_.find(key);
+      if (it != glyphs_.end())
+        return it->second;
+      int id = kNoGlyph;
+      FPDF_GLYPHPATH path = FPDFFont_GetGlyphPath(font, unicode, 1.0f);
+      if (path)
+      {
+        const int count = FPDFGlyphPath_CountGlyphSegments(path);
+        if (count <= 0)
+        {
+          id = kEmptyGlyph;
+        }
+        else
+        {
+          id = nextGlyphId_++;
+          w_.i32(kOpGlyphDef);
+          w_.i32(id);
+          if (!segments(count, [&](int i)
+                        { return FPDFGlyphPath_GetGlyphPathSegment(path, i); }))
+            id = kNoGlyph;
+        }
+      }
+      glyphs_[key] = id;
+      return id;
+    }
+
+    bool writeImage(FPDF_PAGEOBJECT obj, const FS_MATRIX &parent)
+    {
+      FS_MATRIX m;
+      FPDF_IMAGEOBJ_METADATA metadata;
+      if (!FPDFPageObj_GetMatrix(obj, &m) || !FPDFImageObj_GetImageMetadata(obj, page_, &metadata))
+        return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+      // the decoded pixels in the original resolution unless the image has a mask (or is a stencil mask); such
+      // images are rasterized by PDFium in the size on the page (1 pixel per point) with the mask applied
+      const bool masked = FPDFPageObj_HasTransparency(obj) || metadata.colorspace == FPDF_COLORSPACE_UNKNOWN;
+      if (masked && (m.b != 0 || m.c != 0 || m.a <= 0 || m.d <= 0))
+        return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+      FPDF_BITMAP bitmap = masked ? FPDFImageObj_GetRenderedBitmap(doc_, page_, obj) : FPDFImageObj_GetBitmap(obj);
+      if (!bitmap)
+        return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+      const int width = FPDFBitmap_GetWidth(bitmap);
+      const int height = FPDFBitmap_GetHeight(bitmap);
+      const int stride = FPDFBitmap_GetStride(bitmap);
+      const int format = FPDFBitmap_GetFormat(bitmap);
+      const unsigned char *src = static_cast<const unsigned char *>(FPDFBitmap_GetBuffer(bitmap));
+      const int64_t bytes = static_cast<int64_t>(width) * height * 4;
+      bool ok = true;
+      if (!src || width <= 0 || height <= 0 || format == FPDFBitmap_Unknown)
+        ok = fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+      else if (static_cast<int64_t>(w_.size()) + bytes > maxBytes_)
+        ok = fail(PDFRX_DISPLAY_LIST_TOO_LARGE);
+      if (ok)
+      {
+        w_.i32(kOpImage);
+        matrix(concat(m, parent));
+        w_.i32(width);
+        w_.i32(height);
+        std::vector<unsigned char> row(static_cast<size_t>(width) * 4);
+        for (int y = 0; y < height; y++)
+        {
+          const unsigned char *s = src + static_cast<size_t>(y) * stride;
+          unsigned char *d = row.data();
+          for (int x = 0; x < width; x++, d += 4)
+          {
+            switch (format)
+            {
+            case FPDFBitmap_Gray:
+              d[0] = d[1] = d[2] = s[x];
+              d[3] = 255;
+              break;
+            case FPDFBitmap_BGR:
+              d[0] = s[x * 3 + 2];
+              d[1] = s[x * 3 + 1];
+              d[2] = s[x * 3];
+              d[3] = 255;
+              break;
+            default: // BGRx/BGRA
+              d[0] = s[x * 4 + 2];
+              d[1] = s[x * 4 + 1];
+              d[2] = s[x * 4];
+              d[3] = format == FPDFBitmap_BGRA ? s[x * 4 + 3] : 255;
+              break;
+            }
+          }
+          w_.bytes(row.data(), row.size());
+        }
+      }
+      FPDFBitmap_Destroy(bitmap);
+      return ok;
+    }
+
+    bool writeForm(FPDF_PAGEOBJECT obj, const FS_MATRIX &parent, int depth)
+    {
+      bool ok = true;
+      if (!pdfrx::visitFormObjects(obj, parent, depth, [&](FPDF_PAGEOBJECT child, const FS_MATRIX &m, int childDepth)
+                                   { return ok = writeObject(child, m, childDepth); }))
+        return fail(PDFRX_DISPLAY_LIST_INCOMPLETE);
+      return ok;
+    }
+
+    FPDF_DOCUMENT doc_;
+    FPDF_PAGE page_;
+    FPDF_TEXTPAGE textPage_;
+    int64_t maxBytes_;
+    PackedWriter &w_;
+    int flags_ = 0;
+    std::unordered_map<FPDF_PAGEOBJECT, std::vector<int>> textChars_;
+    std::map<std::pair<FPDF_FONT, unsigned int>, int> glyphs_;
+    int nextGlyphId_ = 0;
+  };
+
+  bool hasVisibleAnnotations(FPDF_PAGE page)
+  {
+    const int count = FPDFPage_GetAnnotCount(page);
+    for (int i = 0; i < count; i++)
+    {
+      FPDF_ANNOTATION annot = FPDFPage_GetAnnot(page, i);
+      if (!annot)
+        return true;
+      const int subtype = FPDFAnnot_GetSubtype(annot);
+      FPDFPage_CloseAnnot(annot);
+      if (subtype != kAnnotLink && subtype != kAnnotPopup)
+        return true;
+    }
+    return false;
+  }
+
+  // The matrix from the PDF page coordinates to the top-left origin coordinates of the page in points, which is the
+  // same mapping as FPDF_RenderPageBitmap (the page rotation and the crop box origin are taken into account).
+  FS_MATRIX pageMatrix(FPDF_PAGE page)
+  {
+    const double width = FPDF_GetPageWidthF(page);
+    const double height = FPDF_GetPageHeightF(page);
+    // FPDF_DeviceToPage takes integer device coordinates; a large device size keeps the precision
+    const int size = 1 << 20;
+    double x0, y0, x1, y1, x2, y2;
+    FPDF_DeviceToPage(page, 0, 0, size, size, 0, 0, 0, &x0, &y0);
+    FPDF_DeviceToPage(page, 0, 0, size, size, 0, size, 0, &x1, &y1);
+    FPDF_DeviceToPage(page, 0, 0, size, size, 0, 0, size, &x2, &y2);
+    // the page coordinates of the page point (X, Y) are (x0, y0) + X / width * (p1 - p0) + Y / height * (p2 - p0)
+    const double a = (x1 - x0) / width, b = (y1 - y0) / width;
+    const double c = (x2 - x0) / height, d = (y2 - y0) / height;
+    const double det = a * d - b * c;
+    if (det == 0)
+      return kIdentity;
+    const double ia = d / det, ib = -b / det, ic = -c / det, id = a / det;
+    return FS_MATRIX{
+        static_cast<float>(ia),
+        static_cast<float>(ib),
+        static_cast<float>(ic),
+        static_cast<float>(id),
+        static_cast<float>(-(x0 * ia + y0 * ic)),
+        static_cast<float>(-(x0 * ib + y0 * id)),
+    };
+  }
+
+  void writeHeader(PackedWriter &w, FPDF_PAGE page, int flags)
+  {
+    const FS_MATRIX m = pageMatrix(page);
+    w.i32(1); // format version
+    w.i32(flags);
+    for (float v : {m.a, m.b, m.c, m.d, m.e, m.f})
+      w.f32(v);
+  }
+} // namespace
+
+extern "C" EXPORT unsigned char *INTEROP_API pdfrx_page_display_list(pdfrx_page_cache *cache,
+                                                                     FPDF_DOCUMENT doc,
+                                                                     FPDF_PAGE page,
+                                                                     int enableAnnotations,
+                                                                     int64_t maxBytes,
+                                                                     int64_t *size)
+{
+  PackedWriter w;
+  writeHeader(w, page, 0);
+  int flags = enableAnnotations && hasVisibleAnnotations(page) ? PDFRX_DISPLAY_LIST_INCOMPLETE : 0;
+  if (!flags)
+  {
+    FPDF_TEXTPAGE textPage = pdfrx_page_cache_acquire_text(cache, page);
+    DisplayListWriter writer(doc, page, textPage, maxBytes, w);
+    writer.writePage();
+    flags = writer.flags();
+    if (textPage)
+      pdfrx_page_cache_release_text(cache, page, textPage);
+  }
+  if (flags)
+  {
+    // the partial list is useless; the page should be rendered by PDFium
+    PackedWriter header;
+    writeHeader(header, page, flags);
+    header.i32(kOpEnd);
+    return header.detach(size);
+  }
+  w.i32(kOpEnd);
+  return w.detach(size);
+}
@@ -0,0 +1,182 @@
+#include "pdfium_interop.h"
+
+#include <fpdf_doc.h>
+
+#include "pdfrx_mapped_file.h"
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  // XXH64 (https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md); the content is hashed by the fixed
+  // size chunks, so the chunks can be hashed in parallel and the result does not depend on the thread count.
+  const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+  const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+  const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+  const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+  const uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+  inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+  // The chunks are read in the little endian order on all the supported platforms.
+  inline uint64_t read64(const unsigned char *p)
+  {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  inline uint32_t read32(const unsigned char *p)
+  {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  inline uint64_t round(uint64_t acc, uint64_t input)
+  {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+  }
+
+  inline uint64_t mergeRound(uint64_t acc, uint64_t value)
+  {
+    acc ^= round(0, value);
+    return acc * kPrime1 + kPrime4;
+  }
+
+  uint64_t xxh64(const unsigned char *p, size_t size, uint64_t seed)
+  {
+    const unsigned char *const end = p + size;
+    uint64_t hash;
+    if (size >= 32)
+    {
+      uint64_t v1 = seed + kPrime1 + kPrime2;
+      uint64_t v2 = seed + kPrime2;
+      uint64_t v3 = seed;
+      uint64_t v4 = seed - kPrime1;
+      const unsigned char *const limit = end - 32;
+      do
+      {
+        v1 = round(v1, read64(p));
+        v2 = round(v2, read64(p + 8));
+        v3 = round(v3, read64(p + 16));
+        v4 = round(v4, read64(p + 24));
+        p += 32;
+      } while (p <= limit);
+      hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+      hash = mergeRound(hash, v1);
+      hash = mergeRound(hash, v2);
+      hash = mergeRound(hash, v3);
+      hash = mergeRound(hash, v4);
+    }
+    else
+    {
+      hash = seed + kPrime5;
+    }
+    hash += size;
+    for (; p + 8 <= end; p += 8)
+      hash = rotl(hash ^ round(0, read64(p)), 27) * kPrime1 + kPrime4;
+    if (p + 4 <= end)
+    {
+      hash = rotl(hash ^ (read32(p) * kPrime1), 23) * kPrime2 + kPrime3;
+      p += 4;
+    }
+    for (; p < end; p++)
+      hash = rotl(hash ^ (*p * kPrime5), 11) * kPrime1;
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+  }
+
+  void hashChunks(const unsigned char *data, int64_t size, int64_t firstChunkIndex, int threadCount, uint64_t *chunkHashes)
+  {
+    const int64_t chunkCount = (size + PDFRX_FINGERPRINT_CHUNK_SIZE - 1) / PDFRX_FINGERPRINT_CHUNK_SIZE;
+    if (threadCount <= 0)
+      threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = static_cast<int>(std::min<int64_t>(threadCount, chunkCount));
+    std::atomic<int64_t> next(0);
+    auto worker = [&]()
+    {
+      for (int64_t i; (i = next.fetch_add(1)) < chunkCount;)
+      {
+        const int64_t offset = i * PDFRX_FINGERPRINT_CHUNK_SIZE;
+        const size_t length = static_cast<size_t>(std::min<int64_t>(PDFRX_FINGERPRINT_CHUNK_SIZE, size - offset));
+        // the chunk index is the seed so that swapping the chunks changes the result
+        chunkHashes[i] = xxh64(data + offset, length, static_cast<uint64_t>(firstChunkIndex + i));
+      }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++)
+      threads.emplace_back(worker);
+    worker();
+    for (auto &t : threads)
+      t.join();
+  }
+} // namespace
+
+extern "C" EXPORT int64_t INTEROP_API pdfrx_fingerprint_hash_chunks(const unsigned char *data, int64_t size, int64_t firstChunkIndex, int threadCount, uint64_t *chunkHashes)
+{
+  if (size <= 0)
+    return 0;
+  hashChunks(data, size, firstChunkIndex, threadCount, chunkHashes);
+  return (size + PDFRX_FINGERPRINT_CHUNK_SIZE - 1) / PDFRX_FINGERPRINT_CHUNK_SIZE;
+}
+
+extern "C" EXPORT uint64_t INTEROP_API pdfrx_fingerprint_combine(const uint64_t *chunkHashes, int64_t chunkCount, int64_t totalSize, const unsigned char *extra, int extraSize)
+{
+  std::vector<unsigned char> buffer(sizeof(uint64_t) * (chunkCount + 1) + (extraSize > 0 ? extraSize : 0));
+  memcpy(buffer.data(), &totalSize, sizeof(totalSize));
+  if (chunkCount > 0)
+    memcpy(buffer.data() + sizeof(uint64_t), chunkHashes, sizeof(uint64_t) * chunkCount);
+  if (extraSize > 0)
+    memcpy(buffer.data() + sizeof(uint64_t) * (chunkCount + 1), extra, extraSize);
+  return xxh64(buffer.data(), buffer.size(), 0);
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_fingerprint_file(const char *path, int threadCount, const unsigned char *extra, int extraSize, uint64_t *hash, int64_t *size)
+{
+  // every thread reads its chunks sequentially
+  pdfrx::MappedFile file(path, pdfrx::MappedFile::kSequential);
+  if (!file.valid())
+    return -1;
+  const int64_t chunkCount = (file.size() + PDFRX_FINGERPRINT_CHUNK_SIZE - 1) / PDFRX_FINGERPRINT_CHUNK_SIZE;
+  std::vector<uint64_t> chunkHashes(static_cast<size_t>(chunkCount));
+  if (chunkCount > 0)
+    hashChunks(file.data(), file.size(), 0, threadCount, chunkHashes.data());
+  *hash = pdfrx_fingerprint_combine(chunkHashes.data(), chunkCount, file.size(), extra, extraSize);
+  *size = file.size();
+  return 0;
+}
+
+extern "C" EXPORT int64_t INTEROP_API pdfrx_fingerprint_file_chunks(const char *path, int threadCount, uint64_t *chunkHashes, int64_t maxChunks, int64_t *size)
+{
+  pdfrx::MappedFile file(path, pdfrx::MappedFile::kSequential);
+  if (!file.valid())
+    return -1;
+  const int64_t chunkCount = (file.size() + PDFRX_FINGERPRINT_CHUNK_SIZE - 1) / PDFRX_FINGERPRINT_CHUNK_SIZE;
+  *size = file.size();
+  // the file may grow after the caller estimates the chunk count from its size
+  if (chunkCount > 0 && chunkCount <= maxChunks)
+    hashChunks(file.data(), file.size(), 0, threadCount, chunkHashes);
+  return chunkCount;
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_fingerprint_file_identifier(FPDF_DOCUMENT doc, unsigned char *buffer, int length)
+{
+  // the identifier is a byte string terminated by NUL
+  const unsigned long bytes = FPDF_GetFileIdentifier(doc, FILEIDTYPE_PERMANENT, nullptr, 0);
+  if (bytes <= 1)
+    return 0;
+  if (buffer && length >= static_cast<int>(bytes))
+    FPDF_GetFileIdentifier(doc, FILEIDTYPE_PERMANENT, buffer, bytes);
+  return static_cast<int>(bytes - 1);
+}
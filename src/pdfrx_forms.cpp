@@ -0,0 +1,223 @@
+#include "pdfium_interop.h"
+
+#include <fpdf_annot.h>
+#include <fpdf_formfill.h>
+
+#include "pdfrx_packed_buffer.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+  using pdfrx::PackedReader;
+  using pdfrx::PackedWriter;
+
+  const int kAnnotWidget = 20; // FPDF_ANNOT_WIDGET
+
+  enum UpdateKind
+  {
+    kUpdateText = 0,
+    kUpdateChecked = 1,
+    kUpdateSelect = 2,
+  };
+
+  struct Update
+  {
+    int kind;
+    int intValue;
+    int widgetIndex;
+    std::vector<unsigned short> text;
+  };
+
+  // The form-fill environment is only needed during the call; the values (and the appearance streams regenerated
+  // by the form-fill module) are stored to the document.
+  class FormEnvironment
+  {
+  public:
+    explicit FormEnvironment(FPDF_DOCUMENT doc)
+    {
+      memset(&info_, 0, sizeof(info_));
+      info_.version = 1;
+      handle_ = FPDFDOC_InitFormFillEnvironment(doc, &info_);
+    }
+    ~FormEnvironment()
+    {
+      if (handle_)
+        FPDFDOC_ExitFormFillEnvironment(handle_);
+    }
+    FPDF_FORMHANDLE handle() const { return handle_; }
+
+  private:
+    FPDF_FORMFILLINFO info_;
+    FPDF_FORMHANDLE handle_;
+  };
+
+  std::u16string fieldName(FPDF_FORMHANDLE form, FPDF_ANNOTATION annot)
+  {
+    const unsigned long bytes = FPDFAnnot_GetFormFieldName(form, annot, nullptr, 0);
+    if (bytes <= 2)
+      return std::u16string();
+    std::vector<FPDF_WCHAR> buffer(bytes / 2);
+    FPDFAnnot_GetFormFieldName(form, annot, buffer.data(), bytes);
+    return std::u16string(buffer.begin(), buffer.end() - 1);
+  }
+
+  void writeField(PackedWriter &w, FPDF_FORMHANDLE form, FPDF_ANNOTATION annot, int pageIndex, int annotIndex)
+  {
+    const int type = FPDFAnnot_GetFormFieldType(form, annot);
+    w.i32(pageIndex);
+    w.i32(annotIndex);
+    w.i32(type);
+    w.i32(FPDFAnnot_GetFormFieldFlags(form, annot));
+    FS_RECTF rect = {};
+    FPDFAnnot_GetRect(annot, &rect);
+    w.f32(rect.left);
+    w.f32(rect.top);
+    w.f32(rect.right);
+    w.f32(rect.bottom);
+    const bool checkable = type == FPDF_FORMFIELD_CHECKBOX || type == FPDF_FORMFIELD_RADIOBUTTON;
+    w.i32(checkable ? (FPDFAnnot_IsChecked(form, annot) ? 1 : 0) : -1);
+    w.utf16([&](FPDF_WCHAR *buffer, unsigned long length)
+            { return FPDFAnnot_GetFormFieldName(form, annot, buffer, length); });
+    w.utf16([&](FPDF_WCHAR *buffer, unsigned long length)
+            { return FPDFAnnot_GetFormFieldValue(form, annot, buffer, length); });
+    const int optionCount = type == FPDF_FORMFIELD_COMBOBOX || type == FPDF_FORMFIELD_LISTBOX ? FPDFAnnot_GetOptionCount(form, annot) : 0;
+    w.i32(optionCount > 0 ? optionCount : 0);
+    for (int i = 0; i < optionCount; i++)
+    {
+      w.i32(FPDFAnnot_IsOptionSelected(form, annot, i) ? 1 : 0);
+      w.utf16([&](FPDF_WCHAR *buffer, unsigned long length)
+              { return FPDFAnnot_GetOptionLabel(form, annot, i, buffer, length); });
+    }
+  }
+
+  bool applyUpdate(FPDF_FORMHANDLE form, FPDF_PAGE page, FPDF_ANNOTATION annot, const Update &update)
+  {
+    const int type = FPDFAnnot_GetFormFieldType(form, annot);
+    switch (update.kind)
+    {
+    case kUpdateText:
+      if (type != FPDF_FORMFIELD_TEXTFIELD && type != FPDF_FORMFIELD_COMBOBOX)
+        return false;
+      if (!FORM_SetFocusedAnnot(form, annot))
+        return false;
+      FORM_SelectAllText(form, page);
+      FORM_ReplaceSelection(form, page, update.text.data());
+      break;
+    case kUpdateChecked:
+      if (type != FPDF_FORMFIELD_CHECKBOX && type != FPDF_FORMFIELD_RADIOBUTTON)
+        return false;
+      if ((FPDFAnnot_IsChecked(form, annot) != 0) == (update.intValue != 0))
+        return true;
+      // radio buttons cannot be unchecked directly; check another one in the group instead
+      if (type == FPDF_FORMFIELD_RADIOBUTTON && update.intValue == 0)
+        return false;
+      if (!FORM_SetFocusedAnnot(form, annot))
+        return false;
+      FORM_OnChar(form, page, ' ', 0);
+      break;
+    case kUpdateSelect:
+      if (type != FPDF_FORMFIELD_COMBOBOX && type != FPDF_FORMFIELD_LISTBOX)
+        return false;
+      if (!FORM_SetFocusedAnnot(form, annot))
+        return false;
+      FORM_SetIndexSelected(form, page, update.intValue, true);
+      break;
+    default:
+      return false;
+    }
+    // committing the value
+    FORM_ForceToKillFocus(form);
+    return true;
+  }
+} // namespace
+
+extern "C" EXPORT unsigned char *INTEROP_API pdfrx_form_fields_snapshot(FPDF_DOCUMENT doc, FPDF_PAGE *pages, int pageCount, int64_t *size)
+{
+  FormEnvironment env(doc);
+  PackedWriter w;
+  w.i32(1); // format version
+  if (env.handle())
+  {
+    for (int i = 0; i < pageCount; i++)
+    {
+      const int count = FPDFPage_GetAnnotCount(pages[i]);
+      for (int j = 0; j < count; j++)
+      {
+        FPDF_ANNOTATION annot = FPDFPage_GetAnnot(pages[i], j);
+        if (!annot)
+          continue;
+        if (FPDFAnnot_GetSubtype(annot) == kAnnotWidget)
+          writeField(w, env.handle(), annot, i, j);
+        FPDFPage_CloseAnnot(annot);
+      }
+    }
+  }
+  w.i32(-1); // terminator (page index)
+  return w.detach(size);
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_form_fields_update(FPDF_DOCUMENT doc, FPDF_PAGE *pages, int pageCount, const unsigned char *updates, int64_t size)
+{
+  PackedReader r(updates, size);
+  if (r.i32() != 1)
+    return -1;
+  const int updateCount = r.i32();
+  std::unordered_map<std::u16string, std::vector<Update>> updatesByName;
+  for (int i = 0; i < updateCount && r.ok(); i++)
+  {
+    Update update;
+    update.kind = r.i32();
+    update.intValue = r.i32();
+    update.widgetIndex = r.i32();
+    const auto name = r.utf16();
+    update.text = r.utf16();
+    updatesByName[std::u16string(name.begin(), name.end() - 1)].push_back(std::move(update));
+  }
+  if (!r.ok())
+    return -1;
+
+  FormEnvironment env(doc);
+  if (!env.handle())
+    return -1;
+  int applied = 0;
+  std::unordered_map<std::u16string, int> widgetIndices;
+  for (int i = 0; i < pageCount && !updatesByName.empty(); i++)
+  {
+    bool pageLoaded = false;
+    const int count = FPDFPage_GetAnnotCount(pages[i]);
+    for (int j = 0; j < count; j++)
+    {
+      FPDF_ANNOTATION annot = FPDFPage_GetAnnot(pages[i], j);
+      if (!annot)
+        continue;
+      if (FPDFAnnot_GetSubtype(annot) == kAnnotWidget)
+      {
+        const auto name = fieldName(env.handle(), annot);
+        auto it = updatesByName.find(name);
+        if (it != updatesByName.end())
+        {
+          const int widgetIndex = widgetIndices[name]++;
+          if (!pageLoaded)
+          {
+            FORM_OnAfterLoadPage(pages[i], env.handle());
+            pageLoaded = true;
+          }
+          for (const auto &update : it->second)
+          {
+            if (update.widgetIndex >= 0 && update.widgetIndex != widgetIndex)
+              continue;
+            if (applyUpdate(env.handle(), pages[i], annot, update))
+              applied++;
+          }
+        }
+      }
+      FPDFPage_CloseAnnot(annot);
+    }
+    if (pageLoaded)
+      FORM_OnBeforeClosePage(pages[i], env.handle());
+  }
+  return applied;
+}
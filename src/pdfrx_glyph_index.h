@@ -0,0 +1,147 @@
+#ifndef PDFRX_GLYPH_INDEX_H
+#define PDFRX_GLYPH_INDEX_H
+
+// Spatial index of the character boxes of a text page to find the characters within a rectangle without
+// scanning the whole page; the boxes are bucketed into a uniform grid of about 4 characters per cell.
+
+#include "pdfium_interop.h"
+
+#include <fpdf_text.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace pdfrx
+{
+  class GlyphIndex
+  {
+  public:
+    struct Box
+    {
+      float left, top, right, bottom;
+    };
+
+    explicit GlyphIndex(FPDF_TEXTPAGE textPage)
+    {
+      const int count = FPDFText_CountChars(textPage);
+      boxes_.resize(count > 0 ? count : 0, Box{1, 0, 0, 1}); // invalid (empty) box for the characters without box
+      double minX = 0, minY = 0, maxX = 0, maxY = 0;
+      int valid = 0;
+      for (int i = 0; i < count; i++)
+      {
+        double left, right, bottom, top;
+        if (!FPDFText_GetCharBox(textPage, i, &left, &right, &bottom, &top) || right < left || top < bottom)
+          continue;
+        boxes_[i] = Box{static_cast<float>(left), static_cast<float>(top), static_cast<float>(right), static_cast<float>(bottom)};
+        minX = valid ? std::min(minX, left) : left;
+        minY = valid ? std::min(minY, bottom) : bottom;
+        maxX = valid ? std::max(maxX, right) : right;
+        maxY = valid ? std::max(maxY, top) : top;
+        valid++;
+      }
+      if (valid == 0)
+        return;
+
+      const double width = std::max(maxX - minX, 1.0);
+      const double height = std::max(maxY - minY, 1.0);
+      const double cells = std::max(1.0, valid / 4.0);
+      cols_ = std::max(1, std::min(1024, static_cast<int>(std::sqrt(cells * width / height))));
+      rows_ = std::max(1, std::min(1024, static_cast<int>(cells / cols_)));
+      left_ = minX;
+      bottom_ = minY;
+      cellWidth_ = width / cols_;
+      cellHeight_ = height / rows_;
+
+      // two passes to store the cells in a flat array (CSR)
+      cellStarts_.assign(static_cast<size_t>(cols_) * rows_ + 1, 0);
+      forEachCell([&](int cell, int)
+                  { cellStarts_[cell + 1]++; });
+      for (size_t i = 1; i < cellStarts_.size(); i++)
+        cellStarts_[i] += cellStarts_[i - 1];
+      cellChars_.resize(cellStarts_.back());
+      std::vector<int> fill(cellStarts_.begin(), cellStarts_.end() - 1);
+      forEachCell([&](int cell, int index)
+                  { cellChars_[fill[cell]++] = index; });
+    }
+
+    int charCount() const { return static_cast<int>(boxes_.size()); }
+
+    // The box of the character in PDF page coordinates; left > right if the character has no box.
+    const Box &box(int index) const { return boxes_[index]; }
+
+    // Append the indices of the characters whose boxes intersect the rectangle (PDF page coordinates, top > bottom)
+    // to result in the ascending order.
+    void query(double left, double top, double right, double bottom, std::vector<int> &result) const
+    {
+      if (cellStarts_.empty() || right < left || top < bottom)
+        return;
+      int c0, r0, c1, r1;
+      cellRange(left, top, right, bottom, c0, r0, c1, r1);
+      const size_t first = result.size();
+      for (int r = r0; r <= r1; r++)
+      {
+        for (int c = c0; c <= c1; c++)
+        {
+          const int cell = r * cols_ + c;
+          for (int i = cellStarts_[cell]; i < cellStarts_[cell + 1]; i++)
+          {
+            const Box &b = boxes_[cellChars_[i]];
+            if (b.left <= right && b.right >= left && b.bottom <= top && b.top >= bottom)
+              result.push_back(cellChars_[i]);
+          }
+        }
+      }
+      // the characters spanning multiple cells are found more than once
+      std::sort(result.begin() + first, result.end());
+      result.erase(std::unique(result.begin() + first, result.end()), result.end());
+    }
+
+    int64_t bytes() const
+    {
+      return static_cast<int64_t>(sizeof(*this) + boxes_.size() * sizeof(Box) + (cellStarts_.size() + cellChars_.size()) * sizeof(int));
+    }
+
+  private:
+    void cellRange(double left, double top, double right, double bottom, int &c0, int &r0, int &c1, int &r1) const
+    {
+      auto clampCol = [&](double x)
+      { return std::max(0, std::min(cols_ - 1, static_cast<int>(std::floor((x - left_) / cellWidth_)))); };
+      auto clampRow = [&](double y)
+      { return std::max(0, std::min(rows_ - 1, static_cast<int>(std::floor((y - bottom_) / cellHeight_)))); };
+      c0 = clampCol(left);
+      c1 = clampCol(right);
+      r0 = clampRow(bottom);
+      r1 = clampRow(top);
+    }
+
+    template <typename F>
+    void forEachCell(F f) const
+    {
+      for (int i = 0; i < charCount(); i++)
+      {
+        const Box &b = boxes_[i];
+        if (b.left > b.right)
+          continue;
+        int c0, r0, c1, r1;
+        cellRange(b.left, b.top, b.right, b.bottom, c0, r0, c1, r1);
+        for (int r = r0; r <= r1; r++)
+          for (int c = c0; c <= c1; c++)
+            f(r * cols_ + c, i);
+      }
+    }
+
+    std::vector<Box> boxes_;
+    double left_ = 0, bottom_ = 0, cellWidth_ = 1, cellHeight_ = 1;
+    int cols_ = 0, rows_ = 0;
+    std::vector<int> cellStarts_;
+    std::vector<int> cellChars_;
+  };
+
+  // Returns the glyph index of the text page acquired by pdfrx_page_cache_acquire_text; it is kept along with the
+  // text page if the page is in the cache, otherwise built for the call.
+  std::shared_ptr<const GlyphIndex> acquireGlyphIndex(pdfrx_page_cache *cache, FPDF_PAGE page, FPDF_TEXTPAGE textPage);
+} // namespace pdfrx
+
+#endif // PDFRX_GLYPH_INDEX_H
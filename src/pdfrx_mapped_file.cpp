@@ -0,0 +1,35 @@
+#include "pdfium_interop.h"
+
+#include "pdfrx_mapped_file.h"
+
+struct pdfrx_mapped_file : pdfrx::MappedFile
+{
+  using MappedFile::MappedFile;
+};
+
+extern "C" EXPORT pdfrx_mapped_file *INTEROP_API pdfrx_mapped_file_open(const char *path)
+{
+  auto *file = new pdfrx_mapped_file(path, pdfrx::MappedFile::kNormal);
+  // empty files are not PDF anyway
+  if (!file->data())
+  {
+    delete file;
+    return nullptr;
+  }
+  return file;
+}
+
+extern "C" EXPORT const unsigned char *INTEROP_API pdfrx_mapped_file_data(pdfrx_mapped_file *file)
+{
+  return file->data();
+}
+
+extern "C" EXPORT int64_t INTEROP_API pdfrx_mapped_file_size(pdfrx_mapped_file *file)
+{
+  return file->size();
+}
+
+extern "C" EXPORT void INTEROP_API pdfrx_mapped_file_close(pdfrx_mapped_file *file)
+{
+  delete file;
+}
@@ -0,0 +1,122 @@
+#ifndef PDFRX_MAPPED_FILE_H
+#define PDFRX_MAPPED_FILE_H
+
+// Read-only memory mapping of a whole file specified by a UTF-8 path.
+
+#include <stdint.h>
+#include <vector>
+
+#if defined(_WIN32)
+// std::min/std::max of the including files should not be broken by the macros
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pdfrx
+{
+  class MappedFile
+  {
+  public:
+    enum Access
+    {
+      kNormal,
+      kSequential, // read through from the beginning; the kernel reads ahead aggressively
+    };
+
+    MappedFile(const char *utf8Path, Access access)
+    {
+#if defined(_WIN32)
+      const int length = MultiByteToWideChar(CP_UTF8, 0, utf8Path, -1, nullptr, 0);
+      if (length <= 0)
+        return;
+      std::vector<wchar_t> path(length);
+      MultiByteToWideChar(CP_UTF8, 0, utf8Path, -1, path.data(), length);
+      file_ = CreateFileW(path.data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, access == kSequential ? FILE_FLAG_SEQUENTIAL_SCAN : 0, nullptr);
+      if (file_ == INVALID_HANDLE_VALUE)
+        return;
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(file_, &fileSize))
+        return;
+      size_ = fileSize.QuadPart;
+      valid_ = true;
+      if (size_ == 0)
+        return;
+      mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping_)
+        data_ = static_cast<const unsigned char *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+      valid_ = data_ != nullptr;
+#else
+      fd_ = open(utf8Path, O_RDONLY);
+      if (fd_ < 0)
+        return;
+      struct stat st;
+      if (fstat(fd_, &st) != 0)
+        return;
+      size_ = st.st_size;
+      valid_ = true;
+      if (size_ == 0)
+        return;
+      void *p = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE, fd_, 0);
+      if (p == MAP_FAILED)
+      {
+        valid_ = false;
+        return;
+      }
+      if (access == kSequential)
+      {
+        madvise(p, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+        madvise(p, static_cast<size_t>(size_), MADV_WILLNEED);
+      }
+      data_ = static_cast<const unsigned char *>(p);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#if defined(_WIN32)
+      if (data_)
+        UnmapViewOfFile(data_);
+      if (mapping_)
+        CloseHandle(mapping_);
+      if (file_ != INVALID_HANDLE_VALUE)
+        CloseHandle(file_);
+#else
+      if (data_)
+        munmap(const_cast<unsigned char *>(data_), static_cast<size_t>(size_));
+      if (fd_ >= 0)
+        close(fd_);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Whether the file is opened; an empty file is valid but has no data.
+    bool valid() const { return valid_; }
+    const unsigned char *data() const { return data_; }
+    int64_t size() const { return size_; }
+
+  private:
+#if defined(_WIN32)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    const unsigned char *data_ = nullptr;
+    int64_t size_ = 0;
+    bool valid_ = false;
+  };
+} // namespace pdfrx
+
+#endif // PDFRX_MAPPED_FILE_H
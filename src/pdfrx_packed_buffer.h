@@ -0,0 +1,132 @@
+#ifndef PDFRX_PACKED_BUFFER_H
+#define PDFRX_PACKED_BUFFER_H
+
+// Packed buffers exchanged with the Dart side in a single FFI call.
+//
+// Every item is 4-byte aligned in the host byte order so that the Dart side can read/write it with ByteData
+// directly; strings are UTF-16 (length in code units followed by the code units padded to 4 bytes).
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace pdfrx
+{
+  class PackedWriter
+  {
+  public:
+    void i32(int32_t value) { append(&value, sizeof(value)); }
+    void f32(float value) { append(&value, sizeof(value)); }
+
+    void utf16(const unsigned short *str, int32_t length)
+    {
+      i32(length);
+      append(str, static_cast<size_t>(length) * 2);
+      if (length & 1)
+        append("\0\0", 2);
+    }
+
+    // Raw bytes padded to 4 bytes; the length is not written.
+    void bytes(const void *p, size_t size)
+    {
+      append(p, size);
+      static const unsigned char kPadding[3] = {};
+      if (size & 3)
+        append(kPadding, 4 - (size & 3));
+    }
+
+    size_t size() const { return data_.size(); }
+
+    // Write a string obtained by PDFium's "returns bytes including NUL if buffer is null" style function.
+    template <typename F>
+    void utf16(F getString)
+    {
+      const unsigned long bytes = getString(nullptr, 0);
+      if (bytes <= 2)
+      {
+        i32(0);
+        return;
+      }
+      std::vector<unsigned short> buffer(bytes / 2);
+      getString(buffer.data(), bytes);
+      utf16(buffer.data(), static_cast<int32_t>(buffer.size() - 1)); // without the terminating NUL
+    }
+
+    // Returns the buffer allocated by malloc (released by pdfrx_free) and stores its size.
+    unsigned char *detach(int64_t *size)
+    {
+      unsigned char *result = static_cast<unsigned char *>(malloc(data_.empty() ? 1 : data_.size()));
+      if (!result)
+      {
+        *size = 0;
+        return nullptr;
+      }
+      memcpy(result, data_.data(), data_.size());
+      *size = static_cast<int64_t>(data_.size());
+      return result;
+    }
+
+  private:
+    void append(const void *p, size_t size)
+    {
+      const unsigned char *b = static_cast<const unsigned char *>(p);
+      data_.insert(data_.end(), b, b + size);
+    }
+
+    std::vector<unsigned char> data_;
+  };
+
+  class PackedReader
+  {
+  public:
+    PackedReader(const unsigned char *data, int64_t size) : data_(data), size_(size) {}
+
+    bool ok() const { return ok_; }
+
+    int32_t i32()
+    {
+      int32_t value = 0;
+      read(&value, sizeof(value));
+      return value;
+    }
+
+    // NUL-terminated UTF-16 string
+    std::vector<unsigned short> utf16()
+    {
+      const int32_t length = i32();
+      if (!ok_ || length < 0 || static_cast<int64_t>(length) * 2 > size_ - pos_)
+      {
+        ok_ = false;
+        return std::vector<unsigned short>(1, 0);
+      }
+      std::vector<unsigned short> str(length + 1, 0);
+      if (length > 0)
+      {
+        read(str.data(), static_cast<size_t>(length) * 2);
+        if (length & 1)
+          pos_ += 2;
+      }
+      return str;
+    }
+
+  private:
+    void read(void *p, size_t size)
+    {
+      if (!ok_ || pos_ + static_cast<int64_t>(size) > size_)
+      {
+        ok_ = false;
+        return;
+      }
+      memcpy(p, data_ + pos_, size);
+      pos_ += size;
+    }
+
+    const unsigned char *data_;
+    int64_t size_;
+    int64_t pos_ = 0;
+    bool ok_ = true;
+  };
+} // namespace pdfrx
+
+#endif // PDFRX_PACKED_BUFFER_H
@@ -0,0 +1,187 @@
+#include "pdfium_interop.h"
+
+#include <fpdf_text.h>
+
+#include "pdfrx_glyph_index.h"
+
+#include <iterator>
+#include <list>
+#include <unordered_map>
+
+// The calls on a cache are serialized by the owner document (its worker), so the cache has no lock.
+struct pdfrx_page_cache
+{
+  struct Entry
+  {
+    FPDF_TEXTPAGE textPage;
+    int64_t bytes;
+    int refCount;
+    uint64_t generation; // the prepare call that loaded/touched the entry
+    std::list<FPDF_PAGE>::iterator lru;
+    std::shared_ptr<const pdfrx::GlyphIndex> glyphIndex; // built on the first region query
+  };
+
+  std::unordered_map<FPDF_PAGE, Entry> entries;
+  std::list<FPDF_PAGE> lru; // most recently used first
+  int64_t budget;
+  int64_t used = 0;
+  uint64_t generation = 0;
+
+  explicit pdfrx_page_cache(int64_t budget) : budget(budget) {}
+
+  ~pdfrx_page_cache()
+  {
+    for (auto &e : entries)
+      FPDFText_ClosePage(e.second.textPage);
+  }
+
+  Entry *find(FPDF_PAGE page)
+  {
+    auto it = entries.find(page);
+    if (it == entries.end())
+      return nullptr;
+    lru.splice(lru.begin(), lru, it->second.lru);
+    return &it->second;
+  }
+
+  Entry *insert(FPDF_PAGE page, FPDF_TEXTPAGE textPage)
+  {
+    lru.push_front(page);
+    // the text page keeps the character info (~100 bytes each) and the segment tables
+    const int64_t bytes = 1024 + static_cast<int64_t>(FPDFText_CountChars(textPage)) * 112;
+    used += bytes;
+    return &(entries[page] = Entry{textPage, bytes, 0, 0, lru.begin(), nullptr});
+  }
+
+  void erase(FPDF_PAGE page)
+  {
+    auto it = entries.find(page);
+    if (it == entries.end())
+      return;
+    FPDFText_ClosePage(it->second.textPage);
+    used -= it->second.bytes;
+    lru.erase(it->second.lru);
+    entries.erase(it);
+  }
+
+  // Evict the least recently used entries not in use (nor prepared by the prepare call of keepGeneration) until the
+  // cache fits in the budget; returns whether it fits.
+  bool trim(uint64_t keepGeneration = 0)
+  {
+    auto it = lru.end();
+    while (used > budget && it != lru.begin())
+    {
+      const auto victim = std::prev(it);
+      const Entry &e = entries.at(*victim);
+      if (e.refCount > 0 || (keepGeneration != 0 && e.generation == keepGeneration))
+      {
+        it = victim;
+        continue;
+      }
+      erase(*victim);
+    }
+    return used <= budget;
+  }
+};
+
+extern "C" EXPORT pdfrx_page_cache *INTEROP_API pdfrx_page_cache_create(int64_t budgetBytes)
+{
+  return new pdfrx_page_cache(budgetBytes);
+}
+
+extern "C" EXPORT void INTEROP_API pdfrx_page_cache_destroy(pdfrx_page_cache *cache)
+{
+  delete cache;
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_page_cache_prepare(pdfrx_page_cache *cache, FPDF_PAGE *pages, int pageCount, int loadText, int64_t budgetBytes)
+{
+  cache->budget = budgetBytes;
+  // FPDF_LoadPage has already parsed the page content; the text page (character analysis) is what remains
+  if (!loadText)
+  {
+    cache->trim();
+    return 0;
+  }
+  const uint64_t generation = ++cache->generation;
+  int prepared = 0;
+  for (int i = 0; i < pageCount; i++)
+  {
+    if (auto *e = cache->find(pages[i]))
+    {
+      e->generation = generation;
+      continue;
+    }
+    FPDF_TEXTPAGE textPage = FPDFText_LoadPage(pages[i]);
+    if (!textPage)
+      continue;
+    cache->insert(pages[i], textPage)->generation = generation;
+    if (!cache->trim(generation))
+    {
+      // the farther pages do not fit either
+      cache->erase(pages[i]);
+      break;
+    }
+    prepared++;
+  }
+  cache->trim();
+  return prepared;
+}
+
+extern "C" EXPORT FPDF_TEXTPAGE INTEROP_API pdfrx_page_cache_acquire_text(pdfrx_page_cache *cache, FPDF_PAGE page)
+{
+  if (!cache)
+    return FPDFText_LoadPage(page);
+  auto *e = cache->find(page);
+  if (!e)
+  {
+    FPDF_TEXTPAGE textPage = FPDFText_LoadPage(page);
+    if (!textPage)
+      return nullptr;
+    e = cache->insert(page, textPage);
+  }
+  e->refCount++;
+  return e->textPage;
+}
+
+extern "C" EXPORT void INTEROP_API pdfrx_page_cache_release_text(pdfrx_page_cache *cache, FPDF_PAGE page, FPDF_TEXTPAGE textPage)
+{
+  if (!cache)
+  {
+    FPDFText_ClosePage(textPage);
+    return;
+  }
+  auto it = cache->entries.find(page);
+  if (it == cache->entries.end() || it->second.textPage != textPage)
+  {
+    FPDFText_ClosePage(textPage);
+    return;
+  }
+  it->second.refCount--;
+  cache->trim();
+}
+
+extern "C" EXPORT int64_t INTEROP_API pdfrx_page_cache_used_bytes(pdfrx_page_cache *cache)
+{
+  return cache->used;
+}
+
+std::shared_ptr<const pdfrx::GlyphIndex> pdfrx::acquireGlyphIndex(pdfrx_page_cache *cache, FPDF_PAGE page, FPDF_TEXTPAGE textPage)
+{
+  if (cache)
+  {
+    auto it = cache->entries.find(page);
+    if (it != cache->entries.end() && it->second.textPage == textPage)
+    {
+      auto &e = it->second;
+      if (!e.glyphIndex)
+      {
+        e.glyphIndex = std::make_shared<const GlyphIndex>(textPage);
+        e.bytes += e.glyphIndex->bytes();
+        cache->used += e.glyphIndex->bytes();
+      }
+      return e.glyphIndex;
+    }
+  }
+  return std::make_shared<const GlyphIndex>(textPage);
+}
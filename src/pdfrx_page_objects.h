@@ -0,0 +1,47 @@
+#ifndef PDFRX_PAGE_OBJECTS_H
+#define PDFRX_PAGE_OBJECTS_H
+
+// Helpers to walk the page objects, shared by the display list and the reflow.
+
+#include <fpdf_edit.h>
+
+namespace pdfrx
+{
+  // Form XObjects nested deeper than this are not walked (a malformed document may even nest them cyclically).
+  const int kMaxFormDepth = 32;
+
+  // m then n
+  inline FS_MATRIX concat(const FS_MATRIX &m, const FS_MATRIX &n)
+  {
+    return FS_MATRIX{
+        m.a * n.a + m.b * n.c,
+        m.a * n.b + m.b * n.d,
+        m.c * n.a + m.d * n.c,
+        m.c * n.b + m.d * n.d,
+        m.e * n.a + m.f * n.c + n.e,
+        m.e * n.b + m.f * n.d + n.f,
+    };
+  }
+
+  // Calls visit(obj, matrix, depth) for each object of the form XObject at depth; parent maps the content containing
+  // the form to the page and matrix maps the form content to the page. The walk stops when visit returns false.
+  //
+  // Returns false without visiting anything if the form is nested too deeply or its matrix is not available.
+  template <typename Visit>
+  bool visitFormObjects(FPDF_PAGEOBJECT form, const FS_MATRIX &parent, int depth, Visit visit)
+  {
+    FS_MATRIX m;
+    if (depth >= kMaxFormDepth || !FPDFPageObj_GetMatrix(form, &m))
+      return false;
+    const FS_MATRIX formMatrix = concat(m, parent);
+    const int count = FPDFFormObj_CountObjects(form);
+    for (int i = 0; i < count; i++)
+    {
+      if (!visit(FPDFFormObj_GetObject(form, i), formMatrix, depth + 1))
+        break;
+    }
+    return true;
+  }
+} // namespace pdfrx
+
+#endif // PDFRX_PAGE_OBJECTS_H
@@ -0,0 +1,351 @@
+#include "pdfium_interop.h"
+
+#include <fpdf_edit.h>
+#include <fpdf_text.h>
+
+#include "pdfrx_packed_buffer.h"
+#include "pdfrx_page_objects.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+  using pdfrx::PackedWriter;
+
+  const int kFontFixedPitch = 1; // PDF font descriptor flags
+  const int kFontSerif = 2;
+  const int kFontItalic = 64;
+
+  enum BlockKind
+  {
+    kBlockEnd = -1,
+    kBlockParagraph = 0, // rect, run count, runs (font size, weight, PDFRX_REFLOW_RUN_* flags, text)
+    kBlockFigure = 1,    // rect
+  };
+
+  struct Rect
+  {
+    double left, top, right, bottom;
+
+    bool contains(double x, double y) const { return x >= left && x <= right && y >= bottom && y <= top; }
+    void add(const Rect &r)
+    {
+      left = std::min(left, r.left);
+      top = std::max(top, r.top);
+      right = std::max(right, r.right);
+      bottom = std::min(bottom, r.bottom);
+    }
+    bool intersects(const Rect &r) const { return left <= r.right && right >= r.left && bottom <= r.top && top >= r.bottom; }
+  };
+
+  struct Run
+  {
+    float fontSize;
+    int weight;
+    int flags;
+    std::vector<unsigned short> text;
+  };
+
+  struct Paragraph
+  {
+    Rect rect;
+    std::vector<Run> runs;
+  };
+
+  Rect transformBounds(float left, float bottom, float right, float top, const FS_MATRIX &m)
+  {
+    const float xs[] = {left, right, left, right};
+    const float ys[] = {bottom, bottom, top, top};
+    Rect r = {INFINITY, -INFINITY, -INFINITY, INFINITY};
+    for (int i = 0; i < 4; i++)
+    {
+      const double x = m.a * xs[i] + m.c * ys[i] + m.e;
+      const double y = m.b * xs[i] + m.d * ys[i] + m.f;
+      r.add(Rect{x, y, x, y});
+    }
+    return r;
+  }
+
+  const FS_MATRIX kIdentity = {1, 0, 0, 1, 0, 0};
+
+  bool formHasText(FPDF_PAGEOBJECT form, int depth)
+  {
+    bool found = false;
+    pdfrx::visitFormObjects(form, kIdentity, depth, [&](FPDF_PAGEOBJECT obj, const FS_MATRIX &, int childDepth)
+                            {
+                              const int type = FPDFPageObj_GetType(obj);
+                              found = type == FPDF_PAGEOBJ_TEXT ||
+                                      (type == FPDF_PAGEOBJ_FORM && formHasText(obj, childDepth));
+                              return !found; });
+    return found;
+  }
+
+  // Images and the form XObjects without text (vector figures/charts) are figures; the forms with text are
+  // searched for images instead. The children of a form are in the form space; parent maps it to the page.
+  void collectFigures(FPDF_PAGEOBJECT obj, const FS_MATRIX &parent, int depth, std::vector<Rect> &figures)
+  {
+    const int type = FPDFPageObj_GetType(obj);
+    if (type != FPDF_PAGEOBJ_IMAGE && type != FPDF_PAGEOBJ_FORM)
+      return;
+    if (type == FPDF_PAGEOBJ_FORM && formHasText(obj, depth))
+    {
+      pdfrx::visitFormObjects(obj, parent, depth, [&](FPDF_PAGEOBJECT child, const FS_MATRIX &m, int childDepth)
+                              {
+                                collectFigures(child, m, childDepth, figures);
+                                return true; });
+      return;
+    }
+    float left, bottom, right, top;
+    if (!FPDFPageObj_GetBounds(obj, &left, &bottom, &right, &top))
+      return;
+    figures.push_back(transformBounds(left, bottom, right, top, parent));
+  }
+
+  // The figures too small to read (bullets, rules) or covering most of the page (backgrounds, scanned pages whose
+  // text is on an invisible OCR layer) are dropped, and the overlapping ones are merged.
+  std::vector<Rect> pageFigures(FPDF_PAGE page)
+  {
+    const double pageArea = FPDF_GetPageWidthF(page) * FPDF_GetPageHeightF(page);
+    std::vector<Rect> candidates;
+    const int count = FPDFPage_CountObjects(page);
+    for (int i = 0; i < count; i++)
+      collectFigures(FPDFPage_GetObject(page, i), kIdentity, 0, candidates);
+
+    std::vector<Rect> figures;
+    for (const auto &r : candidates)
+    {
+      const double width = r.right - r.left, height = r.top - r.bottom;
+      if (width < 16 || height < 16 || width * height > pageArea * 0.8)
+        continue;
+      figures.push_back(r);
+    }
+    for (bool merged = true; merged;)
+    {
+      merged = false;
+      for (size_t i = 0; i < figures.size() && !merged; i++)
+      {
+        for (size_t j = i + 1; j < figures.size(); j++)
+        {
+          if (figures[i].intersects(figures[j]))
+          {
+            figures[i].add(figures[j]);
+            figures.erase(figures.begin() + j);
+            merged = true;
+            break;
+          }
+        }
+      }
+    }
+    std::sort(figures.begin(), figures.end(), [](const Rect &a, const Rect &b)
+              { return a.top > b.top; });
+    return figures;
+  }
+
+  int fontFlags(FPDF_TEXTPAGE textPage, int index)
+  {
+    int flags = 0;
+    FPDFText_GetFontInfo(textPage, index, nullptr, 0, &flags);
+    int result = 0;
+    if (flags & kFontItalic)
+      result |= PDFRX_REFLOW_RUN_ITALIC;
+    if (flags & kFontFixedPitch)
+      result |= PDFRX_REFLOW_RUN_MONOSPACE;
+    if (flags & kFontSerif)
+      result |= PDFRX_REFLOW_RUN_SERIF;
+    return result;
+  }
+
+  void appendCodePoint(std::vector<unsigned short> &text, unsigned int c)
+  {
+    if (c >= 0x10000 && c <= 0x10FFFF)
+    {
+      c -= 0x10000;
+      text.push_back(static_cast<unsigned short>(0xD800 + (c >> 10)));
+      text.push_back(static_cast<unsigned short>(0xDC00 + (c & 0x3FF)));
+    }
+    else if (c < 0x10000)
+    {
+      text.push_back(static_cast<unsigned short>(c));
+    }
+  }
+
+  // Builds the paragraphs in the reading order of the text page; the lines are separated by the CR/LF generated by
+  // PDFium and joined into a paragraph unless there is a vertical gap, a font size change or an indent.
+  class ParagraphBuilder
+  {
+  public:
+    ParagraphBuilder(FPDF_TEXTPAGE textPage, const std::vector<Rect> &figures) : textPage_(textPage), figures_(figures) {}
+
+    std::vector<Paragraph> build()
+    {
+      const int count = FPDFText_CountChars(textPage_);
+      for (int i = 0; i < count; i++)
+      {
+        const unsigned int c = FPDFText_GetUnicode(textPage_, i);
+        if (c == '\r' || c == '\n')
+        {
+          lineBreak_ = hasLine_;
+          continue;
+        }
+        if (c < 0x20 || c == 0xFFFE || c == 0xFFFF)
+          continue;
+        if (c == ' ' || c == 0xA0)
+        {
+          space_ = hasLine_ && !lineBreak_;
+          continue;
+        }
+        if (FPDFText_IsHyphen(textPage_, i) == 1)
+        {
+          // soft hyphen at the end of a line; the word continues on the next line
+          hyphen_ = true;
+          continue;
+        }
+
+        double left, right, bottom, top;
+        if (!FPDFText_GetCharBox(textPage_, i, &left, &right, &bottom, &top) || right < left || top < bottom)
+          continue;
+        const Rect box = {left, top, right, bottom};
+        if (insideFigure(box))
+          continue;
+        float fontSize = static_cast<float>(FPDFText_GetFontSize(textPage_, i));
+        if (!(fontSize > 0))
+          fontSize = static_cast<float>(top - bottom);
+        addChar(c, box, fontSize, FPDFText_GetFontWeight(textPage_, i), fontFlags(textPage_, i));
+      }
+      flushParagraph();
+      return std::move(paragraphs_);
+    }
+
+  private:
+    bool insideFigure(const Rect &box) const
+    {
+      const double x = (box.left + box.right) / 2, y = (box.top + box.bottom) / 2;
+      for (const auto &f : figures_)
+      {
+        if (f.contains(x, y))
+          return true;
+      }
+      return false;
+    }
+
+    void addChar(unsigned int c, const Rect &box, float fontSize, int weight, int flags)
+    {
+      if (lineBreak_)
+      {
+        const double lineHeight = line_.top - line_.bottom;
+        const double gap = line_.bottom - box.top;
+        const bool newParagraph = gap > lineHeight * 0.8 || gap < -lineHeight * 2 ||
+                                  std::fabs(fontSize - lineFontSize_) > std::max(1.0f, lineFontSize_ * 0.15f) ||
+                                  box.left > paragraph_.rect.left + fontSize * 2;
+        if (newParagraph)
+          flushParagraph();
+        else if (!hyphen_)
+          space_ = true;
+        hasLine_ = false;
+        lineBreak_ = false;
+      }
+      hyphen_ = false;
+
+      if (paragraph_.runs.empty())
+      {
+        paragraph_.rect = box;
+        space_ = false;
+      }
+      else
+      {
+        paragraph_.rect.add(box);
+      }
+      if (hasLine_)
+        line_.add(box);
+      else
+        line_ = box;
+      hasLine_ = true;
+      lineFontSize_ = fontSize;
+
+      Run *run = paragraph_.runs.empty() ? nullptr : &paragraph_.runs.back();
+      if (space_ && run)
+        run->text.push_back(' ');
+      space_ = false;
+      if (!run || std::fabs(run->fontSize - fontSize) > 0.5f || run->weight != weight || run->flags != flags)
+      {
+        paragraph_.runs.push_back(Run{fontSize, weight, flags, {}});
+        run = &paragraph_.runs.back();
+      }
+      appendCodePoint(run->text, c);
+    }
+
+    void flushParagraph()
+    {
+      if (!paragraph_.runs.empty())
+        paragraphs_.push_back(std::move(paragraph_));
+      paragraph_ = Paragraph{};
+      hasLine_ = false;
+      lineBreak_ = false;
+      space_ = false;
+      hyphen_ = false;
+    }
+
+    FPDF_TEXTPAGE textPage_;
+    const std::vector<Rect> &figures_;
+    std::vector<Paragraph> paragraphs_;
+    Paragraph paragraph_ = {};
+    Rect line_ = {};
+    float lineFontSize_ = 0;
+    bool hasLine_ = false;
+    bool lineBreak_ = false;
+    bool space_ = false;
+    bool hyphen_ = false;
+  };
+
+  void writeRect(PackedWriter &w, const Rect &r)
+  {
+    w.f32(static_cast<float>(r.left));
+    w.f32(static_cast<float>(r.top));
+    w.f32(static_cast<float>(r.right));
+    w.f32(static_cast<float>(r.bottom));
+  }
+} // namespace
+
+extern "C" EXPORT unsigned char *INTEROP_API pdfrx_page_reflow(pdfrx_page_cache *cache, FPDF_PAGE page, int64_t *size)
+{
+  PackedWriter w;
+  w.i32(1); // format version
+  const auto figures = pageFigures(page);
+  std::vector<Paragraph> paragraphs;
+  FPDF_TEXTPAGE textPage = pdfrx_page_cache_acquire_text(cache, page);
+  if (textPage)
+  {
+    paragraphs = ParagraphBuilder(textPage, figures).build();
+    pdfrx_page_cache_release_text(cache, page, textPage);
+  }
+
+  // each figure is placed before the first paragraph starting below its top
+  size_t nextFigure = 0;
+  auto writeFiguresAbove = [&](double y)
+  {
+    for (; nextFigure < figures.size() && figures[nextFigure].top >= y; nextFigure++)
+    {
+      w.i32(kBlockFigure);
+      writeRect(w, figures[nextFigure]);
+    }
+  };
+  for (const auto &p : paragraphs)
+  {
+    writeFiguresAbove(p.rect.top);
+    w.i32(kBlockParagraph);
+    writeRect(w, p.rect);
+    w.i32(static_cast<int32_t>(p.runs.size()));
+    for (const auto &run : p.runs)
+    {
+      w.f32(run.fontSize);
+      w.i32(run.weight);
+      w.i32(run.flags);
+      w.utf16(run.text.data(), static_cast<int32_t>(run.text.size()));
+    }
+  }
+  writeFiguresAbove(-INFINITY);
+  w.i32(kBlockEnd);
+  return w.detach(size);
+}
@@ -0,0 +1,317 @@
+#include "pdfium_interop.h"
+
+#include <fpdf_edit.h>
+#include <fpdf_progressive.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+namespace
+{
+  // Header placed before every pooled buffer; 16 bytes to keep the pixels 16-byte aligned.
+  struct alignas(16) BufferHeader
+  {
+    std::atomic<int> refCount;
+    size_t size;
+  };
+
+  // Released buffers are kept for reuse up to maxIdleBytes; the viewer renders the same tile sizes repeatedly.
+  struct BufferPool
+  {
+    std::mutex mutex;
+    std::multimap<size_t, BufferHeader *> idle;
+    size_t idleBytes = 0;
+    size_t maxIdleBytes = 64 * 1024 * 1024;
+
+    void trim()
+    {
+      // drop the largest first; they are the least likely to fit the next request exactly
+      while (idleBytes > maxIdleBytes && !idle.empty())
+      {
+        auto it = std::prev(idle.end());
+        idleBytes -= it->first;
+        free(it->second);
+        idle.erase(it);
+      }
+    }
+  };
+
+  BufferPool &pool()
+  {
+    // intentionally leaked; the buffers may be released by the Dart finalizers at the process exit
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+  }
+
+  BufferHeader *headerOf(void *buffer)
+  {
+    return reinterpret_cast<BufferHeader *>(static_cast<unsigned char *>(buffer) - sizeof(BufferHeader));
+  }
+
+  int bytesPerPixel(int format)
+  {
+    switch (format)
+    {
+    case FPDFBitmap_Gray:
+      return 1;
+    case FPDFBitmap_BGR:
+      return 3;
+    case FPDFBitmap_BGRx:
+    case FPDFBitmap_BGRA:
+      return 4;
+    default:
+      return 0;
+    }
+  }
+} // namespace
+
+struct pdfrx_render_job
+{
+  IFSDK_PAUSE pause;
+  std::chrono::steady_clock::time_point sliceDeadline;
+  // the job is aborted at the deadline if hasDeadline
+  std::chrono::steady_clock::time_point deadline;
+  bool hasDeadline;
+  bool pauseEnabled;
+  FPDF_PAGE page;
+  FPDF_BITMAP bitmap;
+  unsigned char *buffer;
+  int64_t bufferSize;
+  int width;
+  int height;
+  int status;
+  int degradation;
+};
+
+namespace
+{
+  FPDF_BOOL needToPauseNow(IFSDK_PAUSE *pause)
+  {
+    auto *job = static_cast<pdfrx_render_job *>(pause->user);
+    return std::chrono::steady_clock::now() >= job->sliceDeadline;
+  }
+
+  // timeSliceMs <= 0 renders without pausing unless the job has a deadline.
+  IFSDK_PAUSE *startSlice(pdfrx_render_job *job, int timeSliceMs)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    job->pauseEnabled = timeSliceMs > 0 || job->hasDeadline;
+    job->sliceDeadline = timeSliceMs > 0 ? now + std::chrono::milliseconds(timeSliceMs) : job->deadline;
+    if (job->hasDeadline && job->sliceDeadline > job->deadline)
+      job->sliceDeadline = job->deadline;
+    return job->pauseEnabled ? &job->pause : nullptr;
+  }
+
+  // Abort the job if it is still in progress at the deadline; what is rendered so far is the result.
+  void checkDeadline(pdfrx_render_job *job)
+  {
+    if (job->status == FPDF_RENDER_TOBECONTINUED && job->hasDeadline && std::chrono::steady_clock::now() >= job->deadline)
+    {
+      job->status = FPDF_RENDER_DONE;
+      job->degradation |= PDFRX_RENDER_DEGRADED_TIME;
+    }
+  }
+} // namespace
+
+extern "C" EXPORT int INTEROP_API pdfrx_render_page(FPDF_PAGE page,
+                                                     unsigned char *buffer,
+                                                     int64_t bufferSize,
+                                                     int width,
+                                                     int height,
+                                                     int stride,
+                                                     int format,
+                                                     int x,
+                                                     int y,
+                                                     int fullWidth,
+                                                     int fullHeight,
+                                                     unsigned int backgroundColor,
+                                                     int flags)
+{
+  const int bpp = bytesPerPixel(format);
+  if (!page || !buffer || bpp == 0 || width <= 0 || height <= 0 || fullWidth <= 0 || fullHeight <= 0)
+    return PDFRX_RENDER_INVALID_ARGUMENT;
+  // the last row does not have to be padded to the stride
+  if (stride < static_cast<int64_t>(width) * bpp ||
+      bufferSize < static_cast<int64_t>(stride) * (height - 1) + static_cast<int64_t>(width) * bpp)
+    return PDFRX_RENDER_INVALID_ARGUMENT;
+
+  FPDF_BITMAP bitmap = FPDFBitmap_CreateEx(width, height, format, buffer, stride);
+  if (!bitmap)
+    return PDFRX_RENDER_BITMAP_FAILED;
+  FPDFBitmap_FillRect(bitmap, 0, 0, width, height, backgroundColor);
+  FPDF_RenderPageBitmap(bitmap, page, -x, -y, fullWidth, fullHeight, 0, flags);
+  FPDFBitmap_Destroy(bitmap);
+  return PDFRX_RENDER_OK;
+}
+
+extern "C" EXPORT unsigned char *INTEROP_API pdfrx_buffer_alloc(int64_t size)
+{
+  if (size <= 0)
+    return nullptr;
+  const size_t bytes = static_cast<size_t>(size);
+  BufferHeader *header = nullptr;
+  {
+    auto &p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    // reuse a buffer unless it wastes more than 1/4 of it
+    auto it = p.idle.lower_bound(bytes);
+    if (it != p.idle.end() && it->first <= bytes + bytes / 4)
+    {
+      header = it->second;
+      p.idleBytes -= it->first;
+      p.idle.erase(it);
+    }
+  }
+  if (!header)
+  {
+    header = static_cast<BufferHeader *>(malloc(sizeof(BufferHeader) + bytes));
+    if (!header)
+      return nullptr;
+    header->size = bytes;
+  }
+  header->refCount.store(1);
+  return reinterpret_cast<unsigned char *>(header + 1);
+}
+
+extern "C" EXPORT void INTEROP_API pdfrx_buffer_retain(void *buffer)
+{
+  headerOf(buffer)->refCount.fetch_add(1);
+}
+
+extern "C" EXPORT void INTEROP_API pdfrx_buffer_release(void *buffer)
+{
+  BufferHeader *header = headerOf(buffer);
+  if (header->refCount.fetch_sub(1) != 1)
+    return;
+  auto &p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  p.idle.emplace(header->size, header);
+  p.idleBytes += header->size;
+  p.trim();
+}
+
+extern "C" EXPORT void INTEROP_API pdfrx_buffer_pool_set_max_idle_bytes(int64_t maxIdleBytes)
+{
+  auto &p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  p.maxIdleBytes = maxIdleBytes > 0 ? static_cast<size_t>(maxIdleBytes) : 0;
+  p.trim();
+}
+
+extern "C" EXPORT pdfrx_render_job *INTEROP_API pdfrx_render_progressive_start(FPDF_PAGE page,
+                                                                               int width,
+                                                                               int height,
+                                                                               int x,
+                                                                               int y,
+                                                                               int fullWidth,
+                                                                               int fullHeight,
+                                                                               unsigned int backgroundColor,
+                                                                               int flags,
+                                                                               int timeSliceMs,
+                                                                               int64_t maxBitmapBytes,
+                                                                               int maxPageObjects,
+                                                                               int timeLimitMs)
+{
+  if (!page || width <= 0 || height <= 0 || fullWidth <= 0 || fullHeight <= 0)
+    return nullptr;
+  int degradation = 0;
+  int64_t bufferSize = static_cast<int64_t>(width) * height * 4;
+  if (maxBitmapBytes > 0 && bufferSize > maxBitmapBytes)
+  {
+    // render the same area at the lower resolution that fits the limit
+    const double scale = std::sqrt(static_cast<double>(maxBitmapBytes) / bufferSize);
+    width = std::max(1, static_cast<int>(width * scale));
+    height = std::max(1, static_cast<int>(height * scale));
+    x = static_cast<int>(x * scale);
+    y = static_cast<int>(y * scale);
+    fullWidth = std::max(1, static_cast<int>(fullWidth * scale));
+    fullHeight = std::max(1, static_cast<int>(fullHeight * scale));
+    bufferSize = static_cast<int64_t>(width) * height * 4;
+    degradation |= PDFRX_RENDER_DEGRADED_BITMAP_SIZE;
+  }
+  if (maxPageObjects > 0 && FPDFPage_CountObjects(page) > maxPageObjects)
+    degradation |= PDFRX_RENDER_DEGRADED_PAGE_OBJECTS;
+
+  unsigned char *buffer = pdfrx_buffer_alloc(bufferSize);
+  if (!buffer)
+    return nullptr;
+  FPDF_BITMAP bitmap = FPDFBitmap_CreateEx(width, height, FPDFBitmap_BGRA, buffer, width * 4);
+  if (!bitmap)
+  {
+    pdfrx_buffer_release(buffer);
+    return nullptr;
+  }
+  FPDFBitmap_FillRect(bitmap, 0, 0, width, height, backgroundColor);
+
+  auto *job = new pdfrx_render_job();
+  job->pause.version = 1;
+  job->pause.NeedToPauseNow = needToPauseNow;
+  job->pause.user = job;
+  job->hasDeadline = timeLimitMs > 0;
+  job->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeLimitMs > 0 ? timeLimitMs : 0);
+  job->page = page;
+  job->bitmap = bitmap;
+  job->buffer = buffer;
+  job->bufferSize = bufferSize;
+  job->width = width;
+  job->height = height;
+  job->degradation = degradation;
+  if (degradation & PDFRX_RENDER_DEGRADED_PAGE_OBJECTS)
+  {
+    // too many objects to render in time; the background is the draft
+    job->status = FPDF_RENDER_DONE;
+    return job;
+  }
+  job->status = FPDF_RenderPageBitmap_Start(bitmap, page, -x, -y, fullWidth, fullHeight, 0, flags, startSlice(job, timeSliceMs));
+  checkDeadline(job);
+  return job;
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_render_progressive_continue(pdfrx_render_job *job, int timeSliceMs)
+{
+  if (job->status == FPDF_RENDER_TOBECONTINUED)
+  {
+    job->status = FPDF_RenderPage_Continue(job->page, startSlice(job, timeSliceMs));
+    checkDeadline(job);
+  }
+  return job->status;
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_render_progressive_status(pdfrx_render_job *job)
+{
+  return job->status;
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_render_progressive_get_result(pdfrx_render_job *job, int *width, int *height)
+{
+  *width = job->width;
+  *height = job->height;
+  return job->degradation;
+}
+
+extern "C" EXPORT unsigned char *INTEROP_API pdfrx_render_progressive_snapshot(pdfrx_render_job *job)
+{
+  unsigned char *snapshot = pdfrx_buffer_alloc(job->bufferSize);
+  if (snapshot)
+    memcpy(snapshot, job->buffer, static_cast<size_t>(job->bufferSize));
+  return snapshot;
+}
+
+extern "C" EXPORT unsigned char *INTEROP_API pdfrx_render_progressive_close(pdfrx_render_job *job, int takeBuffer)
+{
+  FPDF_RenderPage_Close(job->page);
+  FPDFBitmap_Destroy(job->bitmap);
+  unsigned char *buffer = job->buffer;
+  delete job;
+  if (takeBuffer)
+    return buffer;
+  pdfrx_buffer_release(buffer);
+  return nullptr;
+}
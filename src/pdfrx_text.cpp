@@ -0,0 +1,194 @@
+#include "pdfium_interop.h"
+
+#include <fpdf_text.h>
+
+#include "pdfrx_glyph_index.h"
+#include "pdfrx_packed_buffer.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+  struct Rect
+  {
+    double left, top, right, bottom;
+  };
+
+  // Rectangles on the same line if they vertically overlap by half of the smaller height and are not too far away
+  // horizontally (to avoid merging across columns).
+  bool isOnSameLine(const Rect &a, const Rect &b)
+  {
+    const double overlap = std::min(a.top, b.top) - std::max(a.bottom, b.bottom);
+    const double height = std::min(a.top - a.bottom, b.top - b.bottom);
+    if (overlap < height * 0.5)
+      return false;
+    const double gap = b.left > a.right ? b.left - a.right : (a.left > b.right ? a.left - b.right : 0);
+    return gap <= std::max(a.top - a.bottom, b.top - b.bottom);
+  }
+
+  int pageSelectionRects(pdfrx_page_cache *cache, FPDF_PAGE page, int start, int count, double *rects, int maxRects)
+  {
+    FPDF_TEXTPAGE textPage = pdfrx_page_cache_acquire_text(cache, page);
+    if (!textPage)
+      return 0;
+    const int charCount = FPDFText_CountChars(textPage);
+    start = std::max(0, std::min(start, charCount));
+    if (count < 0 || start + count > charCount)
+      count = charCount - start;
+
+    int written = 0;
+    bool hasRun = false;
+    Rect run = {};
+    auto flush = [&]()
+    {
+      if (written < maxRects)
+      {
+        double *p = rects + written * 4;
+        p[0] = run.left;
+        p[1] = run.top;
+        p[2] = run.right;
+        p[3] = run.bottom;
+      }
+      written++;
+    };
+
+    // FPDFText_CountRects merges characters into segments of the same font/direction; they are further merged
+    // into line runs here
+    const int segmentCount = count > 0 ? FPDFText_CountRects(textPage, start, count) : 0;
+    for (int i = 0; i < segmentCount; i++)
+    {
+      Rect r;
+      if (!FPDFText_GetRect(textPage, i, &r.left, &r.top, &r.right, &r.bottom))
+        continue;
+      if (r.right <= r.left || r.top <= r.bottom)
+        continue;
+      if (hasRun && isOnSameLine(run, r))
+      {
+        run.left = std::min(run.left, r.left);
+        run.top = std::max(run.top, r.top);
+        run.right = std::max(run.right, r.right);
+        run.bottom = std::min(run.bottom, r.bottom);
+        continue;
+      }
+      if (hasRun)
+        flush();
+      run = r;
+      hasRun = true;
+    }
+    if (hasRun)
+      flush();
+
+    pdfrx_page_cache_release_text(cache, page, textPage);
+    return written;
+  }
+} // namespace
+
+extern "C" EXPORT int INTEROP_API pdfrx_text_selection_rects(pdfrx_page_cache *cache,
+                                                              FPDF_PAGE *pages,
+                                                              int pageCount,
+                                                              const int *starts,
+                                                              const int *counts,
+                                                              double *rects,
+                                                              int maxRects,
+                                                              int *rectCounts)
+{
+  int total = 0;
+  for (int i = 0; i < pageCount; i++)
+  {
+    const int remaining = std::max(0, maxRects - total);
+    const int n = pageSelectionRects(cache, pages[i], starts[i], counts[i], rects + std::min(total, maxRects) * 4, remaining);
+    rectCounts[i] = n;
+    total += n;
+  }
+  return total;
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_text_char_index_at(pdfrx_page_cache *cache, FPDF_PAGE page, double x, double y, double tolerance)
+{
+  FPDF_TEXTPAGE textPage = pdfrx_page_cache_acquire_text(cache, page);
+  if (!textPage)
+    return -1;
+  int index = FPDFText_GetCharIndexAtPos(textPage, x, y, tolerance, tolerance);
+  if (index < 0)
+  {
+    // between lines or on margins; snap to the nearest character
+    const int charCount = FPDFText_CountChars(textPage);
+    double nearest = tolerance * tolerance * 64;
+    for (int i = 0; i < charCount; i++)
+    {
+      double left, right, bottom, top;
+      if (!FPDFText_GetCharBox(textPage, i, &left, &right, &bottom, &top))
+        continue;
+      const double dx = x < left ? left - x : (x > right ? x - right : 0);
+      const double dy = y < bottom ? bottom - y : (y > top ? y - top : 0);
+      const double d = dx * dx + dy * dy * 4; // prefer the characters on the same line
+      if (d < nearest)
+      {
+        nearest = d;
+        index = i;
+      }
+    }
+  }
+  pdfrx_page_cache_release_text(cache, page, textPage);
+  return index;
+}
+
+extern "C" EXPORT int INTEROP_API pdfrx_text_get_range(pdfrx_page_cache *cache, FPDF_PAGE page, int start, int count, unsigned short *buffer, int bufferLength)
+{
+  FPDF_TEXTPAGE textPage = pdfrx_page_cache_acquire_text(cache, page);
+  if (!textPage)
+    return 0;
+  const int charCount = FPDFText_CountChars(textPage);
+  start = std::max(0, std::min(start, charCount));
+  if (count < 0 || start + count > charCount)
+    count = charCount - start;
+  int written = 0;
+  if (buffer && bufferLength > 0 && count > 0)
+  {
+    // FPDFText_GetText writes count + 1 characters including the terminating NUL
+    const int n = std::min(count, bufferLength - 1);
+    if (n > 0)
+      written = std::max(0, FPDFText_GetText(textPage, start, n, buffer) - 1);
+  }
+  else
+  {
+    written = count;
+  }
+  pdfrx_page_cache_release_text(cache, page, textPage);
+  return written;
+}
+
+extern "C" EXPORT unsigned char *INTEROP_API pdfrx_text_get_region(pdfrx_page_cache *cache,
+                                                                   FPDF_PAGE page,
+                                                                   double left,
+                                                                   double top,
+                                                                   double right,
+                                                                   double bottom,
+                                                                   int64_t *size)
+{
+  pdfrx::PackedWriter w;
+  w.i32(1); // format version
+  FPDF_TEXTPAGE textPage = pdfrx_page_cache_acquire_text(cache, page);
+  if (!textPage)
+  {
+    w.i32(0);
+    return w.detach(size);
+  }
+  const auto index = pdfrx::acquireGlyphIndex(cache, page, textPage);
+  std::vector<int> chars;
+  index->query(left, top, right, bottom, chars);
+  w.i32(static_cast<int32_t>(chars.size()));
+  for (int i : chars)
+  {
+    const auto &box = index->box(i);
+    w.i32(i);
+    w.i32(static_cast<int32_t>(FPDFText_GetUnicode(textPage, i)));
+    w.f32(box.left);
+    w.f32(box.top);
+    w.f32(box.right);
+    w.f32(box.bottom);
+  }
+  pdfrx_page_cache_release_text(cache, page, textPage);
+  return w.detach(size);
+}
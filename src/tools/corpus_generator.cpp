@@ -0,0 +1,869 @@
+// Synthetic PDF corpus generator for scaling benchmarks.
+//
+// The generator builds documents of controlled properties with PDFium's editing API (FPDF_CreateNewDocument,
+// FPDFPage_New, FPDFPageObj_*, FPDFPage_CreateAnnot and FPDF_SaveAsCopy): the number and size of pages, characters
+// per page, images per page and their pixel size, annotations per page and an outline (bookmark) tree of a given
+// depth and breadth. The output is deterministic for the same options and seed (the document ID, which PDFium
+// generates randomly, is normalized and the creation date, which PDFium takes from the clock, is left empty), so the
+// scaling tests of the open, render, text and search paths do not need checked-in binaries.
+//
+// Every page has exactly one "pdfrxneedle" word to be found by the search tests.
+//
+// PDFium has no API to create outlines; they are appended to the saved file as an incremental update along with
+// the catalog referring to them.
+//
+// Build with -DPDFRX_BUILD_TOOLS=ON (see ../CMakeLists.txt):
+//
+//   pdfrx_corpus_generator [--preset=NAME] [--OPTION=VALUE...] output.pdf
+//   pdfrx_corpus_generator --preset=all output-directory
+//
+// Options (per page unless noted):
+//   --pages=N            number of pages (10)
+//   --page-size=WxH      page size in points (612x792)
+//   --chars=N            characters of text (2000)
+//   --images=N           images (0)
+//   --image-size=WxH     image size in pixels (512x512)
+//   --annotations=N      annotations; squares, sticky notes, links and highlights in turn (0)
+//   --outline-depth=N    depth of the outline tree (0: no outline)
+//   --outline-breadth=N  children of each outline item (1)
+//   --seed=N             random seed (1)
+//
+// Presets (the options after --preset override them):
+//   pages        50,000 pages of light text
+//   chars        20 pages of 100,000 characters
+//   images       4 pages with an 8000x8000 image (stored uncompressed; about 730 MB)
+//   outline      100 pages with an outline of 8^6 (299,592) items
+//   deep-outline 100 pages with an outline nested 1,000 levels deep
+//   annotations  50 pages with 2,000 annotations
+//   all          every preset above into output-directory/PRESET.pdf
+
+// 64-bit off_t for fseeko/ftello on 32-bit POSIX systems; the options (e.g. more pages of the images preset) can
+// produce files larger than 2GB
+#define _FILE_OFFSET_BITS 64
+
+#include <fpdf_annot.h>
+#include <fpdf_edit.h>
+#include <fpdf_save.h>
+#include <fpdfview.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const int kAnnotText = 1;      // FPDF_ANNOT_TEXT
+  const int kAnnotLink = 2;      // FPDF_ANNOT_LINK
+  const int kAnnotSquare = 5;    // FPDF_ANNOT_SQUARE
+  const int kAnnotHighlight = 9; // FPDF_ANNOT_HIGHLIGHT
+  const int kMaxOutlineItems = 1000000;
+  const int kMaxOutlineDepth = 10000;
+
+  struct Options
+  {
+    int pages = 10;
+    double pageWidth = 612;
+    double pageHeight = 792;
+    int chars = 2000;
+    int images = 0;
+    int imageWidth = 512;
+    int imageHeight = 512;
+    int annotations = 0;
+    int outlineDepth = 0;
+    int outlineBreadth = 1;
+    uint32_t seed = 1;
+  };
+
+  struct Preset
+  {
+    const char *name;
+    void (*apply)(Options &options);
+  };
+
+  const Preset kPresets[] = {
+      {"pages", [](Options &o)
+       { o.pages = 50000; o.chars = 200; }},
+      {"chars", [](Options &o)
+       { o.pages = 20; o.chars = 100000; }},
+      {"images", [](Options &o)
+       { o.pages = 4; o.chars = 200; o.images = 1; o.imageWidth = o.imageHeight = 8000; }},
+      {"outline", [](Options &o)
+       { o.pages = 100; o.outlineDepth = 6; o.outlineBreadth = 8; }},
+      {"deep-outline", [](Options &o)
+       { o.pages = 100; o.outlineDepth = 1000; o.outlineBreadth = 1; }},
+      {"annotations", [](Options &o)
+       { o.pages = 50; o.chars = 500; o.annotations = 2000; }},
+  };
+
+  const char *const kWords[] = {
+      "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do", "eiusmod",
+      "tempor", "incididunt", "ut", "labore", "et", "dolore", "magna", "aliqua", "enim", "ad", "minim", "veniam",
+      "quis", "nostrud", "exercitation", "ullamco", "laboris", "nisi", "aliquip", "ex", "ea", "commodo"};
+
+  bool parseSize(const char *value, double &width, double &height)
+  {
+    return sscanf(value, "%lfx%lf", &width, &height) == 2 && width > 0 && height > 0;
+  }
+
+  bool parseOption(const char *arg, Options &o)
+  {
+    const char *eq = strchr(arg, '=');
+    if (!eq)
+      return false;
+    const std::string name(arg, eq - arg);
+    const char *value = eq + 1;
+    if (name == "--preset")
+    {
+      for (const auto &preset : kPresets)
+      {
+        if (strcmp(preset.name, value) == 0)
+        {
+          preset.apply(o);
+          return true;
+        }
+      }
+      return false;
+    }
+    if (name == "--page-size")
+      return parseSize(value, o.pageWidth, o.pageHeight);
+    if (name == "--image-size")
+    {
+      double w, h;
+      if (!parseSize(value, w, h))
+        return false;
+      o.imageWidth = static_cast<int>(w);
+      o.imageHeight = static_cast<int>(h);
+      return o.imageWidth > 0 && o.imageHeight > 0;
+    }
+    const int n = atoi(value);
+    if (n < 0)
+      return false;
+    if (name == "--pages")
+      o.pages = n;
+    else if (name == "--chars")
+      o.chars = n;
+    else if (name == "--images")
+      o.images = n;
+    else if (name == "--annotations")
+      o.annotations = n;
+    else if (name == "--outline-depth")
+      o.outlineDepth = n;
+    else if (name == "--outline-breadth")
+      o.outlineBreadth = n;
+    else if (name == "--seed")
+      o.seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+    else
+      return false;
+    return true;
+  }
+
+  uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 14695981039346656037ull)
+  {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+      hash ^= p[i];
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  // Hash of the options for the document ID; the fields are hashed one by one to skip the padding.
+  uint64_t optionsHash(const Options &o)
+  {
+    const double values[] = {static_cast<double>(o.pages), o.pageWidth, o.pageHeight, static_cast<double>(o.chars),
+                             static_cast<double>(o.images), static_cast<double>(o.imageWidth),
+                             static_cast<double>(o.imageHeight), static_cast<double>(o.annotations),
+                             static_cast<double>(o.outlineDepth), static_cast<double>(o.outlineBreadth),
+                             static_cast<double>(o.seed)};
+    return fnv1a(values, sizeof(values));
+  }
+
+  // Each page has its own random sequence so that the pages do not depend on the others.
+  std::mt19937 pageRandom(const Options &o, int pageIndex)
+  {
+    return std::mt19937(o.seed * 1000003u + static_cast<uint32_t>(pageIndex));
+  }
+
+  void buildLine(std::vector<unsigned short> &text, int length, std::mt19937 &random, bool needle)
+  {
+    text.clear();
+    if (needle)
+    {
+      for (const char *p = "pdfrxneedle "; *p && static_cast<int>(text.size()) < length; p++)
+        text.push_back(static_cast<unsigned short>(*p));
+    }
+    while (static_cast<int>(text.size()) < length)
+    {
+      if (!text.empty() && text.back() != ' ')
+        text.push_back(' ');
+      for (const char *p = kWords[random() % (sizeof(kWords) / sizeof(kWords[0]))]; *p && static_cast<int>(text.size()) < length; p++)
+        text.push_back(static_cast<unsigned short>(*p));
+    }
+    text.resize(length);
+    text.push_back(0);
+  }
+
+  bool addText(FPDF_DOCUMENT doc, FPDF_PAGE page, FPDF_FONT font, const Options &o, std::mt19937 &random)
+  {
+    if (o.chars <= 0)
+      return true;
+    const double margin = 36;
+    const double width = std::max(1.0, o.pageWidth - margin * 2);
+    const double height = std::max(1.0, o.pageHeight - margin * 2);
+    // Helvetica glyphs are about 0.5 em wide on average and the lines are 1.2 em apart
+    const double fontSize = std::min(12.0, std::sqrt(width * height / (0.6 * o.chars)));
+    const int charsPerLine = std::max(1, static_cast<int>(width / (fontSize * 0.5)));
+    const int lines = (o.chars + charsPerLine - 1) / charsPerLine;
+    const int needleLine = static_cast<int>(random() % static_cast<uint32_t>(lines));
+    std::vector<unsigned short> text;
+    for (int i = 0, remaining = o.chars; i < lines; i++)
+    {
+      const int length = std::min(charsPerLine, remaining);
+      remaining -= length;
+      buildLine(text, length, random, i == needleLine);
+      FPDF_PAGEOBJECT obj = FPDFPageObj_CreateTextObj(doc, font, static_cast<float>(fontSize));
+      if (!obj)
+        return false;
+      if (!FPDFText_SetText(obj, text.data()))
+      {
+        FPDFPageObj_Destroy(obj);
+        return false;
+      }
+      FPDFPageObj_Transform(obj, 1, 0, 0, 1, margin, o.pageHeight - margin - fontSize * 1.2 * (i + 1));
+      FPDFPage_InsertObject(page, obj);
+    }
+    return true;
+  }
+
+  // Gradient with noise; the noise keeps the image from being compressed well as photos do.
+  void fillImage(FPDF_BITMAP bitmap, int width, int height, uint32_t seed)
+  {
+    unsigned char *buffer = static_cast<unsigned char *>(FPDFBitmap_GetBuffer(bitmap));
+    const int stride = FPDFBitmap_GetStride(bitmap);
+    uint32_t state = seed | 1;
+    for (int y = 0; y < height; y++)
+    {
+      unsigned char *p = buffer + static_cast<size_t>(y) * stride;
+      for (int x = 0; x < width; x++, p += 4)
+      {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const int noise = static_cast<int>(state & 31) - 16;
+        p[0] = static_cast<unsigned char>(std::max(0, std::min(255, x * 255 / width + noise)));
+        p[1] = static_cast<unsigned char>(std::max(0, std::min(255, y * 255 / height + noise)));
+        p[2] = static_cast<unsigned char>((seed >> 8) & 255);
+        p[3] = 255;
+      }
+    }
+  }
+
+  bool addImages(FPDF_DOCUMENT doc, FPDF_PAGE page, const Options &o, std::mt19937 &random)
+  {
+    if (o.images <= 0)
+      return true;
+    const int cols = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(o.images))));
+    const int rows = (o.images + cols - 1) / cols;
+    const double cellWidth = o.pageWidth / cols, cellHeight = o.pageHeight / rows;
+    const double scale = std::min(cellWidth / o.imageWidth, cellHeight / o.imageHeight);
+    const double width = o.imageWidth * scale, height = o.imageHeight * scale;
+    for (int i = 0; i < o.images; i++)
+    {
+      FPDF_BITMAP bitmap = FPDFBitmap_Create(o.imageWidth, o.imageHeight, 0);
+      if (!bitmap)
+        return false;
+      fillImage(bitmap, o.imageWidth, o.imageHeight, static_cast<uint32_t>(random()));
+      FPDF_PAGEOBJECT obj = FPDFPageObj_NewImageObj(doc);
+      const bool ok = obj && FPDFImageObj_SetBitmap(&page, 1, obj, bitmap);
+      FPDFBitmap_Destroy(bitmap);
+      if (!ok)
+      {
+        if (obj)
+          FPDFPageObj_Destroy(obj);
+        return false;
+      }
+      const double x = (i % cols) * cellWidth + (cellWidth - width) / 2;
+      const double y = o.pageHeight - (i / cols + 1) * cellHeight + (cellHeight - height) / 2;
+      FPDFImageObj_SetMatrix(obj, width, 0, 0, height, x, y);
+      FPDFPage_InsertObject(page, obj);
+    }
+    return true;
+  }
+
+  void toWide(const std::string &s, std::vector<unsigned short> &wide)
+  {
+    wide.assign(s.begin(), s.end());
+    wide.push_back(0);
+  }
+
+  bool addAnnotations(FPDF_PAGE page, const Options &o, int pageIndex, std::mt19937 &random)
+  {
+    if (o.annotations <= 0)
+      return true;
+    const int cols = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(o.annotations))));
+    const int rows = (o.annotations + cols - 1) / cols;
+    const float cellWidth = static_cast<float>(o.pageWidth / cols), cellHeight = static_cast<float>(o.pageHeight / rows);
+    std::vector<unsigned short> wide;
+    for (int i = 0; i < o.annotations; i++)
+    {
+      static const int kSubtypes[] = {kAnnotSquare, kAnnotText, kAnnotLink, kAnnotHighlight};
+      const int subtype = kSubtypes[i % 4];
+      FPDF_ANNOTATION annot = FPDFPage_CreateAnnot(page, subtype);
+      if (!annot)
+        return false;
+      const float left = (i % cols) * cellWidth, top = static_cast<float>(o.pageHeight) - (i / cols) * cellHeight;
+      const FS_RECTF rect = {left + cellWidth * 0.1f, top - cellHeight * 0.1f, left + cellWidth * 0.9f, top - cellHeight * 0.9f};
+      bool ok = FPDFAnnot_SetRect(annot, &rect);
+      const uint32_t color = static_cast<uint32_t>(random());
+      if (subtype != kAnnotLink)
+        ok = ok && FPDFAnnot_SetColor(annot, FPDFANNOT_COLORTYPE_Color, color & 255, (color >> 8) & 255, (color >> 16) & 255, 255);
+      if (subtype == kAnnotLink)
+      {
+        const std::string uri = "https://example.com/page/" + std::to_string(pageIndex + 1) + "/" + std::to_string(i);
+        ok = ok && FPDFAnnot_SetURI(annot, uri.c_str());
+      }
+      else
+      {
+        toWide("Annotation " + std::to_string(i) + " on page " + std::to_string(pageIndex + 1), wide);
+        ok = ok && FPDFAnnot_SetStringValue(annot, "Contents", wide.data());
+      }
+      if (subtype == kAnnotHighlight)
+      {
+        const FS_QUADPOINTSF quad = {rect.left, rect.top, rect.right, rect.top, rect.left, rect.bottom, rect.right, rect.bottom};
+        ok = ok && FPDFAnnot_AppendAttachmentPoints(annot, &quad);
+      }
+      FPDFPage_CloseAnnot(annot);
+      if (!ok)
+        return false;
+    }
+    return true;
+  }
+
+  // File positions are 64-bit; long (fseek/ftell) is 32-bit on Windows.
+  int64_t fileTell(FILE *fp)
+  {
+#ifdef _WIN32
+    return _ftelli64(fp);
+#else
+    return ftello(fp);
+#endif
+  }
+
+  bool fileSeek(FILE *fp, int64_t offset, int origin)
+  {
+#ifdef _WIN32
+    return _fseeki64(fp, offset, origin) == 0;
+#else
+    return fseeko(fp, static_cast<off_t>(offset), origin) == 0;
+#endif
+  }
+
+  struct FileWriter : FPDF_FILEWRITE
+  {
+    FILE *fp;
+  };
+
+  int writeBlock(FPDF_FILEWRITE *self, const void *data, unsigned long size)
+  {
+    FileWriter *writer = static_cast<FileWriter *>(self);
+    return fwrite(data, 1, size, writer->fp) == size ? 1 : 0;
+  }
+
+  bool isDelimiter(char c)
+  {
+    return !(isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '-');
+  }
+
+  // Position just after /key (not a prefix of a longer name) in dict; npos if not found.
+  size_t findKey(const std::string &dict, const char *key, size_t from = 0)
+  {
+    const size_t length = strlen(key);
+    for (size_t pos = dict.find(key, from); pos != std::string::npos; pos = dict.find(key, pos + 1))
+    {
+      if (pos + length >= dict.size() || isDelimiter(dict[pos + length]))
+        return pos + length;
+    }
+    return std::string::npos;
+  }
+
+  bool findInt(const std::string &dict, const char *key, long long &value)
+  {
+    const size_t pos = findKey(dict, key);
+    if (pos == std::string::npos)
+      return false;
+    char *end;
+    value = strtoll(dict.c_str() + pos, &end, 10);
+    return end != dict.c_str() + pos;
+  }
+
+  // Position of the >> closing the dictionary starting at start (<<); npos if not closed.
+  size_t dictEnd(const std::string &s, size_t start)
+  {
+    int depth = 0;
+    for (size_t i = start; i + 1 < s.size(); i++)
+    {
+      if (s[i] == '<' && s[i + 1] == '<')
+      {
+        depth++;
+        i++;
+      }
+      else if (s[i] == '>' && s[i + 1] == '>')
+      {
+        if (--depth == 0)
+          return i;
+        i++;
+      }
+    }
+    return std::string::npos;
+  }
+
+  // Minimal reader of the file written by FPDF_SaveAsCopy: the classic cross reference table and the trailer, to
+  // normalize the document ID and to append the outline.
+  class SavedFile
+  {
+  public:
+    explicit SavedFile(FILE *fp) : fp_(fp) {}
+
+    bool load()
+    {
+      if (!fileSeek(fp_, 0, SEEK_END) || (fileSize_ = fileTell(fp_)) < 0)
+        return false;
+      const int64_t tailSize = std::min<int64_t>(fileSize_, 1024);
+      std::string tail(static_cast<size_t>(tailSize), '\0');
+      fileSeek(fp_, fileSize_ - tailSize, SEEK_SET);
+      if (fread(&tail[0], 1, tail.size(), fp_) != tail.size())
+        return false;
+      const size_t pos = tail.rfind("startxref");
+      if (pos == std::string::npos)
+        return false;
+      startxref_ = strtoll(tail.c_str() + pos + 9, nullptr, 10);
+      if (startxref_ <= 0 || startxref_ >= fileSize_)
+        return false;
+
+      xref_.resize(static_cast<size_t>(fileSize_ - startxref_));
+      fileSeek(fp_, startxref_, SEEK_SET);
+      if (fread(&xref_[0], 1, xref_.size(), fp_) != xref_.size() || xref_.compare(0, 4, "xref") != 0)
+        return false; // a cross reference stream is not supported
+      const char *p = xref_.c_str() + 4;
+      for (;;)
+      {
+        while (isspace(static_cast<unsigned char>(*p)))
+          p++;
+        if (strncmp(p, "trailer", 7) == 0)
+          break;
+        char *end;
+        const long long start = strtoll(p, &end, 10);
+        const long long count = strtoll(end, &end, 10);
+        if (end == p || count < 0)
+          return false;
+        p = end;
+        if (offsets_.size() < static_cast<size_t>(start + count))
+          offsets_.resize(static_cast<size_t>(start + count), -1);
+        for (long long i = 0; i < count; i++)
+        {
+          const long long offset = strtoll(p, &end, 10);
+          strtol(end, &end, 10);
+          while (*end == ' ')
+            end++;
+          if (*end == 'n')
+            offsets_[static_cast<size_t>(start + i)] = offset;
+          p = end + 1;
+        }
+      }
+      trailerStart_ = xref_.find("<<", p - xref_.c_str());
+      const size_t end = trailerStart_ == std::string::npos ? std::string::npos : dictEnd(xref_, trailerStart_);
+      if (end == std::string::npos)
+        return false;
+      trailer_ = xref_.substr(trailerStart_, end + 2 - trailerStart_);
+      return true;
+    }
+
+    const std::string &trailer() const { return trailer_; }
+
+    // Overwrite the hex strings of /ID in place with a value derived from hash.
+    bool normalizeId(uint64_t hash)
+    {
+      size_t pos = findKey(trailer_, "/ID");
+      if (pos == std::string::npos)
+        return true; // no ID
+      pos = trailer_.find('[', pos);
+      const size_t end = pos == std::string::npos ? pos : trailer_.find(']', pos);
+      if (end == std::string::npos)
+        return false;
+      static const char kHex[] = "0123456789ABCDEF";
+      int digit = 0;
+      bool inHex = false;
+      for (size_t i = pos + 1; i < end; i++)
+      {
+        if (trailer_[i] == '<')
+          inHex = true;
+        else if (trailer_[i] == '>')
+          inHex = false;
+        else if (trailer_[i] == '(')
+          return false; // literal strings are not expected
+        else if (inHex && isxdigit(static_cast<unsigned char>(trailer_[i])))
+        {
+          trailer_[i] = kHex[(hash >> ((digit++ % 16) * 4)) & 15];
+          if (digit % 16 == 0)
+            hash = fnv1a(&hash, sizeof(hash));
+        }
+      }
+      fileSeek(fp_, startxref_ + static_cast<int64_t>(trailerStart_), SEEK_SET);
+      return fwrite(trailer_.data(), 1, trailer_.size(), fp_) == trailer_.size();
+    }
+
+    long long objectCount() const { return static_cast<long long>(offsets_.size()); }
+    long long startxref() const { return startxref_; }
+
+    // The dictionary of the object; empty if not found.
+    std::string object(long long num)
+    {
+      if (num <= 0 || num >= objectCount() || offsets_[num] < 0)
+        return std::string();
+      std::string text;
+      std::vector<char> chunk(64 * 1024);
+      fileSeek(fp_, offsets_[num], SEEK_SET);
+      for (;;)
+      {
+        const size_t n = fread(chunk.data(), 1, chunk.size(), fp_);
+        if (n == 0)
+          return std::string();
+        text.append(chunk.data(), n);
+        const size_t start = text.find("<<");
+        if (start != std::string::npos)
+        {
+          const size_t end = dictEnd(text, start);
+          if (end != std::string::npos)
+            return text.substr(start, end + 2 - start);
+        }
+      }
+    }
+
+    bool findRef(const std::string &dict, const char *key, long long &num) const
+    {
+      return findInt(dict, key, num) && num > 0 && num < objectCount();
+    }
+
+    // Collect the page objects in the page order.
+    bool collectPages(long long num, std::vector<long long> &pages, int depth = 0)
+    {
+      const std::string dict = object(num);
+      long long count;
+      const size_t kidsPos = findKey(dict, "/Kids");
+      if (kidsPos == std::string::npos || !findInt(dict, "/Count", count) || depth > 64)
+        return false;
+      std::vector<long long> kids;
+      const size_t kidsStart = dict.find('[', kidsPos);
+      if (kidsStart == std::string::npos)
+        return false;
+      const char *p = dict.c_str() + kidsStart + 1;
+      for (;;)
+      {
+        char *end;
+        const long long kid = strtoll(p, &end, 10);
+        if (end == p)
+          break;
+        strtoll(end, &end, 10); // generation
+        while (isspace(static_cast<unsigned char>(*end)))
+          end++;
+        if (*end != 'R')
+          return false;
+        kids.push_back(kid);
+        p = end + 1;
+      }
+      // a flat node (as written by PDFium for new documents) has every page as its kid
+      if (count == static_cast<long long>(kids.size()))
+      {
+        pages.insert(pages.end(), kids.begin(), kids.end());
+        return true;
+      }
+      for (long long kid : kids)
+      {
+        const std::string kidDict = object(kid);
+        const size_t typePos = findKey(kidDict, "/Type");
+        const size_t typeName = typePos == std::string::npos ? typePos : kidDict.find('/', typePos);
+        const bool isPages = typeName != std::string::npos && findKey(kidDict, "/Pages", typeName) == typeName + 6;
+        if (!isPages)
+          pages.push_back(kid);
+        else if (!collectPages(kid, pages, depth + 1))
+          return false;
+      }
+      return true;
+    }
+
+  private:
+    FILE *fp_;
+    int64_t fileSize_ = 0;
+    long long startxref_ = 0;
+    std::string xref_;
+    size_t trailerStart_ = 0;
+    std::string trailer_;
+    std::vector<long long> offsets_;
+  };
+
+  struct OutlineItem
+  {
+    int parent, prev = -1, next = -1, first = -1, last = -1, descendants = 0, level;
+  };
+
+  // Append the children of parent (and their descendants) in the preorder.
+  void buildOutline(std::vector<OutlineItem> &items, int parent, int level, const Options &o)
+  {
+    int prev = -1;
+    for (int i = 0; i < o.outlineBreadth; i++)
+    {
+      const int index = static_cast<int>(items.size());
+      OutlineItem item;
+      item.parent = parent;
+      item.level = level;
+      item.prev = prev;
+      items.push_back(item);
+      if (prev >= 0)
+        items[prev].next = index;
+      else if (parent >= 0)
+        items[parent].first = index;
+      if (parent >= 0)
+        items[parent].last = index;
+      prev = index;
+      if (level + 1 < o.outlineDepth)
+        buildOutline(items, index, level + 1, o);
+      if (parent >= 0)
+        items[parent].descendants += 1 + items[index].descendants;
+    }
+  }
+
+  long long outlineItemCount(const Options &o)
+  {
+    long long total = 0, levelCount = 1;
+    for (int i = 0; i < o.outlineDepth && total <= kMaxOutlineItems; i++)
+    {
+      levelCount *= o.outlineBreadth;
+      total += levelCount;
+    }
+    return total;
+  }
+
+  std::string replaceInt(const std::string &dict, const char *key, long long value)
+  {
+    const size_t pos = findKey(dict, key);
+    if (pos == std::string::npos)
+      return dict.substr(0, dict.size() - 2) + key + " " + std::to_string(value) + ">>";
+    size_t end = pos;
+    while (end < dict.size() && (isspace(static_cast<unsigned char>(dict[end])) || isdigit(static_cast<unsigned char>(dict[end]))))
+      end++;
+    return dict.substr(0, pos) + " " + std::to_string(value) + dict.substr(end);
+  }
+
+  // Append the outline items, the catalog referring to them and the cross reference section for them.
+  bool appendOutline(FILE *fp, SavedFile &file, const Options &o)
+  {
+    long long rootNum, pagesNum;
+    const std::string trailer = file.trailer();
+    std::string catalog;
+    std::vector<long long> pages;
+    if (!file.findRef(trailer, "/Root", rootNum) || (catalog = file.object(rootNum)).empty() ||
+        !file.findRef(catalog, "/Pages", pagesNum) || !file.collectPages(pagesNum, pages) ||
+        pages.size() != static_cast<size_t>(o.pages) || findKey(catalog, "/Outlines") != std::string::npos)
+      return false;
+
+    std::vector<OutlineItem> items;
+    buildOutline(items, -1, 0, o);
+    const long long first = file.objectCount(); // outline dictionary, then the items
+    std::vector<int64_t> offsets;
+    fileSeek(fp, 0, SEEK_END);
+    auto ref = [&](int index)
+    { return std::to_string(first + 1 + index) + " 0 R"; };
+
+    int topLevel = 0, last = 0;
+    for (size_t i = 0; i < items.size(); i++)
+    {
+      if (items[i].parent < 0)
+      {
+        topLevel++;
+        last = static_cast<int>(i);
+      }
+    }
+    offsets.push_back(fileTell(fp));
+    fprintf(fp, "%lld 0 obj\n<</Type/Outlines/First %s/Last %s/Count %d>>\nendobj\n", first, ref(0).c_str(),
+            ref(last).c_str(), topLevel);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+      const auto &item = items[i];
+      offsets.push_back(fileTell(fp));
+      std::string dict = "<</Title(Section " + std::to_string(i + 1) + " level " + std::to_string(item.level + 1) + ")";
+      dict += "/Parent " + (item.parent < 0 ? std::to_string(first) + " 0 R" : ref(item.parent));
+      if (item.prev >= 0)
+        dict += "/Prev " + ref(item.prev);
+      if (item.next >= 0)
+        dict += "/Next " + ref(item.next);
+      if (item.first >= 0)
+        dict += "/First " + ref(item.first) + "/Last " + ref(item.last) + "/Count -" + std::to_string(item.descendants);
+      char dest[128];
+      snprintf(dest, sizeof(dest), "/Dest[%lld 0 R/XYZ 0 %g 0]", pages[i % pages.size()], o.pageHeight);
+      dict += dest;
+      fprintf(fp, "%lld 0 obj\n%s>>\nendobj\n", first + 1 + static_cast<long long>(i), dict.c_str());
+    }
+    const int64_t catalogOffset = fileTell(fp);
+    fprintf(fp, "%lld 0 obj\n%s/Outlines %lld 0 R/PageMode/UseOutlines>>\nendobj\n", rootNum,
+            catalog.substr(0, catalog.size() - 2).c_str(), first);
+
+    const int64_t xref = fileTell(fp);
+    fprintf(fp, "xref\n0 1\n0000000000 65535 f\r\n%lld 1\n%010" PRId64 " 00000 n\r\n%lld %zu\n", rootNum, catalogOffset,
+            first, offsets.size());
+    for (int64_t offset : offsets)
+      fprintf(fp, "%010" PRId64 " 00000 n\r\n", offset);
+    std::string newTrailer = replaceInt(trailer, "/Size", first + static_cast<long long>(offsets.size()));
+    newTrailer = replaceInt(newTrailer, "/Prev", file.startxref());
+    fprintf(fp, "trailer\n%s\nstartxref\n%" PRId64 "\n%%%%EOF\n", newTrailer.c_str(), xref);
+    return !ferror(fp);
+  }
+
+  bool generate(const Options &o, const char *path)
+  {
+    if (outlineItemCount(o) > kMaxOutlineItems || o.outlineDepth > kMaxOutlineDepth || (o.outlineDepth > 0 && o.pages == 0))
+    {
+      fprintf(stderr, "the outline must have at most %d items in %d levels on non-empty documents\n", kMaxOutlineItems, kMaxOutlineDepth);
+      return false;
+    }
+    const auto startTime = std::chrono::steady_clock::now();
+    FPDF_DOCUMENT doc = FPDF_CreateNewDocument();
+    if (!doc)
+      return false;
+    FPDF_FONT font = FPDFText_LoadStandardFont(doc, "Helvetica");
+    bool ok = font != nullptr;
+    for (int i = 0; i < o.pages && ok; i++)
+    {
+      FPDF_PAGE page = FPDFPage_New(doc, i, o.pageWidth, o.pageHeight);
+      if (!page)
+      {
+        ok = false;
+        break;
+      }
+      auto random = pageRandom(o, i);
+      ok = addText(doc, page, font, o, random) && addImages(doc, page, o, random) &&
+           addAnnotations(page, o, i, random) && FPDFPage_GenerateContent(page);
+      FPDF_ClosePage(page);
+      if ((i + 1) % 1000 == 0)
+        fprintf(stderr, "%d/%d pages\r", i + 1, o.pages);
+    }
+    if (!ok)
+      fprintf(stderr, "failed to build the pages\n");
+
+    FILE *fp = ok ? fopen(path, "w+b") : nullptr;
+    if (ok && !fp)
+    {
+      fprintf(stderr, "cannot open %s\n", path);
+      ok = false;
+    }
+    if (ok)
+    {
+      FileWriter writer;
+      writer.version = 1;
+      writer.WriteBlock = writeBlock;
+      writer.fp = fp;
+      ok = FPDF_SaveAsCopy(doc, &writer, FPDF_NO_INCREMENTAL) && fflush(fp) == 0;
+      if (!ok)
+        fprintf(stderr, "failed to save %s\n", path);
+    }
+    if (font)
+      FPDFFont_Close(font);
+    FPDF_CloseDocument(doc);
+
+    if (ok)
+    {
+      SavedFile file(fp);
+      ok = file.load() && file.normalizeId(optionsHash(o));
+      if (!ok)
+        fprintf(stderr, "unexpected structure of the saved file %s\n", path);
+      if (ok && o.outlineDepth > 0 && o.outlineBreadth > 0)
+      {
+        ok = appendOutline(fp, file, o);
+        if (!ok)
+          fprintf(stderr, "failed to append the outline to %s\n", path);
+      }
+    }
+    int64_t size = 0;
+    if (fp)
+    {
+      fileSeek(fp, 0, SEEK_END);
+      size = fileTell(fp);
+      ok = fclose(fp) == 0 && ok;
+    }
+    if (!ok)
+      return false;
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    printf("%s: pages=%d page-size=%gx%g chars=%d images=%d image-size=%dx%d annotations=%d outline-items=%lld seed=%u\n",
+           path, o.pages, o.pageWidth, o.pageHeight, o.chars, o.images, o.imageWidth, o.imageHeight, o.annotations,
+           o.outlineDepth > 0 ? outlineItemCount(o) : 0, o.seed);
+    printf("  %.1f MB in %.2f s\n", size / (1024.0 * 1024.0), elapsed);
+    return true;
+  }
+
+  void usage()
+  {
+    fprintf(stderr, "usage: pdfrx_corpus_generator [--preset=NAME] [--OPTION=VALUE...] output.pdf\n"
+                    "       pdfrx_corpus_generator --preset=all output-directory\n"
+                    "see the comment at the top of src/tools/corpus_generator.cpp for the options and presets\n");
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  Options options;
+  const char *output = nullptr;
+  bool all = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--preset=all") == 0)
+      all = true;
+    else if (strncmp(argv[i], "--", 2) != 0 && !output)
+      output = argv[i];
+    else if (!parseOption(argv[i], options))
+    {
+      fprintf(stderr, "invalid option: %s\n", argv[i]);
+      usage();
+      return 2;
+    }
+  }
+  if (!output)
+  {
+    usage();
+    return 2;
+  }
+  FPDF_InitLibrary();
+  // FPDF_CreateNewDocument writes /CreationDate from the clock unless the machine time access is denied
+  FPDF_SetSandBoxPolicy(FPDF_POLICY_MACHINETIME_ACCESS, false);
+  bool ok = true;
+  if (all)
+  {
+    // the options other than the presets are applied to every preset
+    for (const auto &preset : kPresets)
+    {
+      Options o;
+      preset.apply(o);
+      for (int i = 1; i < argc; i++)
+      {
+        if (strncmp(argv[i], "--", 2) == 0 && strcmp(argv[i], "--preset=all") != 0 && strncmp(argv[i], "--preset=", 9) != 0)
+          parseOption(argv[i], o);
+      }
+      const std::string path = std::string(output) + "/" + preset.name + ".pdf";
+      ok = generate(o, path.c_str()) && ok;
+    }
+  }
+  else
+  {
+    ok = generate(options, output);
+  }
+  FPDF_DestroyLibrary();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+// Concurrency stress and fault-injection harness for the pdfrx_file_access layer.
+//
+// The harness emulates many documents being loaded concurrently: every document has its own "PDFium thread"
+// that issues block reads through FPDF_FILEACCESS::m_GetBlock and a shared pool of "Dart side" reader threads
+// completes the reads asynchronously with random delays, errors, lost completions (a callback that never
+// returns) and late completions (after the timeout), while another thread cancels some of the documents in the
+// middle of loading. Every successful read is verified against the expected content and the harness reports
+// throughput and latency percentiles.
+//
+// The harness is intended to be built with ThreadSanitizer (see PDFRX_BUILD_TOOLS in ../CMakeLists.txt):
+//
+//   pdfrx_file_access_stress [documents] [reads-per-document] [reader-threads] [timeout-ms]
+#include "../pdfium_interop.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const unsigned long kFileSize = 64 * 1024 * 1024;
+  const unsigned long kMaxBlockSize = 256 * 1024;
+
+  unsigned char expectedByte(size_t position)
+  {
+    return static_cast<unsigned char>((position * 2654435761u) >> 24);
+  }
+
+  struct Job
+  {
+    pdfrx_file_access *fileAccess;
+    size_t position;
+    unsigned char *buffer;
+    size_t size;
+    uint64_t requestId;
+  };
+
+  // Emulates the Dart side; reads are completed asynchronously on a thread pool.
+  class ReaderPool
+  {
+  public:
+    ReaderPool(int threadCount, unsigned int timeoutMs) : timeoutMs_(timeoutMs)
+    {
+      for (int i = 0; i < threadCount; i++)
+        threads_.emplace_back([this, i]
+                              { run(i); });
+    }
+
+    ~ReaderPool()
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+      }
+      cond_.notify_all();
+      for (auto &t : threads_)
+        t.join();
+    }
+
+    void post(const Job &job)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobs_.push_back(job);
+      }
+      cond_.notify_one();
+    }
+
+    static void INTEROP_API readBlock(void *param, size_t position, unsigned char *pBuf, size_t size, uint64_t requestId);
+
+    // Jobs are processed in order; once the queue is empty, no reader touches any buffer.
+    void drain()
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      idle_.wait(lock, [this]
+                 { return jobs_.empty() && busy_ == 0; });
+    }
+
+    std::atomic<uint64_t> injectedErrors{0};
+    std::atomic<uint64_t> injectedLost{0};
+    std::atomic<uint64_t> injectedLate{0};
+
+  private:
+    void run(int index)
+    {
+      std::mt19937 random(static_cast<unsigned int>(index) * 7919u + 1);
+      for (;;)
+      {
+        Job job;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          cond_.wait(lock, [this]
+                     { return stopping_ || !jobs_.empty(); });
+          if (jobs_.empty())
+            return;
+          job = jobs_.front();
+          jobs_.pop_front();
+          busy_++;
+        }
+        process(job, random);
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          busy_--;
+        }
+        idle_.notify_all();
+      }
+    }
+
+    void process(const Job &job, std::mt19937 &random)
+    {
+      const int dice = random() % 1000;
+      if (dice < 5 && timeoutMs_ != 0)
+      {
+        // the callback never completes; the native side should time out
+        injectedLost++;
+        return;
+      }
+      if (dice < 10 && timeoutMs_ != 0)
+      {
+        // completes after the native side gave up
+        injectedLate++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs_ + 10));
+      }
+      else
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(random() % 500));
+      }
+      if (dice >= 10 && dice < 30)
+      {
+        injectedErrors++;
+        pdfrx_file_access_set_value(job.fileAccess, job.requestId, -1);
+        return;
+      }
+      const size_t available = job.position < kFileSize ? kFileSize - job.position : 0;
+      const size_t size = std::min(job.size, available);
+      for (size_t i = 0; i < size; i++)
+        job.buffer[i] = expectedByte(job.position + i);
+      pdfrx_file_access_set_value(job.fileAccess, job.requestId, static_cast<int>(size));
+    }
+
+    unsigned int timeoutMs_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::condition_variable idle_;
+    std::deque<Job> jobs_;
+    int busy_ = 0;
+    bool stopping_ = false;
+  };
+
+  struct Document
+  {
+    ReaderPool *pool;
+    pdfrx_file_access *fileAccess;
+  };
+
+  void INTEROP_API ReaderPool::readBlock(void *param, size_t position, unsigned char *pBuf, size_t size, uint64_t requestId)
+  {
+    auto doc = reinterpret_cast<Document *>(param);
+    doc->pool->post(Job{doc->fileAccess, position, pBuf, size, requestId});
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  const int documentCount = argc > 1 ? atoi(argv[1]) : 32;
+  const int readsPerDocument = argc > 2 ? atoi(argv[2]) : 500;
+  const int readerThreads = argc > 3 ? atoi(argv[3]) : 8;
+  const unsigned int timeoutMs = argc > 4 ? static_cast<unsigned int>(atoi(argv[4])) : 50;
+
+  ReaderPool pool(readerThreads, timeoutMs);
+  std::vector<Document> docs(documentCount);
+  for (auto &doc : docs)
+  {
+    doc.pool = &pool;
+    doc.fileAccess = pdfrx_file_access_create(kFileSize, ReaderPool::readBlock, &doc, timeoutMs);
+  }
+
+  std::atomic<uint64_t> corrupted{0};
+  std::vector<std::vector<uint64_t>> latencies(documentCount);
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pdfiumThreads;
+  for (int d = 0; d < documentCount; d++)
+  {
+    pdfiumThreads.emplace_back([&, d]
+                               {
+      std::mt19937 random(static_cast<unsigned int>(d) + 1);
+      std::vector<unsigned char> buffer(kMaxBlockSize);
+      // FPDF_FILEACCESS is the first member of pdfrx_file_access (the Dart side relies on it as well)
+      auto fileAccess = reinterpret_cast<FPDF_FILEACCESS *>(docs[d].fileAccess);
+      for (int i = 0; i < readsPerDocument; i++)
+      {
+        const unsigned long size = 1 + random() % kMaxBlockSize;
+        const unsigned long position = random() % (kFileSize - size);
+        const auto t0 = std::chrono::steady_clock::now();
+        const int ok = fileAccess->m_GetBlock(fileAccess->m_Param, position, buffer.data(), size);
+        latencies[d].push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count()));
+        if (!ok)
+          continue;
+        for (unsigned long j = 0; j < size; j++)
+        {
+          if (buffer[j] != expectedByte(position + j))
+          {
+            corrupted++;
+            break;
+          }
+        }
+      } });
+  }
+  // cancel every 4th document at random timings like a user navigating away
+  std::thread canceller([&]
+                        {
+    std::mt19937 random(12345);
+    for (int d = 3; d < documentCount; d += 4)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(random() % 20));
+      pdfrx_file_access_cancel(docs[d].fileAccess);
+    } });
+  canceller.join();
+  for (auto &t : pdfiumThreads)
+    t.join();
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // The Dart side never destroys a file access while a read is running; emulate it.
+  pool.drain();
+
+  pdfrx_file_access_stats total = {};
+  for (auto &doc : docs)
+  {
+    pdfrx_file_access_stats stats;
+    pdfrx_file_access_get_stats(doc.fileAccess, &stats);
+    total.readCount += stats.readCount;
+    total.readBytes += stats.readBytes;
+    total.failedCount += stats.failedCount;
+    total.timeoutCount += stats.timeoutCount;
+    total.canceledCount += stats.canceledCount;
+    total.totalWaitMicroseconds += stats.totalWaitMicroseconds;
+    total.maxWaitMicroseconds = std::max(total.maxWaitMicroseconds, stats.maxWaitMicroseconds);
+    pdfrx_file_access_destroy(doc.fileAccess);
+  }
+
+  std::vector<uint64_t> all;
+  for (auto &l : latencies)
+    all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double p)
+  { return all.empty() ? 0 : all[std::min(all.size() - 1, static_cast<size_t>(all.size() * p))]; };
+
+  printf("documents=%d reads=%llu reader-threads=%d timeout=%ums\n", documentCount, (unsigned long long)total.readCount, readerThreads, timeoutMs);
+  printf("throughput: %.0f reads/s, %.1f MB/s\n", total.readCount / elapsed, total.readBytes / elapsed / (1024 * 1024));
+  printf("latency(us): p50=%llu p90=%llu p99=%llu p99.9=%llu max=%llu\n",
+         (unsigned long long)percentile(0.5), (unsigned long long)percentile(0.9), (unsigned long long)percentile(0.99),
+         (unsigned long long)percentile(0.999), (unsigned long long)(all.empty() ? 0 : all.back()));
+  printf("failed=%llu timeouts=%llu canceled=%llu (injected: errors=%llu lost=%llu late=%llu) corrupted=%llu\n",
+         (unsigned long long)total.failedCount, (unsigned long long)total.timeoutCount, (unsigned long long)total.canceledCount,
+         (unsigned long long)pool.injectedErrors.load(), (unsigned long long)pool.injectedLost.load(),
+         (unsigned long long)pool.injectedLate.load(), (unsigned long long)corrupted.load());
+  return corrupted == 0 ? 0 : 1;
+}